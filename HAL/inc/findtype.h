@@ -30,4 +30,15 @@
 //
 //----------------------------------------------------------------------
 
+// result bucket of a family for FindFamilies
+typedef struct
+{
+   uchar    family;          // family code
+   uchar    (*FamilySN)[8];  // serial numbers found
+   int      max;             // bucket size
+   int      num;             // number of serial numbers stored
+   int      overflow;        // devices found that did not fit
+} FamilyBucket;
+
 SMALLINT FindDevices(int,uchar FamilySN[][8],SMALLINT,int);
+int      FindFamilies(int,FamilyBucket *,int);
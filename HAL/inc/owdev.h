@@ -0,0 +1,96 @@
+//////////////////////////////////////////////////////////////////////////////
+//                                                                          //
+//  Minimalistic 1-wire (onewire) master with Avalon MM bus interface       //
+//                                                                          //
+//  Copyright (C) 2010  Iztok Jeras                                         //
+//                                                                          //
+//////////////////////////////////////////////////////////////////////////////
+//                                                                          //
+//  This program is free software: you can redistribute it and/or modify    //
+//  it under the terms of the GNU Lesser General Public License             //
+//  as published by the Free Software Foundation, either                    //
+//  version 3 of the License, or (at your option) any later version.        //
+//                                                                          //
+//  This program is distributed in the hope that it will be useful,         //
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of          //
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the           //
+//  GNU General Public License for more details.                            //
+//                                                                          //
+//  You should have received a copy of the GNU General Public License       //
+//  along with this program.  If not, see <http://www.gnu.org/licenses/>.   //
+//                                                                          //
+//////////////////////////////////////////////////////////////////////////////
+
+
+
+//////////////////////////////////////////////////////////////////////////////
+//                                                                          //
+// Device registry: a hash index from the 64 bit ROM number to a compact    //
+// record per device, so applications can look up, select and keep health   //
+// statistics of devices in constant time instead of scanning ROM arrays.   //
+//                                                                          //
+// An attached registry is kept up to date by the network layer, devices    //
+// found by any search are added, accesses update the presence, the last    //
+// seen time and the error counts of known devices.                         //
+//                                                                          //
+// Registry operations are short critical sections (interrupts disabled),   //
+// so tasks searching or accessing devices on any port can share an         //
+// attached registry. Record pointers stay valid until any record is        //
+// removed, a removal moves the last record into the freed one.             //
+//                                                                          //
+//////////////////////////////////////////////////////////////////////////////
+
+#ifndef OWDEV_H
+#define OWDEV_H
+
+#include "ownet.h"
+
+// power mode of a device
+#define OWDEV_POWER_UNKNOWN    0
+#define OWDEV_POWER_EXTERNAL   1
+#define OWDEV_POWER_PARASITE   2
+
+// network layer events
+#define OWDEV_FOUND            0  // found by a search
+#define OWDEV_ACCESS           1  // selected by a match ROM
+#define OWDEV_OVERDRIVE        2  // selected by an overdrive match ROM
+#define OWDEV_FAILED           3  // match ROM failed
+
+// device record
+typedef struct
+{
+   uchar    rom[8];
+   uchar    portnum;
+   uchar    family;
+   uchar    speed;          // MODE_OVERDRIVE if overdrive match ROM worked
+   uchar    power;          // OWDEV_POWER_*
+   uchar    config;         // thermometer configuration register, 0 unknown
+   SMALLINT present;        // last search or access found the device
+   long     seen;           // msGettick() of the last search or access
+   long     value;          // last value, defined by the application
+   ushort   accesses;       // successful accesses (wraps)
+   ushort   errors;         // failed accesses (saturates)
+} owDev;
+
+// registry, the record pool and the hash index are provided by the caller
+typedef struct
+{
+   owDev    *dev;           // record pool, records [0,num) are used
+   int      num;            // number of records
+   int      max;            // pool size
+   int      *hash;          // index of records, -1 for an empty slot
+   int      mask;           // hash index size - 1
+   int      overflow;       // devices not added, the pool was full
+} owDevRegistry;
+
+SMALLINT owDevInit(owDevRegistry *reg, owDev *dev, int max, int *hash, int size);
+void     owDevAttach(owDevRegistry *reg);
+owDev   *owDevLookup(const uchar *rom);
+owDev   *owDevFind(owDevRegistry *reg, const uchar *rom);
+owDev   *owDevAdd(owDevRegistry *reg, int portnum, const uchar *rom);
+SMALLINT owDevRemove(owDevRegistry *reg, const uchar *rom);
+SMALLINT owDevAccess(owDev *dev);
+void     owDevNotify(int portnum, const uchar *rom, SMALLINT event);
+ushort   owDevAdded(int portnum);
+
+#endif //OWDEV_H
@@ -0,0 +1,74 @@
+//////////////////////////////////////////////////////////////////////////////
+//                                                                          //
+//  Minimalistic 1-wire (onewire) master with Avalon MM bus interface       //
+//                                                                          //
+//  Copyright (C) 2010  Iztok Jeras                                         //
+//                                                                          //
+//////////////////////////////////////////////////////////////////////////////
+//                                                                          //
+//  This program is free software: you can redistribute it and/or modify    //
+//  it under the terms of the GNU Lesser General Public License             //
+//  as published by the Free Software Foundation, either                    //
+//  version 3 of the License, or (at your option) any later version.        //
+//                                                                          //
+//  This program is distributed in the hope that it will be useful,         //
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of          //
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the           //
+//  GNU General Public License for more details.                            //
+//                                                                          //
+//  You should have received a copy of the GNU General Public License       //
+//  along with this program.  If not, see <http://www.gnu.org/licenses/>.   //
+//                                                                          //
+//////////////////////////////////////////////////////////////////////////////
+
+
+
+//////////////////////////////////////////////////////////////////////////////
+//                                                                          //
+// Incremental enumeration: keeps the ROM numbers found on a port, sorted   //
+// in search order, and checks them with directed walks instead of a full   //
+// search. Only subtrees where the bus differs from the table are searched  //
+// again, changes are returned as a list of added and removed devices.      //
+//                                                                          //
+// The tables of several ports can be saved as a snapshot and restored at   //
+// startup through a storage callback, the restored devices can be used    //
+// right away while owEnumUpdate verifies them.                             //
+//                                                                          //
+//////////////////////////////////////////////////////////////////////////////
+
+#ifndef OWENUM_H
+#define OWENUM_H
+
+#include "ownet.h"
+
+// enumerator state, the ROM table is provided by the caller
+typedef struct
+{
+   int      portnum;
+   uchar    (*rom)[8];      // known devices, in search order
+   int      num;            // number of known devices
+   int      max;            // table size
+   long     round;          // update counter, selects the walked half
+   int      overflow;       // devices not stored, the table was full
+} owEnum;
+
+// change list entry
+typedef struct
+{
+   uchar    rom[8];
+   SMALLINT added;          // TRUE (1) added, FALSE (0) removed
+} owEnumDelta;
+
+// owEnumUpdate return value, another search context runs a pass on the port
+#define OWENUM_BUSY     (-1)
+
+// snapshot storage callback, reads (do_write FALSE) or writes the next
+// 'len' bytes of the snapshot, returns the number of bytes transferred
+typedef int (*owEnumStore)(void *ctx, SMALLINT do_write, uchar *buf, int len);
+
+void     owEnumInit(owEnum *en, int portnum, uchar rom[][8], int max);
+int      owEnumUpdate(owEnum *en, owEnumDelta *delta, int max_delta);
+SMALLINT owEnumSave(owEnum *en, int n, owEnumStore store, void *ctx);
+SMALLINT owEnumRestore(owEnum *en, int n, owEnumStore store, void *ctx);
+
+#endif //OWENUM_H
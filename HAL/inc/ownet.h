@@ -306,7 +306,41 @@ extern int owHasErrors(void);
 #define OWERROR_LIBUSB_SET_ALTINTERFACE_ERROR   123
 #define OWERROR_LIBUSB_NO_ADAPTER_FOUND         124
 
+// search context, owned by the caller, one search pass (reset, search
+// command and 64 bit triplets) is advanced a step at a time by owSearchStep
+typedef struct
+{
+   // search parameters
+   int      portnum;
+   SMALLINT do_reset;
+   SMALLINT alarm_only;
+   // search state between passes (AN187)
+   SMALLINT LastDiscrepancy;
+   SMALLINT LastFamilyDiscrepancy;
+   SMALLINT LastDevice;
+   uchar    SerialNum[8];
+   // position within the running pass
+   SMALLINT state;
+   uchar    bit_number;
+   uchar    last_zero;
+   uchar    serial_byte_number;
+   uchar    serial_byte_mask;
+   uchar    crc8;
+} owSearchContext;
+
+// owSearchStep return values
+#define OWSEARCH_MORE                  0  // step done, the pass continues
+#define OWSEARCH_FOUND                 1  // device found, its ROM is in SerialNum
+#define OWSEARCH_END                   2  // no (more) devices
+#define OWSEARCH_BUSY                  3  // another context runs a pass on the port
+
 // One Wire functions defined in ownetu.c
+void      owSearchInit(owSearchContext *ctx, int portnum, SMALLINT do_reset, SMALLINT alarm_only);
+SMALLINT  owSearchStep(owSearchContext *ctx);
+void      owSearchAbort(owSearchContext *ctx);
+SMALLINT  owSearchBusy(int portnum);
+void      owSearchFamily(owSearchContext *ctx, SMALLINT search_family);
+void      owSearchSkipFamily(owSearchContext *ctx);
 SMALLINT  owFirst(int portnum, SMALLINT do_reset, SMALLINT alarm_only);
 SMALLINT  owNext(int portnum, SMALLINT do_reset, SMALLINT alarm_only);
 void      owSerialNum(int portnum, uchar *serialnum_buf, SMALLINT do_read);
@@ -353,8 +387,13 @@ SMALLINT owProgramByte(int portnum, SMALLINT write_byte, int addr, SMALLINT writ
 
 // link functions
 void      msDelay(int len);
+void      owDelay(int portnum, int len);
 long      msGettick(void);
 
+// transaction lock functions defined in owlnk.c
+void      owLock(int portnum);
+void      owUnlock(int portnum);
+
 // ioutil.c functions prototypes
 int  EnterString(char *msg, char *buf, int min, int max);
 int  EnterNum(char *msg, int numchars, long *value, long min, long max);
@@ -373,5 +412,19 @@ void setcrc16(int portnum, ushort reset);
 ushort docrc16(int portnum, ushort cdata);
 void setcrc8(int portnum, uchar reset);
 uchar docrc8(int portnum, uchar x);
+uchar docrc8_r(uchar *crc8, uchar x);
+
+// inline link layer (SOCKIT_OWM_INLINE BSP setting), the out of line
+// functions in owlnk.c remain available
+#if defined(SOCKIT_OWM_INLINE) && !defined(SOCKIT_OWM_LNK_C)
+#include "sockit_owm_lnk.h"
+#define owTouchReset(portnum)           sockit_owm_touch_reset(portnum)
+#define owTouchBit(portnum,sendbit)     sockit_owm_touch_bit(portnum,sendbit)
+#define owTouchByte(portnum,sendbyte)   sockit_owm_touch_byte(portnum,sendbyte)
+#define owWriteByte(portnum,sendbyte)   sockit_owm_write_byte(portnum,sendbyte)
+#define owReadByte(portnum)             sockit_owm_read_byte(portnum)
+#define owLock(portnum)                 sockit_owm_lock(portnum)
+#define owUnlock(portnum)               sockit_owm_unlock(portnum)
+#endif
 
 #endif //OWNET_H
@@ -0,0 +1,88 @@
+//////////////////////////////////////////////////////////////////////////////
+//                                                                          //
+//  Minimalistic 1-wire (onewire) master with Avalon MM bus interface       //
+//                                                                          //
+//  Copyright (C) 2010  Iztok Jeras                                         //
+//                                                                          //
+//////////////////////////////////////////////////////////////////////////////
+//                                                                          //
+//  This program is free software: you can redistribute it and/or modify    //
+//  it under the terms of the GNU Lesser General Public License             //
+//  as published by the Free Software Foundation, either                    //
+//  version 3 of the License, or (at your option) any later version.        //
+//                                                                          //
+//  This program is distributed in the hope that it will be useful,         //
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of          //
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the           //
+//  GNU General Public License for more details.                            //
+//                                                                          //
+//  You should have received a copy of the GNU General Public License       //
+//  along with this program.  If not, see <http://www.gnu.org/licenses/>.   //
+//                                                                          //
+//////////////////////////////////////////////////////////////////////////////
+
+
+
+//////////////////////////////////////////////////////////////////////////////
+//                                                                          //
+// Batch temperature read for the DS18S20 (0x10), DS18B20 (0x28) and        //
+// DS28EA00 (0x42) thermometers: a single Skip ROM + Convert T on each      //
+// port of the list, one wait for the conversion, then a Match ROM + Read   //
+// Scratchpad for each listed device.                                       //
+//                                                                          //
+// The configuration (alarm thresholds and resolution) can be written to    //
+// the scratchpad, copied to and recalled from EEPROM.  The helpers for the //
+// conversion wait are shared with the single device readers in temp10.c,   //
+// temp28.c and temp42.c, the wait follows the configured resolution.       //
+//                                                                          //
+// The power mode does not change at runtime, it is probed for a whole port //
+// at discovery time (TempProbePower) or queried once per device and kept   //
+// in the attached device registry, or in a small cache without a registry. //
+// A search adding a device to a port drops the port probe result.          //
+//                                                                          //
+//////////////////////////////////////////////////////////////////////////////
+
+#ifndef OWTEMP_H
+#define OWTEMP_H
+
+#include "ownet.h"
+#include "owdev.h"
+
+// worst case conversion time (12 bit resolution)
+#define TEMP_CONVERT_MS   750
+
+// copy scratchpad (EEPROM write) time
+#define TEMP_COPY_MS      10
+
+// power mode and configuration cache entries (a power of two), used while
+// no device registry is attached
+#define TEMP_CACHE_SIZE   16
+
+// conversion complete poll interval in ms, set by the BSP
+#ifndef SOCKIT_OWM_TEMP_POLL
+#define SOCKIT_OWM_TEMP_POLL   10
+#endif
+
+// batch read list entry
+typedef struct
+{
+   int      portnum;
+   uchar    *SerialNum;
+   int      Temp;           // temperature in 1/16 Celsius, if 'ok'
+   SMALLINT ok;             // TRUE (1) the temperature was read and verified
+} TempReading;
+
+SMALLINT TempProbePower(int portnum);
+SMALLINT TempPowerMode(int portnum, uchar *SerialNum);
+int      TempDecode(uchar family, uchar *sp);
+SMALLINT TempReadScratchpad(int portnum, uchar *SerialNum, uchar *sp);
+int      TempConvertTime(uchar family, uchar config);
+int      TempDeviceConvertTime(int portnum, uchar *SerialNum);
+SMALLINT TempConvertWait(int portnum, SMALLINT parasite, int ms);
+int      ReadTemperatures(TempReading *rd, int num);
+SMALLINT TempWriteConfig(int portnum, uchar *SerialNum, int th, int tl, int bits);
+SMALLINT TempReadConfig(int portnum, uchar *SerialNum, int *th, int *tl, int *bits);
+SMALLINT TempCopyConfig(int portnum, uchar *SerialNum);
+SMALLINT TempRecallConfig(int portnum, uchar *SerialNum);
+
+#endif //OWTEMP_H
@@ -49,16 +49,50 @@ extern "C"
 {
 #endif // __cplusplus
 
+// maximum number of onewire ports per instance (width of the SEL field)
+#define SOCKIT_OWM_OWN_MAX 16
+
+// nominal cycle durations [us] (same for all base time period options)
+#define SOCKIT_OWM_T_BIT_N   65     // data bit, normal    mode
+#define SOCKIT_OWM_T_BIT_O    8     // data bit, overdrive mode
+#define SOCKIT_OWM_T_RST_N  960     // reset,    normal    mode
+#define SOCKIT_OWM_T_RST_O   96     // reset,    overdrive mode
+#define SOCKIT_OWM_T_DLY   1000     // delay
+
+// default spin threshold [us], cycles up to this duration are waited for by
+// polling CYC, longer cycles block on the interrupt
+#ifndef SOCKIT_OWM_SPIN
+#define SOCKIT_OWM_SPIN     100
+#endif
+
 //////////////////////////////////////////////////////////////////////////////
-// global structure containing the current state of the sockit_owm driver
+// wait statistics
+//////////////////////////////////////////////////////////////////////////////
+
+typedef struct sockit_owm_wst_s
+{
+  alt_u32          spin;            // cycles waited for by polling CYC
+  alt_u32          block;           // cycles waited for by the interrupt
+  alt_u32          reads;           // CTL reads while polling
+  alt_u32          max;             // maximum CTL reads for a single cycle
+} sockit_owm_wst;
+
+// asynchronous transaction descriptor (see sockit_owm_async.h)
+struct sockit_owm_txn_s;
+
+//////////////////////////////////////////////////////////////////////////////
+// structure containing the current state of a sockit_owm driver instance
 //////////////////////////////////////////////////////////////////////////////
 
 typedef struct sockit_owm_state_s
 {
   void*            base;            // The base address of the device
+  const char*      name;            // The device name (used by owAcquire)
   // constants
   alt_u32          ovd_e;           // Overdrive mode               implementation enable
   alt_u32          cdr_e;           // Clock divider ratio register implementation enable
+  alt_u32          prg_e;           // Program engine               implementation enable
+  alt_u32          paw;             // Program engine memory address width
   alt_u32          own;             // Number of onewire ports
   char             btp_n[3];        // base time period for normal    mode
   char             btp_o[3];        // base time period for overdrive mode
@@ -71,34 +105,104 @@ typedef struct sockit_owm_state_s
   alt_u32          use;             // Aquire status
   alt_u32          ovd;             // Overdrive status
   alt_u32          pwr;             // Power status
+  alt_u32          ctl [SOCKIT_OWM_OWN_MAX];  // cached control word, data cycle (per port)
+  alt_u32          rst [SOCKIT_OWM_OWN_MAX];  // cached control word, reset cycle (per port)
+  alt_u32          dly;             // cached control word, delay cycle
+  // hybrid wait
+  alt_u32          spn;             // spin threshold [us]
+  sockit_owm_wst   wst;             // wait statistics
+  // transaction lock (per port)
+  alt_u32          lck [SOCKIT_OWM_OWN_MAX];  // lock nesting depth
+  void*            tsk [SOCKIT_OWM_OWN_MAX];  // lock owner task
+  // asynchronous transaction queue
+  struct sockit_owm_txn_s* aqh;     // queue head (running transaction)
+  struct sockit_owm_txn_s* aqt;     // queue tail
+  alt_u32          aqn;             // number of queued transactions
+  alt_u32          aq  [SOCKIT_OWM_OWN_MAX];  // number of queued transactions (per port)
   // OS multitasking features
-  ALT_FLAG_GRP    (irq)             // interrupt event flag
-  ALT_SEM         (cyc)             // transfer lock semaphore
+  ALT_FLAG_GRP    (irq)             // interrupt event flag, a bit per port
+  ALT_FLAG_GRP    (evt)             // asynchronous transaction completion event
+  ALT_SEM         (cyc)             // controller lock semaphore (one cycle)
+  ALT_SEM         (trn [SOCKIT_OWM_OWN_MAX])  // transaction lock semaphore (per port)
+  // list of registered instances
+  struct sockit_owm_state_s* next;
 } sockit_owm_state;
 
+//////////////////////////////////////////////////////////////////////////////
+// 1-wire port map, binds the Dallas kit 'portnum' to an instance and a port
+// select (SEL) within that instance, ports of registered instances are
+// mapped in order by default, owAcquire can bind a port by instance name
+//////////////////////////////////////////////////////////////////////////////
+
+typedef struct sockit_owm_port_s
+{
+  sockit_owm_state* owm;            // driver instance
+  alt_u32           sel;            // port select within the instance
+} sockit_owm_port;
+
+extern sockit_owm_port sockit_owm_map [];
+
+// a single instance with a single port (SOCKIT_OWM_SINGLE) resolves the
+// port map and the port count at compile time
+#ifdef SOCKIT_OWM_SINGLE
+#define SOCKIT_OWM(portnum)     (sockit_owm_map[0].owm)
+#define SOCKIT_OWM_SEL(portnum) (0)
+#define SOCKIT_OWM_PORTS(owm)     (1)
+#else
+#define SOCKIT_OWM(portnum)     (sockit_owm_map[portnum].owm)
+#define SOCKIT_OWM_SEL(portnum) (sockit_owm_map[portnum].sel)
+#define SOCKIT_OWM_PORTS(owm)     ((owm)->own)
+#endif
+
+// update the cached control words, must be called after a change of the
+// interrupt enable, overdrive, power status or spin threshold
+extern void sockit_owm_ctl (sockit_owm_state *sp);
+
+// set the spin threshold [us] of the instance 'portnum' is mapped to
+// (a negative value only reads it), returns the previous threshold
+extern int sockit_owm_spin (int portnum, int us);
+
+// copy (and optionally clear) the wait statistics of the instance
+extern void sockit_owm_wait_stats (int portnum, sockit_owm_wst *wst, int clear);
+
+// bind 'portnum' to the instance and port named by 'port_zstr'
+// ("name" or "name:sel", NULL keeps the default map), returns 0 on success
+extern int sockit_owm_bind (int portnum, const char *port_zstr);
+
+//////////////////////////////////////////////////////////////////////////////
+// current task, used to allow nested transaction locks (owLock/owUnlock)
+//////////////////////////////////////////////////////////////////////////////
+
+#ifdef UCOS_II
+#define SOCKIT_OWM_TASK ((void*) OSTCBCur)
+#else
+#define SOCKIT_OWM_TASK ((void*) 0)
+#endif
+
 //////////////////////////////////////////////////////////////////////////////
 // instantiation macro
-// can be used oly once, since the driver is based on global variables
 //////////////////////////////////////////////////////////////////////////////
 
 #define SOCKIT_OWM_INSTANCE(name, state) \
-  sockit_owm_state sockit_owm = { (void*) name##_BASE,  \
-                                          name##_OVD_E, \
-                                          name##_CDR_E, \
-                                          name##_OWN,   \
-                                          name##_BTP_N, \
-                                          name##_BTP_O, \
-                                          name##_CDR_N, \
-                                          name##_CDR_O, \
-                                          name##_F_DLY, \
-                                          0, 0, 0, 0};  \
-  void* state = (void*) name##_BASE
+  sockit_owm_state state = { (void*) name##_BASE,  \
+                                     name##_NAME,  \
+                                     name##_OVD_E, \
+                                     name##_CDR_E, \
+                                     name##_PRG_E, \
+                                     name##_PAW,   \
+                                     name##_OWN,   \
+                                     name##_BTP_N, \
+                                     name##_BTP_O, \
+                                     name##_CDR_N, \
+                                     name##_CDR_O, \
+                                     name##_F_DLY, \
+                                     0, 0, 0, 0}
 
 //////////////////////////////////////////////////////////////////////////////
-// initialization function, registers the interrupt handler
+// initialization function, registers the instance and the interrupt handler
 //////////////////////////////////////////////////////////////////////////////
 
-extern void sockit_owm_init(alt_u32 irq);
+extern void sockit_owm_init(sockit_owm_state* sp, alt_u32 irq_controller_id, alt_u32 irq);
 
 //////////////////////////////////////////////////////////////////////////////
 // initialization macro
@@ -119,10 +223,12 @@ extern void sockit_owm_init(alt_u32 irq);
   }                                                                        \
   else                                                                     \
   {                                                                        \
-    sockit_owm_init(name##_IRQ);                                           \
+    sockit_owm_init(&state, name##_IRQ_INTERRUPT_CONTROLLER_ID,            \
+                            name##_IRQ);                                   \
   }
 #else
-#define SOCKIT_OWM_INIT(name, state)
+#define SOCKIT_OWM_INIT(name, state)                                       \
+  sockit_owm_init(&state, 0, ALT_IRQ_NOT_CONNECTED)
 #endif
 
 #ifdef __cplusplus
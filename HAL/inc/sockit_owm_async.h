@@ -0,0 +1,112 @@
+//////////////////////////////////////////////////////////////////////////////
+//                                                                          //
+//  Minimalistic 1-wire (onewire) master with Avalon MM bus interface       //
+//                                                                          //
+//  Copyright (C) 2010  Iztok Jeras                                         //
+//                                                                          //
+//////////////////////////////////////////////////////////////////////////////
+//                                                                          //
+//  This program is free software: you can redistribute it and/or modify    //
+//  it under the terms of the GNU Lesser General Public License             //
+//  as published by the Free Software Foundation, either                    //
+//  version 3 of the License, or (at your option) any later version.        //
+//                                                                          //
+//  This program is distributed in the hope that it will be useful,         //
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of          //
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the           //
+//  GNU General Public License for more details.                            //
+//                                                                          //
+//  You should have received a copy of the GNU General Public License       //
+//  along with this program.  If not, see <http://www.gnu.org/licenses/>.   //
+//                                                                          //
+//////////////////////////////////////////////////////////////////////////////
+
+
+
+//////////////////////////////////////////////////////////////////////////////
+//                                                                          //
+// Asynchronous transactions: a descriptor (ROM, command bytes, delay with  //
+// optional strong pull-up, read length) is queued per controller and       //
+// advanced cycle by cycle from the interrupt handler, completion is        //
+// reported by a callback and an OS event. The polling driver advances the  //
+// queue from sockit_owm_async_poll (also called by sockit_owm_async_wait). //
+//                                                                          //
+// The engine holds the transaction lock of a port while transactions for   //
+// that port are queued and, on controllers with more than one port, the    //
+// controller lock while any transaction is queued, so blocking calls wait  //
+// for the queue to drain. Without an OS the locks do not block, there the  //
+// blocking calls drain the queue (sockit_owm_async_drain) themselves.      //
+//                                                                          //
+//////////////////////////////////////////////////////////////////////////////
+
+#ifndef __SOCKIT_OWM_ASYNC_H__
+#define __SOCKIT_OWM_ASYNC_H__
+
+#include "alt_types.h"
+#include "sockit_owm.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif // __cplusplus
+
+//////////////////////////////////////////////////////////////////////////////
+// transaction descriptor
+//////////////////////////////////////////////////////////////////////////////
+
+typedef struct sockit_owm_txn_s sockit_owm_txn;
+
+// completion callback, called from the interrupt handler (or from
+// sockit_owm_async_poll), it must not block or submit transactions
+typedef void (*sockit_owm_txn_cb) (sockit_owm_txn *txn);
+
+struct sockit_owm_txn_s
+{
+  // request (set by the caller)
+  int               portnum;        // 1-wire port
+  const alt_u8*     rom;            // match ROM number, NULL for skip ROM
+  const alt_u8*     cmd;            // command bytes written after the ROM command
+  int               cmd_n;          // number of command bytes
+  int               dly;            // delay after the command bytes [ms]
+  int               pwr;            // strong pull-up during the delay
+  alt_u8*           rd;             // read buffer
+  int               rd_n;           // number of bytes read after the delay
+  sockit_owm_txn_cb cb;             // completion callback (optional)
+  void*             arg;            // callback argument
+  // status, -EINPROGRESS while queued, 0 on success, -EIO without presence
+  volatile int      sts;
+  // engine state
+  alt_u32           sel;            // port select
+  int               stp;            // transaction phase
+  int               pos;            // byte (delay cycle) index within the phase
+  int               bit;            // bit index within the byte
+  sockit_owm_txn*   next;           // queue link
+};
+
+//////////////////////////////////////////////////////////////////////////////
+// queue control
+//////////////////////////////////////////////////////////////////////////////
+
+// queue a transaction, returns 0 or a negative error code (-EDEADLK if the
+// calling task holds the port lock), the descriptor and the buffers must
+// not be modified till the transaction completes
+extern int  sockit_owm_async_submit (sockit_owm_txn *txn);
+
+// advance the queue of the instance 'portnum' is mapped to if the current
+// cycle has ended, returns the number of queued transactions
+extern int  sockit_owm_async_poll (int portnum);
+
+// wait for the transaction to complete, returns its status
+extern int  sockit_owm_async_wait (sockit_owm_txn *txn);
+
+// advance the queue of the instance till all transactions complete
+extern void sockit_owm_async_drain (sockit_owm_state *sp);
+
+// cycle end handler, called by the driver interrupt handler
+extern void sockit_owm_async_irq (sockit_owm_state *sp, alt_u32 ctl);
+
+#ifdef __cplusplus
+}
+#endif // __cplusplus
+
+#endif // __SOCKIT_OWM_ASYNC_H__
@@ -0,0 +1,218 @@
+//////////////////////////////////////////////////////////////////////////////
+//                                                                          //
+//  Minimalistic 1-wire (onewire) master with Avalon MM bus interface       //
+//                                                                          //
+//  Copyright (C) 2010  Iztok Jeras                                         //
+//                                                                          //
+//////////////////////////////////////////////////////////////////////////////
+//                                                                          //
+//  This program is free software: you can redistribute it and/or modify    //
+//  it under the terms of the GNU Lesser General Public License             //
+//  as published by the Free Software Foundation, either                    //
+//  version 3 of the License, or (at your option) any later version.        //
+//                                                                          //
+//  This program is distributed in the hope that it will be useful,         //
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of          //
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the           //
+//  GNU General Public License for more details.                            //
+//                                                                          //
+//  You should have received a copy of the GNU General Public License       //
+//  along with this program.  If not, see <http://www.gnu.org/licenses/>.   //
+//                                                                          //
+//////////////////////////////////////////////////////////////////////////////
+
+
+
+
+//////////////////////////////////////////////////////////////////////////////
+//                                                                          //
+// Link layer primitives as static inline functions, the out of line link   //
+// layer in owlnk.c is built from them. With the SOCKIT_OWM_INLINE BSP      //
+// setting ownet.h maps owTouchReset, owTouchBit, owTouchByte, owReadByte,  //
+// owWriteByte, owLock and owUnlock to these functions, so the network and  //
+// device layers inline the register sequences.                             //
+//                                                                          //
+//////////////////////////////////////////////////////////////////////////////
+
+#ifndef __SOCKIT_OWM_LNK_H__
+#define __SOCKIT_OWM_LNK_H__
+
+#include "alt_types.h"
+#include "sockit_owm_regs.h"
+#include "sockit_owm.h"
+#include "sockit_owm_async.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif // __cplusplus
+
+//////////////////////////////////////////////////////////////////////////////
+// transaction lock (per port, nested by the owner task)
+//////////////////////////////////////////////////////////////////////////////
+
+static ALT_INLINE void ALT_ALWAYS_INLINE sockit_owm_lock (int portnum)
+{
+  sockit_owm_state *owm = SOCKIT_OWM(portnum);
+  int sel = SOCKIT_OWM_SEL(portnum);
+
+#ifndef UCOS_II
+  // without an OS the semaphore does not block, wait for the queued
+  // asynchronous transactions to release the port
+  if (owm->aq[sel])  sockit_owm_async_drain (owm);
+#endif
+  // nested lock by the owner
+  if (owm->lck[sel] && (owm->tsk[sel] == SOCKIT_OWM_TASK)) {
+    owm->lck[sel]++;
+    return;
+  }
+  ALT_SEM_PEND (owm->trn[sel], 0);
+  owm->tsk[sel] = SOCKIT_OWM_TASK;
+  owm->lck[sel] = 1;
+}
+
+static ALT_INLINE void ALT_ALWAYS_INLINE sockit_owm_unlock (int portnum)
+{
+  sockit_owm_state *owm = SOCKIT_OWM(portnum);
+  int sel = SOCKIT_OWM_SEL(portnum);
+
+  if (--owm->lck[sel] == 0)
+    ALT_SEM_POST (owm->trn[sel]);
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// controller lock (the control register is shared by all ports), on a
+// single port controller the transaction lock provides exclusive access
+//
+// Without an OS the semaphores do not block, so the asynchronous queue
+// (running on any port) is drained before the controller is used.
+//////////////////////////////////////////////////////////////////////////////
+
+static ALT_INLINE void ALT_ALWAYS_INLINE sockit_owm_cyc_lock (sockit_owm_state *owm)
+{
+#ifndef UCOS_II
+  if (owm->aqn)  sockit_owm_async_drain (owm);
+#endif
+  if (SOCKIT_OWM_PORTS(owm) > 1)
+    ALT_SEM_PEND (owm->cyc, 0);
+}
+
+static ALT_INLINE void ALT_ALWAYS_INLINE sockit_owm_cyc_unlock (sockit_owm_state *owm)
+{
+  if (SOCKIT_OWM_PORTS(owm) > 1)
+    ALT_SEM_POST (owm->cyc);
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// single 1-wire cycle on port 'sel', 'ctl' is a cached control word (with
+// the DAT bit added for data cycles), the caller must hold the transaction
+// and the controller lock, returns the control register
+//
+// Cycles started with the interrupt enabled (longer than the spin
+// threshold) block on the interrupt flag, other cycles are waited for by
+// polling CYC, since the OS wait would cost more than the cycle itself.
+//////////////////////////////////////////////////////////////////////////////
+
+static ALT_INLINE int ALT_ALWAYS_INLINE sockit_owm_cycle (sockit_owm_state *owm, int sel, alt_u32 ctl)
+{
+  alt_u32 reg, n = 0;
+
+  IOWR_SOCKIT_OWM_CTL (owm->base, ctl);
+
+#ifndef SOCKIT_OWM_POLLING
+  if (ctl & SOCKIT_OWM_CTL_IEN_MSK) {
+    // wait for irq to set the transfer end flag of this port
+    ALT_FLAG_PEND (owm->irq, 1 << sel, OS_FLAG_WAIT_SET_ANY + OS_FLAG_CONSUME, 0);
+    // wait for STX (end of transfer cycle) and read the cycle result
+    while ((reg = IORD_SOCKIT_OWM_CTL (owm->base)) & SOCKIT_OWM_CTL_CYC_MSK);
+    owm->wst.block++;
+    return reg;
+  }
+#endif
+  // spin till STX (end of transfer cycle) and read the cycle result
+  do {
+    reg = IORD_SOCKIT_OWM_CTL (owm->base);
+    n++;
+  } while (reg & SOCKIT_OWM_CTL_CYC_MSK);
+  owm->wst.spin++;
+  owm->wst.reads += n;
+  if (n > owm->wst.max)  owm->wst.max = n;
+
+  return reg;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// link layer primitives (same arguments and results as the owlnk.c API)
+//////////////////////////////////////////////////////////////////////////////
+
+// reset, returns presence detect
+static ALT_INLINE int ALT_ALWAYS_INLINE sockit_owm_touch_reset (int portnum)
+{
+  sockit_owm_state *owm = SOCKIT_OWM(portnum);
+  int sel = SOCKIT_OWM_SEL(portnum);
+  int reg;
+
+  sockit_owm_lock (portnum);
+  sockit_owm_cyc_lock (owm);
+  reg = sockit_owm_cycle (owm, sel, owm->rst[sel]);
+  sockit_owm_cyc_unlock (owm);
+  sockit_owm_unlock (portnum);
+
+  // negated DAT (presence detect)
+  return (~reg & SOCKIT_OWM_CTL_DAT_MSK);
+}
+
+// read/write a single bit
+static ALT_INLINE int ALT_ALWAYS_INLINE sockit_owm_touch_bit (int portnum, int sendbit)
+{
+  sockit_owm_state *owm = SOCKIT_OWM(portnum);
+  int sel = SOCKIT_OWM_SEL(portnum);
+  int reg;
+
+  sockit_owm_lock (portnum);
+  sockit_owm_cyc_lock (owm);
+  reg = sockit_owm_cycle (owm, sel, owm->ctl[sel] | (sendbit & SOCKIT_OWM_CTL_DAT_MSK));
+  sockit_owm_cyc_unlock (owm);
+  sockit_owm_unlock (portnum);
+
+  return (reg & SOCKIT_OWM_CTL_DAT_MSK);
+}
+
+// read/write a byte (LSB first), the controller is locked per byte
+static ALT_INLINE int ALT_ALWAYS_INLINE sockit_owm_touch_byte (int portnum, int sendbyte)
+{
+  sockit_owm_state *owm = SOCKIT_OWM(portnum);
+  int sel = SOCKIT_OWM_SEL(portnum);
+  alt_u32 ctl = owm->ctl[sel];
+  int i;
+  int dat = 0;
+
+  sockit_owm_lock (portnum);
+  sockit_owm_cyc_lock (owm);
+  for (i=0; i<8; i++) {
+    dat |= (sockit_owm_cycle (owm, sel, ctl | (sendbyte & SOCKIT_OWM_CTL_DAT_MSK)) & SOCKIT_OWM_CTL_DAT_MSK) << i;
+    sendbyte >>= 1;
+  }
+  sockit_owm_cyc_unlock (owm);
+  sockit_owm_unlock (portnum);
+
+  return dat;
+}
+
+// write a byte, returns 1 if the echo matches
+static ALT_INLINE int ALT_ALWAYS_INLINE sockit_owm_write_byte (int portnum, int sendbyte)
+{
+  return (sockit_owm_touch_byte (portnum, sendbyte) == sendbyte);
+}
+
+// read a byte
+static ALT_INLINE int ALT_ALWAYS_INLINE sockit_owm_read_byte (int portnum)
+{
+  return sockit_owm_touch_byte (portnum, 0xFF);
+}
+
+#ifdef __cplusplus
+}
+#endif // __cplusplus
+
+#endif // __SOCKIT_OWM_LNK_H__
@@ -0,0 +1,94 @@
+//////////////////////////////////////////////////////////////////////////////
+//                                                                          //
+//  Minimalistic 1-wire (onewire) master with Avalon MM bus interface       //
+//                                                                          //
+//  Copyright (C) 2010  Iztok Jeras                                         //
+//                                                                          //
+//////////////////////////////////////////////////////////////////////////////
+//                                                                          //
+//  This program is free software: you can redistribute it and/or modify    //
+//  it under the terms of the GNU Lesser General Public License             //
+//  as published by the Free Software Foundation, either                    //
+//  version 3 of the License, or (at your option) any later version.        //
+//                                                                          //
+//  This program is distributed in the hope that it will be useful,         //
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of          //
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the           //
+//  GNU General Public License for more details.                            //
+//                                                                          //
+//  You should have received a copy of the GNU General Public License       //
+//  along with this program.  If not, see <http://www.gnu.org/licenses/>.   //
+//                                                                          //
+//////////////////////////////////////////////////////////////////////////////
+
+
+
+//////////////////////////////////////////////////////////////////////////////
+//                                                                          //
+// Program engine support: a small assembler for building 1-wire programs   //
+// and a loader for transferring them into the controller memory.           //
+// The opcode set is described in hdl/sockit_owm.v.                         //
+//                                                                          //
+//////////////////////////////////////////////////////////////////////////////
+
+#ifndef __SOCKIT_OWM_PRG_H__
+#define __SOCKIT_OWM_PRG_H__
+
+#include "alt_types.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif // __cplusplus
+
+//////////////////////////////////////////////////////////////////////////////
+// program image under construction
+//////////////////////////////////////////////////////////////////////////////
+
+typedef struct sockit_owm_prg_s
+{
+  alt_u8*          buf;             // program image buffer
+  int              org;             // program memory load address
+  int              len;             // current program length
+  int              max;             // program image buffer size
+  int              err;             // image buffer overflow
+} sockit_owm_prg;
+
+//////////////////////////////////////////////////////////////////////////////
+// assembler (labels are absolute program memory addresses)
+//////////////////////////////////////////////////////////////////////////////
+
+extern void sockit_owm_prg_init (sockit_owm_prg *prg, alt_u8 *buf, int max, int org);
+extern int  sockit_owm_prg_here (sockit_owm_prg *prg);
+
+extern void sockit_owm_prg_end  (sockit_owm_prg *prg);
+extern void sockit_owm_prg_rst  (sockit_owm_prg *prg);
+extern void sockit_owm_prg_wri  (sockit_owm_prg *prg, const alt_u8 *dat, int n);
+extern void sockit_owm_prg_wrp  (sockit_owm_prg *prg, int n);
+extern void sockit_owm_prg_rdp  (sockit_owm_prg *prg, int n);
+extern void sockit_owm_prg_crc  (sockit_owm_prg *prg);
+extern void sockit_owm_prg_dly  (sockit_owm_prg *prg, int n);
+extern void sockit_owm_prg_pwr  (sockit_owm_prg *prg, int on);
+extern void sockit_owm_prg_sp0  (sockit_owm_prg *prg, int adr);
+extern void sockit_owm_prg_sp1  (sockit_owm_prg *prg, int adr);
+extern void sockit_owm_prg_ldc  (sockit_owm_prg *prg, int n);
+extern void sockit_owm_prg_djn  (sockit_owm_prg *prg, int adr);
+
+// read the scratchpads of 'num' devices with ROM numbers in a table at 'tbl',
+// 10 bytes (9 scratchpad bytes and CRC status) per device are stored at 'dat'
+extern void sockit_owm_prg_scratchpads (sockit_owm_prg *prg, int tbl, int num, int dat);
+
+//////////////////////////////////////////////////////////////////////////////
+// loader and execution control
+//////////////////////////////////////////////////////////////////////////////
+
+extern int  sockit_owm_prg_load (int portnum, int adr, const alt_u8 *buf, int len);
+extern int  sockit_owm_prg_read (int portnum, int adr, alt_u8 *buf, int len);
+extern int  sockit_owm_prg_run  (int portnum, int pc, int ovd);
+extern int  sockit_owm_prg_wait (int portnum);
+
+#ifdef __cplusplus
+}
+#endif // __cplusplus
+
+#endif // __SOCKIT_OWM_PRG_H__
@@ -28,4 +28,5 @@
 //
 // ---------------------------------------------------------------------------
 
+int ReadTemperature10Int(int,uchar *,int *);
 int ReadTemperature10(int,uchar *,float *);
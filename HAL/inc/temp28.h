@@ -28,4 +28,5 @@
 //
 // ---------------------------------------------------------------------------
 
+int ReadTemperature28Int(int,uchar *,int *);
 int ReadTemperature28(int,uchar *,float *);
@@ -28,4 +28,5 @@
 //
 // ---------------------------------------------------------------------------
 
+int ReadTemperature42Int(int,uchar *,int *);
 int ReadTemperature42(int,uchar *,float *);
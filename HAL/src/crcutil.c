@@ -117,3 +117,17 @@ uchar docrc8(int portnum, uchar x)
    utilcrc8[portnum&0x0FF] = dscrc_table[utilcrc8[portnum&0x0FF] ^ x];
    return utilcrc8[portnum&0x0FF];
 }
+
+//--------------------------------------------------------------------------
+// Reentrant form of docrc8, the CRC is kept by the caller.
+//
+// 'crc8'     - CRC to update
+// 'x'        - data byte to calculate the 8 bit crc from
+//
+// Returns: the updated CRC.
+//
+uchar docrc8_r(uchar *crc8, uchar x)
+{
+   *crc8 = dscrc_table[*crc8 ^ x];
+   return *crc8;
+}
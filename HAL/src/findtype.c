@@ -31,48 +31,94 @@
 //----------------------------------------------------------------------
 //
 //
+#include <string.h>
+
 #include "ownet.h"
 #include "findtype.h"
 
 //----------------------------------------------------------------------
-// Search for devices
+// Search for devices of several families in a single search.  Families
+// that are not wanted are skipped after their first device, so the number
+// of search passes is the number of wanted devices plus the number of
+// other families on the 1-Wire Net.
 //
 // 'portnum'  - number 0 to MAX_PORTNUM-1.  This number is provided to
 //              indicate the symbolic port number.
-// 'FamilySN' - an array of all the serial numbers with the matching
-//              family code
-// 'family_code' - the family code of the devices to search for on the
-//                 1-Wire Net
-// 'MAXDEVICES'  - the maximum number of devices to look for with the
-//                 family code passed.
+// 'bucket'   - a result bucket for each wanted family code, 'family',
+//              'FamilySN' and 'max' are set by the caller
+// 'nbucket'  - number of buckets
 //
-// Returns: TRUE(1)  success, device type found
-//          FALSE(0) device not found
+// Returns: the number of serial numbers stored in all buckets, devices
+//          that did not fit are counted in the bucket 'overflow'
 //
-SMALLINT FindDevices(int portnum, uchar FamilySN[][8], SMALLINT family_code, int MAXDEVICES)
+int FindFamilies(int portnum, FamilyBucket *bucket, int nbucket)
 {
-   int NumDevices=0;
+   owSearchContext ctx;
+   SMALLINT result;
+   int i, NumDevices = 0;
 
-   // find the devices
-   // set the search to first find that family code
-   owFamilySearchSetup(portnum,family_code);
+   for (i = 0; i < nbucket; i++)
+   {
+      bucket[i].num = 0;
+      bucket[i].overflow = 0;
+   }
 
-   // loop to find all of the devices up to MAXDEVICES
-   NumDevices = 0;
-   do
+   owSearchInit(&ctx,portnum,TRUE,FALSE);
+   for (;;)
    {
       // perform the search
-      if (!owNext(portnum,TRUE, FALSE))
+      do
+         result = owSearchStep(&ctx);
+      while (result == OWSEARCH_MORE);
+      if (result != OWSEARCH_FOUND)
          break;
-         
-      owSerialNum(portnum,FamilySN[NumDevices], TRUE);
-      if ((FamilySN[NumDevices][0] & 0x7F) == (family_code & 0x7F))
+
+      for (i = 0; i < nbucket; i++)
+         if ((ctx.SerialNum[0] & 0x7F) == (bucket[i].family & 0x7F))
+            break;
+
+      // skip the rest of a family that is not wanted
+      if (i == nbucket)
+         owSearchSkipFamily(&ctx);
+      else if (bucket[i].num < bucket[i].max)
       {
+         memcpy(bucket[i].FamilySN[bucket[i].num++], ctx.SerialNum, 8);
          NumDevices++;
       }
+      else
+         bucket[i].overflow++;
    }
-   while (NumDevices < (MAXDEVICES - 1));
 
-   // check if not at least 1 device
    return NumDevices;
 }
+
+//----------------------------------------------------------------------
+// Search for devices.  The search runs on its own context, so the port
+// search state used by owFirst/owNext is not changed, the last device
+// found is left as the current serial number of the port (owSerialNum).
+//
+// 'portnum'  - number 0 to MAX_PORTNUM-1.  This number is provided to
+//              indicate the symbolic port number.
+// 'FamilySN' - an array of all the serial numbers with the matching
+//              family code
+// 'family_code' - the family code of the devices to search for on the
+//                 1-Wire Net
+// 'MAXDEVICES'  - the maximum number of devices to look for with the
+//                 family code passed.
+//
+// Returns: number of devices found
+//
+SMALLINT FindDevices(int portnum, uchar FamilySN[][8], SMALLINT family_code, int MAXDEVICES)
+{
+   FamilyBucket bucket;
+   int num;
+
+   bucket.family = family_code;
+   bucket.FamilySN = FamilySN;
+   bucket.max = MAXDEVICES;
+
+   num = FindFamilies(portnum,&bucket,1);
+   if (num > 0)
+      owSerialNum(portnum,FamilySN[num-1],FALSE);
+   return num;
+}
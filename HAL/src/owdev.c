@@ -0,0 +1,326 @@
+//////////////////////////////////////////////////////////////////////////////
+//                                                                          //
+//  Minimalistic 1-wire (onewire) master with Avalon MM bus interface       //
+//                                                                          //
+//  Copyright (C) 2010  Iztok Jeras                                         //
+//                                                                          //
+//////////////////////////////////////////////////////////////////////////////
+//                                                                          //
+//  This program is free software: you can redistribute it and/or modify    //
+//  it under the terms of the GNU Lesser General Public License             //
+//  as published by the Free Software Foundation, either                    //
+//  version 3 of the License, or (at your option) any later version.        //
+//                                                                          //
+//  This program is distributed in the hope that it will be useful,         //
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of          //
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the           //
+//  GNU General Public License for more details.                            //
+//                                                                          //
+//  You should have received a copy of the GNU General Public License       //
+//  along with this program.  If not, see <http://www.gnu.org/licenses/>.   //
+//                                                                          //
+//////////////////////////////////////////////////////////////////////////////
+
+
+
+#include <string.h>
+
+#include "sys/alt_irq.h"
+
+#include "ownet.h"
+#include "owdev.h"
+
+// registry updated by the network layer
+static owDevRegistry *DevReg = NULL;
+
+// devices added on each port, see owDevAdded
+static ushort DevAdded[MAX_PORTNUM];
+
+//--------------------------------------------------------------------------
+// FNV-1a hash of a ROM number.
+//
+static unsigned long owDevHash(const uchar *rom)
+{
+   unsigned long h = 2166136261UL;
+   int i;
+
+   for (i = 0; i < 8; i++)
+   {
+      h ^= rom[i];
+      h *= 16777619UL;
+   }
+   return h;
+}
+
+//--------------------------------------------------------------------------
+// Linear probing from the home slot of a ROM number.
+//
+// Returns:  the hash index slot holding the ROM number, or the empty slot
+//           where it would be inserted
+//
+static int owDevSlot(owDevRegistry *reg, const uchar *rom)
+{
+   int h = (int)(owDevHash(rom) & reg->mask);
+   int i;
+
+   while ((i = reg->hash[h]) >= 0 && memcmp(reg->dev[i].rom, rom, 8))
+      h = (h + 1) & reg->mask;
+   return h;
+}
+
+//--------------------------------------------------------------------------
+// Initialize an empty registry.
+//
+// 'reg'        - registry
+// 'dev'        - record pool
+// 'max'        - number of records in the pool
+// 'hash'       - hash index
+// 'size'       - number of hash index entries, a power of two larger than
+//                'max', about twice 'max' keeps the probe sequences short
+//
+// Returns:  TRUE (1) success, FALSE (0) the hash index size is not valid
+//
+SMALLINT owDevInit(owDevRegistry *reg, owDev *dev, int max, int *hash, int size)
+{
+   int i;
+
+   if (size <= max || (size & (size - 1)))
+      return FALSE;
+
+   reg->dev = dev;
+   reg->num = 0;
+   reg->max = max;
+   reg->hash = hash;
+   reg->mask = size - 1;
+   reg->overflow = 0;
+   for (i = 0; i < size; i++)
+      hash[i] = -1;
+   return TRUE;
+}
+
+//--------------------------------------------------------------------------
+// Attach a registry to the network layer, devices found by searches are
+// added to it and accesses update the records.  NULL detaches it.
+//
+void owDevAttach(owDevRegistry *reg)
+{
+   DevReg = reg;
+}
+
+//--------------------------------------------------------------------------
+// Returns:  the record of a ROM number in the attached registry, NULL if
+//           no registry is attached or the device is not registered
+//
+owDev *owDevLookup(const uchar *rom)
+{
+   owDevRegistry *reg = DevReg;
+
+   return reg ? owDevFind(reg, rom) : NULL;
+}
+
+//--------------------------------------------------------------------------
+// Returns:  the record of a ROM number, NULL if it is not registered
+//
+owDev *owDevFind(owDevRegistry *reg, const uchar *rom)
+{
+   alt_irq_context ctx;
+   int i;
+
+   ctx = alt_irq_disable_all();
+   i = reg->hash[owDevSlot(reg, rom)];
+   alt_irq_enable_all(ctx);
+
+   return (i < 0) ? NULL : &reg->dev[i];
+}
+
+//--------------------------------------------------------------------------
+// Register a device, a new record is marked not present until a search
+// or an access finds the device.
+//
+// 'reg'        - registry
+// 'portnum'    - number 0 to MAX_PORTNUM-1.  This number is provided to
+//                indicate the symbolic port number.
+// 'rom'        - ROM number
+//
+// Returns:  the new or existing record, NULL if the pool is full
+//
+owDev *owDevAdd(owDevRegistry *reg, int portnum, const uchar *rom)
+{
+   alt_irq_context ctx;
+   owDev *dev;
+   int h;
+
+   ctx = alt_irq_disable_all();
+   h = owDevSlot(reg, rom);
+   if (reg->hash[h] >= 0)
+   {
+      dev = &reg->dev[reg->hash[h]];
+      alt_irq_enable_all(ctx);
+      return dev;
+   }
+
+   if (reg->num >= reg->max)
+   {
+      reg->overflow++;
+      alt_irq_enable_all(ctx);
+      return NULL;
+   }
+
+   dev = &reg->dev[reg->num];
+   memcpy(dev->rom, rom, 8);
+   dev->portnum = portnum;
+   dev->family = rom[0];
+   dev->speed = MODE_NORMAL;
+   dev->power = OWDEV_POWER_UNKNOWN;
+   dev->config = 0;
+   dev->present = FALSE;
+   dev->seen = 0;
+   dev->value = 0;
+   dev->accesses = 0;
+   dev->errors = 0;
+   reg->hash[h] = reg->num++;
+   alt_irq_enable_all(ctx);
+   return dev;
+}
+
+//--------------------------------------------------------------------------
+// Remove a device.  The last record is moved into the freed one, so
+// record pointers returned earlier are not valid after a removal.
+//
+// Returns:  TRUE (1) removed, FALSE (0) the device was not registered
+//
+SMALLINT owDevRemove(owDevRegistry *reg, const uchar *rom)
+{
+   alt_irq_context ctx;
+   int h, i, j, k, last;
+
+   ctx = alt_irq_disable_all();
+   h = owDevSlot(reg, rom);
+   i = reg->hash[h];
+   j = h;
+   if (i < 0)
+   {
+      alt_irq_enable_all(ctx);
+      return FALSE;
+   }
+
+   // close the gap, entries further along the probe sequence move back
+   // unless their home slot is cyclically in (h,j]
+   for (;;)
+   {
+      j = (j + 1) & reg->mask;
+      if (reg->hash[j] < 0)
+         break;
+      k = (int)(owDevHash(reg->dev[reg->hash[j]].rom) & reg->mask);
+      if ((h < j) ? (h < k && k <= j) : (h < k || k <= j))
+         continue;
+      reg->hash[h] = reg->hash[j];
+      h = j;
+   }
+   reg->hash[h] = -1;
+
+   // keep the pool dense
+   last = --reg->num;
+   if (i != last)
+   {
+      reg->dev[i] = reg->dev[last];
+      reg->hash[owDevSlot(reg, reg->dev[i].rom)] = i;
+   }
+   alt_irq_enable_all(ctx);
+   return TRUE;
+}
+
+//--------------------------------------------------------------------------
+// Select a device with a match ROM on its port, the record of the device
+// is updated if the registry is attached.
+//
+// Returns:  TRUE (1) the device is ready for commands, see owAccess
+//
+SMALLINT owDevAccess(owDev *dev)
+{
+   SMALLINT rt;
+
+   owLock(dev->portnum);
+   owSerialNum(dev->portnum, dev->rom, FALSE);
+   rt = owAccess(dev->portnum);
+   owUnlock(dev->portnum);
+   return rt;
+}
+
+//--------------------------------------------------------------------------
+// Network layer event, updates the attached registry.
+//
+// 'portnum'    - number 0 to MAX_PORTNUM-1.  This number is provided to
+//                indicate the symbolic port number.
+// 'rom'        - ROM number of the device
+// 'event'      - OWDEV_FOUND, OWDEV_ACCESS, OWDEV_OVERDRIVE or OWDEV_FAILED
+//
+void owDevNotify(int portnum, const uchar *rom, SMALLINT event)
+{
+   owDevRegistry *reg = DevReg;
+   alt_irq_context ctx;
+   owDev *dev;
+   long now;
+   int num;
+
+   if (!reg)
+   {
+      // without a registry any device found may be a new one
+      if (event == OWDEV_FOUND)
+         DevAdded[portnum]++;
+      return;
+   }
+   now = msGettick();
+
+   // the record is updated in the same critical section it is found in,
+   // a removal by another task can not move it in between
+   ctx = alt_irq_disable_all();
+
+   // only searches add devices
+   if (event == OWDEV_FOUND)
+   {
+      num = reg->num;
+      dev = owDevAdd(reg, portnum, rom);
+      if (!dev || (reg->num != num))
+         DevAdded[portnum]++;
+   }
+   else
+      dev = owDevFind(reg, rom);
+
+   if (dev)
+   {
+      dev->portnum = portnum;
+      if (event == OWDEV_FAILED)
+      {
+         dev->present = FALSE;
+         if ((ushort)(dev->errors + 1))
+            dev->errors++;
+      }
+      else
+      {
+         dev->present = TRUE;
+         dev->seen = now;
+         if (event == OWDEV_OVERDRIVE)
+            dev->speed = MODE_OVERDRIVE;
+         if (event != OWDEV_FOUND)
+            dev->accesses++;
+      }
+   }
+
+   alt_irq_enable_all(ctx);
+}
+
+//--------------------------------------------------------------------------
+// Count of the devices added on a port, it changes when a search finds a
+// device which is not in the attached registry (any device if no registry
+// is attached), so state kept for a whole port can be revalidated.
+//
+// 'portnum'    - number 0 to MAX_PORTNUM-1.  This number is provided to
+//                indicate the symbolic port number.
+//
+// Returns:  the count, it wraps
+//
+ushort owDevAdded(int portnum)
+{
+   return DevAdded[portnum];
+}
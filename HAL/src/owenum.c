@@ -0,0 +1,486 @@
+//////////////////////////////////////////////////////////////////////////////
+//                                                                          //
+//  Minimalistic 1-wire (onewire) master with Avalon MM bus interface       //
+//                                                                          //
+//  Copyright (C) 2010  Iztok Jeras                                         //
+//                                                                          //
+//////////////////////////////////////////////////////////////////////////////
+//                                                                          //
+//  This program is free software: you can redistribute it and/or modify    //
+//  it under the terms of the GNU Lesser General Public License             //
+//  as published by the Free Software Foundation, either                    //
+//  version 3 of the License, or (at your option) any later version.        //
+//                                                                          //
+//  This program is distributed in the hope that it will be useful,         //
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of          //
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the           //
+//  GNU General Public License for more details.                            //
+//                                                                          //
+//  You should have received a copy of the GNU General Public License       //
+//  along with this program.  If not, see <http://www.gnu.org/licenses/>.   //
+//                                                                          //
+//////////////////////////////////////////////////////////////////////////////
+
+
+
+#include <string.h>
+
+#include "ownet.h"
+#include "owenum.h"
+
+// bit 'k' (1 to 64, in search order) of a ROM number
+#define OWENUM_BIT(rom,k)  (((rom)[((k)-1) >> 3] >> (((k)-1) & 7)) & 0x01)
+
+//--------------------------------------------------------------------------
+// Compare two ROM numbers in search order (bit 1 first, 0 before 1).
+//
+// Returns:  <0, 0 or >0 if 'a' is found before, is equal to or is found
+//           after 'b'
+//
+static int owEnumCmp(const uchar *a, const uchar *b)
+{
+   uchar x, m;
+   int i;
+
+   for (i = 0; i < 8; i++)
+   {
+      x = a[i] ^ b[i];
+      if (x)
+      {
+         // lowest differing bit
+         m = x & (uchar)(-x);
+         return (a[i] & m) ? 1 : -1;
+      }
+   }
+   return 0;
+}
+
+//--------------------------------------------------------------------------
+// Returns:  TRUE (1) if the ROM numbers share the first 'len' bits
+//
+static SMALLINT owEnumPrefix(const uchar *a, const uchar *b, int len)
+{
+   int k;
+
+   for (k = 1; k <= len; k++)
+      if (OWENUM_BIT(a,k) != OWENUM_BIT(b,k))
+         return FALSE;
+   return TRUE;
+}
+
+//--------------------------------------------------------------------------
+// Append a change to the delta list, the count includes the changes that
+// did not fit.
+//
+static void owEnumChange(owEnumDelta *delta, int max_delta, int *n_delta,
+                         const uchar *rom, SMALLINT added)
+{
+   if (*n_delta < max_delta)
+   {
+      memcpy(delta[*n_delta].rom, rom, 8);
+      delta[*n_delta].added = added;
+   }
+   (*n_delta)++;
+}
+
+//--------------------------------------------------------------------------
+// Directed walk to the table entry 'idx': a search pass writing the bits
+// of the known ROM number, the branches reported by the devices at each
+// bit are compared with the branches of the table entries on the path.
+//
+// Returns:  0 the bus matches the table along the whole path, else the
+//           first bit (1 to 64) where it differs, -1 another search context
+//           of the task runs a pass on the port
+//
+static int owEnumWalk(owEnum *en, int idx)
+{
+   int portnum = en->portnum;
+   const uchar *rom = en->rom[idx];
+   int lo = 0, hi = en->num - 1;
+   int k, dir, bit_test, expect;
+   int diff = 0;
+
+   // the walk is a single bus transaction, it would break a running pass
+   owLock(portnum);
+   if (owSearchBusy(portnum))
+   {
+      owUnlock(portnum);
+      return -1;
+   }
+
+   if (!owTouchReset(portnum))
+      diff = 1;
+   else
+   {
+      owWriteByte(portnum,0xF0);
+      for (k = 1; k <= 64; k++)
+      {
+         // read a bit and its compliment
+         bit_test = owTouchBit(portnum,1) << 1;
+         bit_test |= owTouchBit(portnum,1);
+
+         // the entries [lo,hi] share the path so far and are sorted with
+         // the 0 branch first, the expected value of each read is 1 only
+         // if none of them has that bit value
+         expect = ((OWENUM_BIT(en->rom[lo],k) == 1) ? 2 : 0)
+                | ((OWENUM_BIT(en->rom[hi],k) == 0) ? 1 : 0);
+         if (bit_test != expect)
+         {
+            diff = k;
+            break;
+         }
+
+         // follow the known ROM number
+         dir = OWENUM_BIT(rom,k);
+         owTouchBit(portnum,dir);
+         while (OWENUM_BIT(en->rom[lo],k) != dir)
+            lo++;
+         while (OWENUM_BIT(en->rom[hi],k) != dir)
+            hi--;
+      }
+   }
+
+   owUnlock(portnum);
+   return diff;
+}
+
+//--------------------------------------------------------------------------
+// Search the subtree of the devices sharing the first 'len' bits with
+// 'prefix' and merge the result into the table entries [lo,hi], the known
+// devices of the subtree.  The table is only changed after the search
+// completed, until then the known devices found are moved ahead of the
+// others and the new devices are kept in the free table entries.
+//
+// 'n_over'     - number of new devices that did not fit the table
+//
+// Returns:  the number of table entries of the subtree after the merge,
+//           -1 if the port is busy or a pass failed, the table is unchanged
+//
+static int owEnumSubtree(owEnum *en, const uchar *prefix, int len, int lo, int hi,
+                         owEnumDelta *delta, int max_delta, int *n_delta,
+                         int *n_over)
+{
+   owSearchContext ctx;
+   SMALLINT result;
+   int w = lo, r = lo, end = hi + 1;
+   int n_new = 0;
+   int i, k;
+   uchar rom[8];
+
+   *n_over = 0;
+
+   // start at the subtree, following the prefix at discrepancies (like
+   // owFamilySearchSetup), the whole network is searched for 'len' 0
+   owSearchInit(&ctx,en->portnum,TRUE,FALSE);
+   if (len > 0)
+   {
+      memset(ctx.SerialNum, 0, 8);
+      for (k = 1; k <= len; k++)
+         if (OWENUM_BIT(prefix,k))
+            ctx.SerialNum[(k-1) >> 3] |= 1 << ((k-1) & 7);
+      ctx.LastDiscrepancy = 64;
+   }
+
+   for (;;)
+   {
+      do
+         result = owSearchStep(&ctx);
+      while (result == OWSEARCH_MORE);
+
+      // only a bus without devices ends the search before the first bit,
+      // a later end lost the devices during the pass or read a bad CRC
+      if ((result == OWSEARCH_BUSY) ||
+          ((result == OWSEARCH_END) && (ctx.bit_number > 1)))
+      {
+         // put the known devices back in search order
+         for (i = lo + 1; i < end; i++)
+         {
+            memcpy(rom, en->rom[i], 8);
+            for (k = i; (k > lo) && (owEnumCmp(en->rom[k-1],rom) > 0); k--)
+               memcpy(en->rom[k], en->rom[k-1], 8);
+            memcpy(en->rom[k], rom, 8);
+         }
+         return -1;
+      }
+
+      // the subtree is empty or completed
+      if ((result != OWSEARCH_FOUND) || !owEnumPrefix(ctx.SerialNum,prefix,len))
+         break;
+
+      // the known devices [lo,w) were found, [w,r) were passed without
+      // being found and [r,end) are not reached yet
+      while ((r < end) && (owEnumCmp(en->rom[r],ctx.SerialNum) < 0))
+         r++;
+      if ((r < end) && !owEnumCmp(en->rom[r],ctx.SerialNum))
+      {
+         memmove(en->rom[w+1], en->rom[w], (r - w) * 8);
+         memcpy(en->rom[w], ctx.SerialNum, 8);
+         w++;
+         r++;
+      }
+      else if (en->num + n_new < en->max)
+      {
+         // new device
+         memcpy(en->rom[en->num + n_new], ctx.SerialNum, 8);
+         n_new++;
+      }
+      else
+         (*n_over)++;
+
+      // the next pass would leave the subtree
+      if (ctx.LastDiscrepancy <= len)
+         break;
+   }
+
+   // the known devices not found were removed
+   for (i = w; i < end; i++)
+      owEnumChange(delta,max_delta,n_delta,en->rom[i],FALSE);
+   memmove(en->rom[w], en->rom[end], (en->num + n_new - end) * 8);
+   en->num -= end - w;
+
+   // insert the new devices, they follow the table entries
+   for (i = lo, k = 0; k < n_new; k++)
+   {
+      memcpy(rom, en->rom[en->num], 8);
+      while ((i < w) && (owEnumCmp(en->rom[i],rom) < 0))
+         i++;
+      owEnumChange(delta,max_delta,n_delta,rom,TRUE);
+      memmove(en->rom[i+1], en->rom[i], (en->num - i) * 8);
+      memcpy(en->rom[i], rom, 8);
+      en->num++;
+      w++;
+      i++;
+   }
+
+   return w - lo;
+}
+
+//--------------------------------------------------------------------------
+// Search a subtree again and merge the result into the table entries
+// [lo,hi], see owEnumSubtree.  If removed devices made room for new devices
+// that did not fit, the subtree is searched once more.
+//
+// Returns:  the number of table entries of the subtree after the merge,
+//           -1 if the port is busy or a pass failed, the table is unchanged
+//
+static int owEnumRescan(owEnum *en, const uchar *prefix, int len, int lo, int hi,
+                        owEnumDelta *delta, int max_delta, int *n_delta)
+{
+   int n, k, n_over, k_over;
+
+   n = owEnumSubtree(en,prefix,len,lo,hi,delta,max_delta,n_delta,&n_over);
+   if ((n >= 0) && n_over && (en->num < en->max))
+   {
+      k = owEnumSubtree(en,prefix,len,lo,lo+n-1,delta,max_delta,n_delta,&k_over);
+      if (k >= 0)
+      {
+         n = k;
+         n_over = k_over;
+      }
+   }
+   if (n >= 0)
+      en->overflow += n_over;
+   return n;
+}
+
+//--------------------------------------------------------------------------
+// Initialize an enumerator with an empty table, the first update searches
+// the whole network.
+//
+// 'en'         - enumerator
+// 'portnum'    - number 0 to MAX_PORTNUM-1.  This number is provided to
+//                indicate the symbolic port number.
+// 'rom'        - table for the ROM numbers of the known devices
+// 'max'        - number of table entries
+//
+void owEnumInit(owEnum *en, int portnum, uchar rom[][8], int max)
+{
+   en->portnum = portnum;
+   en->rom = rom;
+   en->num = 0;
+   en->max = max;
+   en->round = 0;
+   en->overflow = 0;
+}
+
+//--------------------------------------------------------------------------
+// Update the table of known devices.  Every other device is checked with a
+// directed walk, alternating between updates, a walk also checks that the
+// branches to the devices next to it are still there.  A difference is
+// searched again starting at the last matching branch, so the cost of an
+// update without changes is half of a full search, and every device is
+// walked at least every second update.  A failed search pass ends the
+// update with the changes found so far, the next update walks the same
+// devices again.
+//
+// 'en'         - enumerator
+// 'delta'      - list for the added and removed devices
+// 'max_delta'  - size of the list
+//
+// Returns:  number of changes, may be larger than 'max_delta', or
+//           OWENUM_BUSY if another search context of the task runs a pass
+//           on the port, the table is not checked
+//
+int owEnumUpdate(owEnum *en, owEnumDelta *delta, int max_delta)
+{
+   static const uchar none[8] = {0};
+   uchar prefix[8];
+   int n_delta = 0;
+   int i, k, lo, hi;
+
+   // the walks would break the running pass
+   if (owSearchBusy(en->portnum))
+      return OWENUM_BUSY;
+
+   // an empty table is filled by a full search
+   if (en->num == 0)
+   {
+      if (owEnumRescan(en,none,0,0,-1,delta,max_delta,&n_delta) >= 0)
+         en->round++;
+      return n_delta;
+   }
+
+   for (i = 0; i < en->num; )
+   {
+      // a single device is always walked
+      if ((en->num > 1) && ((i + en->round) & 1))
+      {
+         i++;
+         continue;
+      }
+      k = owEnumWalk(en,i);
+      if (k < 0)
+         return n_delta;
+      if (!k)
+      {
+         i++;
+         continue;
+      }
+
+      // the entries sharing the matching part of the path
+      lo = i;
+      hi = i;
+      while ((lo > 0) && owEnumPrefix(en->rom[lo-1],en->rom[i],k-1))
+         lo--;
+      while ((hi < en->num - 1) && owEnumPrefix(en->rom[hi+1],en->rom[i],k-1))
+         hi++;
+
+      memcpy(prefix, en->rom[i], 8);
+      k = owEnumRescan(en,prefix,k-1,lo,hi,delta,max_delta,&n_delta);
+      if (k < 0)
+         return n_delta;
+      i = lo + k;
+   }
+
+   en->round++;
+   return n_delta;
+}
+
+//--------------------------------------------------------------------------
+// Snapshot format: the magic "OWE1", the number of tables, for each table
+// the port number, the number of devices (2 bytes, LSB first) and the ROM
+// numbers, followed by the CRC8 of all preceding bytes.
+//
+static const uchar owEnumMagic[4] = {'O','W','E','1'};
+
+// transfer a part of the snapshot and accumulate its CRC8
+static SMALLINT owEnumXfer(owEnumStore store, void *ctx, SMALLINT do_write,
+                           uchar *buf, int len, uchar *crc8)
+{
+   int i;
+
+   if (store(ctx,do_write,buf,len) != len)
+      return FALSE;
+   for (i = 0; i < len; i++)
+      docrc8_r(crc8,buf[i]);
+   return TRUE;
+}
+
+//--------------------------------------------------------------------------
+// Save the tables of 'n' enumerators.
+//
+// 'en'         - array of enumerators
+// 'n'          - number of enumerators
+// 'store'      - storage callback
+// 'ctx'        - storage callback context
+//
+// Returns:  TRUE (1) the snapshot was written
+//
+SMALLINT owEnumSave(owEnum *en, int n, owEnumStore store, void *ctx)
+{
+   uchar buf[4], crc8 = 0;
+   int i;
+
+   memcpy(buf, owEnumMagic, 4);
+   if (!owEnumXfer(store,ctx,TRUE,buf,4,&crc8))
+      return FALSE;
+   buf[0] = n;
+   if (!owEnumXfer(store,ctx,TRUE,buf,1,&crc8))
+      return FALSE;
+
+   for (i = 0; i < n; i++)
+   {
+      buf[0] = en[i].portnum;
+      buf[1] = en[i].num & 0xFF;
+      buf[2] = en[i].num >> 8;
+      if (!owEnumXfer(store,ctx,TRUE,buf,3,&crc8) ||
+          !owEnumXfer(store,ctx,TRUE,en[i].rom[0],en[i].num * 8,&crc8))
+         return FALSE;
+   }
+
+   buf[0] = crc8;
+   return (store(ctx,TRUE,buf,1) == 1);
+}
+
+//--------------------------------------------------------------------------
+// Restore the tables of 'n' enumerators, stored tables are matched by the
+// port number.  Ports without a stored table, or with more devices than
+// the table can hold, start empty and are searched by the next update.
+// The snapshot is not checked against the bus, the next update does.
+//
+// 'en'         - array of enumerators, initialized with owEnumInit
+// 'n'          - number of enumerators
+// 'store'      - storage callback
+// 'ctx'        - storage callback context
+//
+// Returns:  TRUE (1) the snapshot was valid, FALSE (0) all tables are empty
+//
+SMALLINT owEnumRestore(owEnum *en, int n, owEnumStore store, void *ctx)
+{
+   uchar buf[8], crc8 = 0;
+   int i, j, k, num, cnt;
+
+   for (j = 0; j < n; j++)
+      en[j].num = 0;
+
+   if (!owEnumXfer(store,ctx,FALSE,buf,4,&crc8) || memcmp(buf, owEnumMagic, 4) ||
+       !owEnumXfer(store,ctx,FALSE,buf,1,&crc8))
+      return FALSE;
+   cnt = buf[0];
+
+   for (i = 0; i < cnt; i++)
+   {
+      if (!owEnumXfer(store,ctx,FALSE,buf,3,&crc8))
+         break;
+      num = buf[1] | (buf[2] << 8);
+      for (j = 0; j < n; j++)
+         if ((en[j].portnum == buf[0]) && (num <= en[j].max))
+            break;
+      // read the ROM numbers into the table, or skip them
+      for (k = 0; k < num; k++)
+         if (!owEnumXfer(store,ctx,FALSE,(j < n) ? en[j].rom[k] : buf,8,&crc8))
+            break;
+      if (k < num)
+         break;
+      if (j < n)
+         en[j].num = num;
+   }
+
+   // the CRC of the whole snapshot is 0
+   if ((i == cnt) && owEnumXfer(store,ctx,FALSE,buf,1,&crc8) && (crc8 == 0))
+      return TRUE;
+
+   for (j = 0; j < n; j++)
+      en[j].num = 0;
+   return FALSE;
+}
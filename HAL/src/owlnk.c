@@ -36,13 +36,16 @@
 //           2.10 -> 3.00  Added owReadBitPower and owWriteBytePower
 //
 
+// the out of line link layer is defined here, do not map it to the inline
+// primitives
+#define SOCKIT_OWM_LNK_C
+
 #include "ownet.h"
 #include "sockit_owm_regs.h"
 #include "sockit_owm.h"
+#include "sockit_owm_lnk.h"
 #include <unistd.h>
 
-extern sockit_owm_state sockit_owm;
-
 // exportable link-level functions
 SMALLINT owTouchReset(int);
 SMALLINT owTouchBit(int,SMALLINT);
@@ -53,6 +56,7 @@ SMALLINT owSpeed(int,SMALLINT);
 SMALLINT owLevel(int,SMALLINT);
 SMALLINT owProgramPulse(int);
 void msDelay(int);
+void owDelay(int,int);
 long msGettick(void);
 SMALLINT owWriteBytePower(int,SMALLINT);
 SMALLINT owReadBytePower(int);
@@ -60,6 +64,34 @@ SMALLINT owReadBitPower(int,SMALLINT);
 SMALLINT owHasPowerDelivery(int);
 SMALLINT owHasOverDrive(int);
 SMALLINT owHasProgramPulse(int);
+void owLock(int);
+void owUnlock(int);
+
+//--------------------------------------------------------------------------
+// Lock the 1-Wire Net for a transaction.  Locks can be nested by the same
+// task, only the outermost lock and unlock access the OS semaphore, so
+// the link functions inside a transaction do not call the OS.  Each port
+// has its own lock, transactions on different ports only share the
+// controller for the duration of a single bit or byte.
+//
+// 'portnum'    - number 0 to MAX_PORTNUM-1.  This number is provided to
+//                indicate the symbolic port number.
+//
+void owLock(int portnum)
+{
+   sockit_owm_lock(portnum);
+}
+
+//--------------------------------------------------------------------------
+// Unlock the 1-Wire Net at the end of a transaction.
+//
+// 'portnum'    - number 0 to MAX_PORTNUM-1.  This number is provided to
+//                indicate the symbolic port number.
+//
+void owUnlock(int portnum)
+{
+   sockit_owm_unlock(portnum);
+}
 
 //--------------------------------------------------------------------------
 // Reset all of the devices on the 1-Wire Net and return the result.
@@ -72,30 +104,7 @@ SMALLINT owHasProgramPulse(int);
 //
 SMALLINT owTouchReset(int portnum)
 {
-   int reg;
-   int ovd = (sockit_owm.ovd >> portnum) & 0x1;
-
-   // lock transfer
-   ALT_SEM_PEND (sockit_owm.cyc, 0);
-
-   // reset pulse
-   IOWR_SOCKIT_OWM_CTL (sockit_owm.base, (sockit_owm.pwr << SOCKIT_OWM_CTL_POWER_OFST    )
-                                       | (portnum        << SOCKIT_OWM_CTL_SEL_OFST      )
-                                       | (sockit_owm.ien  ? SOCKIT_OWM_CTL_IEN_MSK : 0x00)
-                                       | (                  SOCKIT_OWM_CTL_CYC_MSK       )
-                                       | (ovd             ? SOCKIT_OWM_CTL_OVD_MSK : 0x00)
-                                       | (                  SOCKIT_OWM_CTL_RST_MSK       ));
-
-   // wait for irq to set the transfer end flag
-   ALT_FLAG_PEND (sockit_owm.irq, 0x1, OS_FLAG_WAIT_SET_ANY + OS_FLAG_CONSUME, 0);
-   // wait for STX (end of transfer cycle) and read the presence status
-   while ((reg = IORD_SOCKIT_OWM_CTL (sockit_owm.base)) & SOCKIT_OWM_CTL_CYC_MSK);
-
-   // release transfer lock
-   ALT_SEM_POST (sockit_owm.cyc);
-
-   // return negated DAT (presence detect)
-   return (~reg & SOCKIT_OWM_CTL_DAT_MSK);  // NOTE the shortcut
+   return sockit_owm_touch_reset(portnum);
 }
 
 //--------------------------------------------------------------------------
@@ -113,30 +122,7 @@ SMALLINT owTouchReset(int portnum)
 //
 SMALLINT owTouchBit(int portnum, SMALLINT sendbit)
 {
-   int reg;
-   int ovd = (sockit_owm.ovd >> portnum) & 0x1;
-
-   // lock transfer
-   ALT_SEM_PEND (sockit_owm.cyc, 0);
-
-   // read/write data
-   IOWR_SOCKIT_OWM_CTL (sockit_owm.base, (sockit_owm.pwr << SOCKIT_OWM_CTL_POWER_OFST    )
-      	                               | (portnum        << SOCKIT_OWM_CTL_SEL_OFST      )
-                                       | (sockit_owm.ien  ? SOCKIT_OWM_CTL_IEN_MSK : 0x00)
-                                       | (                  SOCKIT_OWM_CTL_CYC_MSK       )
-                                       | (ovd             ? SOCKIT_OWM_CTL_OVD_MSK : 0x00)
-                                       | (sendbit         & SOCKIT_OWM_CTL_DAT_MSK       ));  // NOTE the shortcut
-
-   // wait for irq to set the transfer end flag
-   ALT_FLAG_PEND (sockit_owm.irq, 0x1, OS_FLAG_WAIT_SET_ANY + OS_FLAG_CONSUME, 0);
-   // wait for STX (end of transfer cycle) and read the read data bit
-   while ((reg = IORD_SOCKIT_OWM_CTL (sockit_owm.base)) & SOCKIT_OWM_CTL_CYC_MSK);
-
-   // release transfer lock
-   ALT_SEM_POST (sockit_owm.cyc);
-
-   // return DAT (read bit)
-   return (reg & SOCKIT_OWM_CTL_DAT_MSK);  // NOTE the shortcut
+   return sockit_owm_touch_bit(portnum,sendbit);
 }
 
 //--------------------------------------------------------------------------
@@ -153,14 +139,7 @@ SMALLINT owTouchBit(int portnum, SMALLINT sendbit)
 //
 SMALLINT owTouchByte(int portnum, SMALLINT sendbyte)
 {
-   int i;
-   SMALLINT dat = 0;
-   for (i=0; i<8; i++)
-   {
-      dat |= owTouchBit(portnum,sendbyte & 0x1) << i;
-      sendbyte >>= 1;
-   }
-   return dat;
+   return sockit_owm_touch_byte(portnum,sendbyte);
 }
 
 //--------------------------------------------------------------------------
@@ -177,7 +156,7 @@ SMALLINT owTouchByte(int portnum, SMALLINT sendbyte)
 //
 SMALLINT owWriteByte(int portnum, SMALLINT sendbyte)
 {
-   return (owTouchByte(portnum,sendbyte) == sendbyte) ? TRUE : FALSE;
+   return sockit_owm_write_byte(portnum,sendbyte) ? TRUE : FALSE;
 }
 
 //--------------------------------------------------------------------------
@@ -191,7 +170,7 @@ SMALLINT owWriteByte(int portnum, SMALLINT sendbyte)
 //
 SMALLINT owReadByte(int portnum)
 {
-   return owTouchByte(portnum,0xFF);
+   return sockit_owm_read_byte(portnum);
 }
 
 //--------------------------------------------------------------------------
@@ -207,15 +186,17 @@ SMALLINT owReadByte(int portnum)
 //
 SMALLINT owSpeed(int portnum, SMALLINT new_speed)
 {
+   sockit_owm_state *owm = SOCKIT_OWM(portnum);
    int select;
-   select = 0x1 << portnum;
+   select = 0x1 << SOCKIT_OWM_SEL(portnum);
    // if overdrive is implemented use it
-   if (sockit_owm.ovd_e) {
-      if (new_speed == MODE_OVERDRIVE)  sockit_owm.ovd |=  select;
-      if (new_speed == MODE_NORMAL   )  sockit_owm.ovd &= ~select;
+   if (owm->ovd_e) {
+      if (new_speed == MODE_OVERDRIVE)  owm->ovd |=  select;
+      if (new_speed == MODE_NORMAL   )  owm->ovd &= ~select;
+      sockit_owm_ctl(owm);
    }
    // return the current port state
-   return (sockit_owm.ovd & select) ? MODE_OVERDRIVE : MODE_NORMAL;
+   return (owm->ovd & select) ? MODE_OVERDRIVE : MODE_NORMAL;
 }
 
 //--------------------------------------------------------------------------
@@ -234,18 +215,26 @@ SMALLINT owSpeed(int portnum, SMALLINT new_speed)
 //
 SMALLINT owLevel(int portnum, SMALLINT new_level)
 {
+   sockit_owm_state *owm = SOCKIT_OWM(portnum);
+   int sel = SOCKIT_OWM_SEL(portnum);
+
+   owLock(portnum);
+   sockit_owm_cyc_lock(owm);
    if (new_level == MODE_STRONG5) {
       // set the power bit
-      sockit_owm.pwr |=  (1 << portnum);
-      IOWR_SOCKIT_OWM_CTL (sockit_owm.base, (sockit_owm.pwr << SOCKIT_OWM_CTL_POWER_OFST) | SOCKIT_OWM_CTL_PWR_MSK);
+      owm->pwr |=  (1 << sel);
+      IOWR_SOCKIT_OWM_CTL (owm->base, (owm->pwr << SOCKIT_OWM_CTL_POWER_OFST) | SOCKIT_OWM_CTL_PWR_MSK);
    }
    if (new_level == MODE_NORMAL) {
       // clear the power bit
-      sockit_owm.pwr &= ~(1 << portnum);
-      IOWR_SOCKIT_OWM_CTL (sockit_owm.base, (sockit_owm.pwr << SOCKIT_OWM_CTL_POWER_OFST));
+      owm->pwr &= ~(1 << sel);
+      IOWR_SOCKIT_OWM_CTL (owm->base, (owm->pwr << SOCKIT_OWM_CTL_POWER_OFST));
    }
+   sockit_owm_ctl(owm);
+   sockit_owm_cyc_unlock(owm);
+   owUnlock(portnum);
    // return the current port state
-   return ((sockit_owm.pwr >> portnum) & 0x1) ? MODE_STRONG5 : MODE_NORMAL;
+   return ((owm->pwr >> sel) & 0x1) ? MODE_STRONG5 : MODE_NORMAL;
 }
 
 //--------------------------------------------------------------------------
@@ -267,32 +256,44 @@ SMALLINT owProgramPulse(int portnum)
 //  Description:
 //     Delay for at least 'len' ms
 //
+//  The hardware delay runs on the instance mapped to port 0, see owDelay.
+//
 void msDelay(int len)
+{
+   owDelay(0,len);
+}
+
+//--------------------------------------------------------------------------
+//  Description:
+//     Delay for at least 'len' ms on the controller of a port
+//
+//  The hardware delay runs on the instance mapped to 'portnum', so a
+//  conversion wait does not take cycles from the other instances.  The
+//  controller is locked only for each delay cycle, so transactions on
+//  the other ports, or on a single port controller of other tasks, run
+//  in between.
+//
+// 'portnum'    - number 0 to MAX_PORTNUM-1.  This number is provided to
+//                indicate the symbolic port number.
+// 'len'        - delay time in ms
+//
+void owDelay(int portnum, int len)
 {
 #if SOCKIT_OWM_HW_DLY
+   sockit_owm_state *owm = SOCKIT_OWM(portnum);
    int i;
 
    // compute the number delay cycles depending on delay time
-   len = (len * sockit_owm.f_dly) >> 16;
-
-   // lock transfer
-   ALT_SEM_PEND (sockit_owm.cyc, 0);
+   len = (len * owm->f_dly) >> 16;
 
    for (i=0; i<len; i++) {
-      // create a 960us pause
-      IOWR_SOCKIT_OWM_CTL (sockit_owm.base, ( sockit_owm.pwr        << SOCKIT_OWM_CTL_POWER_OFST    )
-                                          | ( sockit_owm.ien         ? SOCKIT_OWM_CTL_IEN_MSK : 0x00)
-                                          | ((sockit_owm.pwr & 0x1)  ? SOCKIT_OWM_CTL_PWR_MSK : 0x00)
-                                          | (                          SOCKIT_OWM_CTL_CYC_MSK       )
-                                          | (                          SOCKIT_OWM_CTL_DLY_MSK       ));
-
-     // wait for irq to set the transfer end flag
-     ALT_FLAG_PEND (sockit_owm.irq, 0x1, OS_FLAG_WAIT_SET_ANY + OS_FLAG_CONSUME, 0);
-     // wait for STX (end of transfer cycle)
-     while (IORD_SOCKIT_OWM_CTL (sockit_owm.base) & SOCKIT_OWM_CTL_CYC_MSK);
-
-     // release transfer lock
-     ALT_SEM_POST (sockit_owm.cyc);
+      // the transaction lock guards a single port controller
+      if (SOCKIT_OWM_PORTS(owm) == 1)  owLock(portnum);
+      sockit_owm_cyc_lock(owm);
+      // create a 960us pause (delay cycles run on SEL 0)
+      sockit_owm_cycle(owm, 0, owm->dly);
+      sockit_owm_cyc_unlock(owm);
+      if (SOCKIT_OWM_PORTS(owm) == 1)  owUnlock(portnum);
    }
 #else
 #ifdef UCOS_II
@@ -312,8 +313,8 @@ void msDelay(int len)
 long msGettick(void)
 {
 #ifdef UCOS_II
-   // uCOS-II tick counter
-	OSTimeGet();
+   // uCOS-II tick counter converted to milliseconds
+   return (long)(((alt_u64)OSTimeGet() * 1000) / OS_TICKS_PER_SEC);
 #else
    // TODO add platform specific code here
    return 0;
@@ -423,7 +424,7 @@ SMALLINT owHasPowerDelivery(int portnum)
 //
 SMALLINT owHasOverDrive(int portnum)
 {
-   return sockit_owm.ovd_e;
+   return SOCKIT_OWM(portnum)->ovd_e;
 }
 
 //--------------------------------------------------------------------------
@@ -40,15 +40,304 @@
 
 #include <stdio.h>
 #include "ownet.h"
+#include "owdev.h"
 
 // exportable functions defined in ownet.c
 SMALLINT bitacc(SMALLINT,SMALLINT,SMALLINT,uchar *);
+static SMALLINT owAccessMatch(int portnum);
 
-// global variables for this module to hold search state information
-static SMALLINT LastDiscrepancy[MAX_PORTNUM];
-static SMALLINT LastFamilyDiscrepancy[MAX_PORTNUM];
-static SMALLINT LastDevice[MAX_PORTNUM];
-uchar SerialNum[MAX_PORTNUM][8];
+// global variables for this module to hold search state information, used
+// by the port based search functions
+static owSearchContext SearchCtx[MAX_PORTNUM];
+// search context running a pass on the port (holding the port lock)
+static owSearchContext *SearchOwner[MAX_PORTNUM];
+
+// search states
+#define OWSEARCH_IDLE     0
+#define OWSEARCH_COMMAND  1
+#define OWSEARCH_TRIPLET  2
+
+//--------------------------------------------------------------------------
+// Reset the search state of a search context, the next pass will be like
+// a first.
+//
+static void owSearchReset(owSearchContext *ctx)
+{
+   ctx->LastDiscrepancy = 0;
+   ctx->LastDevice = FALSE;
+   ctx->LastFamilyDiscrepancy = 0;
+}
+
+//--------------------------------------------------------------------------
+// End the running search pass and release the port.
+//
+// 'ctx'        - search context
+// 'found'      - TRUE (1) the pass read a serial number with a valid CRC
+//
+// Returns:   OWSEARCH_FOUND or OWSEARCH_END
+//
+static SMALLINT owSearchEnd(owSearchContext *ctx, SMALLINT found)
+{
+   // search successful so set LastDiscrepancy,LastDevice
+   if (found)
+   {
+      ctx->LastDiscrepancy = ctx->last_zero;
+      ctx->LastDevice = (ctx->LastDiscrepancy == 0);
+   }
+
+   // if no device found then reset counters so next pass will be
+   // like a first
+   if (!found || !ctx->SerialNum[0])
+   {
+      owSearchReset(ctx);
+      found = FALSE;
+   }
+
+   ctx->state = OWSEARCH_IDLE;
+   SearchOwner[ctx->portnum] = NULL;
+   owUnlock(ctx->portnum);
+
+   // update the device registry
+   if (found)
+      owDevNotify(ctx->portnum, ctx->SerialNum, OWDEV_FOUND);
+
+   return found ? OWSEARCH_FOUND : OWSEARCH_END;
+}
+
+//--------------------------------------------------------------------------
+// The 'owSearchInit' function prepares a caller owned search context for
+// a search from the first device.  Search contexts do not share any state,
+// so searches on different ports, or several searches on the same port,
+// can be interleaved by calling 'owSearchStep' on each context in turn.
+//
+// 'ctx'        - search context
+// 'portnum'    - number 0 to MAX_PORTNUM-1.  This number is provided to
+//                indicate the symbolic port number.
+// 'do_reset'   - TRUE (1) perform reset before each search pass, FALSE (0)
+//                do not perform reset before search.
+// 'alarm_only' - TRUE (1) the find alarm command 0xEC is
+//                sent instead of the normal search command 0xF0
+//
+void owSearchInit(owSearchContext *ctx, int portnum, SMALLINT do_reset, SMALLINT alarm_only)
+{
+   ctx->portnum = portnum;
+   ctx->do_reset = do_reset;
+   ctx->alarm_only = alarm_only;
+   ctx->state = OWSEARCH_IDLE;
+   owSearchReset(ctx);
+}
+
+//--------------------------------------------------------------------------
+// The 'owSearchStep' function advances the search pass of a context by a
+// single step: the reset, the search command or one triplet (2 read bits
+// and the direction bit).  The pass holds the port lock from its first
+// to its last step, a context of the same task calling this function
+// while another context runs a pass on the port returns OWSEARCH_BUSY
+// without accessing the bus.
+//
+// 'ctx'        - search context
+//
+// Returns:   OWSEARCH_MORE  : the pass is not finished, call again
+//            OWSEARCH_FOUND : a 1-Wire device was found and its
+//                             Serial Number placed in ctx->SerialNum
+//            OWSEARCH_END   : when no new device was found.  Either the
+//                             last search was the last device or there
+//                             are no devices on the 1-Wire Net.
+//            OWSEARCH_BUSY  : another context runs a pass on the port,
+//                             call again after it ended
+//
+SMALLINT owSearchStep(owSearchContext *ctx)
+{
+   int portnum = ctx->portnum;
+   uchar bit_test, search_direction;
+
+   switch (ctx->state)
+   {
+      case OWSEARCH_IDLE:
+         // the last pass found the last device
+         if (ctx->LastDevice)
+         {
+            owSearchReset(ctx);
+            return OWSEARCH_END;
+         }
+
+         // the whole pass is a single bus transaction
+         owLock(portnum);
+         if (SearchOwner[portnum] && (SearchOwner[portnum] != ctx))
+         {
+            owUnlock(portnum);
+            return OWSEARCH_BUSY;
+         }
+         SearchOwner[portnum] = ctx;
+
+         // initialize for search
+         ctx->bit_number = 1;
+         ctx->last_zero = 0;
+         ctx->serial_byte_number = 0;
+         ctx->serial_byte_mask = 1;
+         ctx->crc8 = 0;
+
+         // check if reset first is requested
+         // if there are no parts on 1-wire, end the pass
+         if (ctx->do_reset && !owTouchReset(portnum))
+         {
+            OWERROR(OWERROR_NO_DEVICES_ON_NET);
+            return owSearchEnd(ctx, FALSE);
+         }
+         ctx->state = OWSEARCH_COMMAND;
+         return OWSEARCH_MORE;
+
+      case OWSEARCH_COMMAND:
+         // If finding alarming devices issue a different command
+         if (ctx->alarm_only)
+            owWriteByte(portnum,0xEC);  // issue the alarming search command
+         else
+            owWriteByte(portnum,0xF0);  // issue the search command
+         ctx->state = OWSEARCH_TRIPLET;
+         return OWSEARCH_MORE;
+
+      case OWSEARCH_TRIPLET:
+         // read a bit and its compliment
+         bit_test = owTouchBit(portnum,1) << 1;
+         bit_test |= owTouchBit(portnum,1);
+
+         // check for no devices on 1-wire
+         if (bit_test == 3)
+            return owSearchEnd(ctx, FALSE);
+
+         // all devices coupled have 0 or 1
+         if (bit_test > 0)
+            search_direction = !(bit_test & 0x01);  // bit write value for search
+         else
+         {
+            // if this discrepancy if before the Last Discrepancy
+            // on a previous next then pick the same as last time
+            if (ctx->bit_number < ctx->LastDiscrepancy)
+               search_direction = ((ctx->SerialNum[ctx->serial_byte_number] & ctx->serial_byte_mask) > 0);
+            else
+               // if equal to last pick 1, if not then pick 0
+               search_direction = (ctx->bit_number == ctx->LastDiscrepancy);
+
+            // if 0 was picked then record its position in LastZero
+            if (search_direction == 0)
+            {
+               ctx->last_zero = ctx->bit_number;
+
+               // check for Last discrepancy in family
+               if (ctx->last_zero < 9)
+                  ctx->LastFamilyDiscrepancy = ctx->last_zero;
+            }
+         }
+
+         // set or clear the bit in the SerialNum byte serial_byte_number
+         // with mask serial_byte_mask
+         if (search_direction == 1)
+            ctx->SerialNum[ctx->serial_byte_number] |= ctx->serial_byte_mask;
+         else
+            ctx->SerialNum[ctx->serial_byte_number] &= ~ctx->serial_byte_mask;
+
+         // serial number search direction write bit
+         owTouchBit(portnum,search_direction);
+
+         // increment the byte counter bit_number
+         // and shift the mask serial_byte_mask
+         ctx->bit_number++;
+         ctx->serial_byte_mask <<= 1;
+
+         // if the mask is 0 then go to new SerialNum byte serial_byte_number
+         // and reset mask
+         if (ctx->serial_byte_mask == 0)
+         {
+            // The below has been added to accomidate the valid CRC with the
+            // possible changing serial number values of the DS28E04.
+            if (((ctx->SerialNum[0] & 0x7F) == 0x1C) && (ctx->serial_byte_number == 1))
+               docrc8_r(&ctx->crc8,0x7F);
+            else
+               docrc8_r(&ctx->crc8,ctx->SerialNum[ctx->serial_byte_number]);  // accumulate the CRC
+
+            ctx->serial_byte_number++;
+            ctx->serial_byte_mask = 1;
+         }
+
+         // loop until through all SerialNum bytes 0-7,
+         // the search was successful if the CRC is valid
+         if (ctx->serial_byte_number < 8)
+            return OWSEARCH_MORE;
+         return owSearchEnd(ctx, ctx->crc8 == 0);
+   }
+
+   return OWSEARCH_END;
+}
+
+//--------------------------------------------------------------------------
+// Abort the running search pass of a context and release the port, the
+// next pass will be like a first.  The port is only released if the pass
+// of this context holds it.
+//
+// 'ctx'        - search context
+//
+void owSearchAbort(owSearchContext *ctx)
+{
+   if ((ctx->state != OWSEARCH_IDLE) && (SearchOwner[ctx->portnum] == ctx))
+      owSearchEnd(ctx, FALSE);
+   ctx->state = OWSEARCH_IDLE;
+   owSearchReset(ctx);
+}
+
+//--------------------------------------------------------------------------
+// Check for a search pass running on the port.  A pass of another task
+// holds the port lock, so the function only returns after it ended.
+//
+// 'portnum'    - number 0 to MAX_PORTNUM-1.  This number is provided to
+//                indicate the symbolic port number.
+//
+// Returns:   TRUE (1) a search context of the task runs a pass on the port
+//
+SMALLINT owSearchBusy(int portnum)
+{
+   SMALLINT busy;
+
+   owLock(portnum);
+   busy = (SearchOwner[portnum] != NULL);
+   owUnlock(portnum);
+   return busy;
+}
+
+//--------------------------------------------------------------------------
+// Setup a search context to find a certain family of devices in the next
+// pass.
+//
+// 'ctx'           - search context
+// 'search_family' - family code type to set the search algorithm to find
+//                   next.
+//
+void owSearchFamily(owSearchContext *ctx, SMALLINT search_family)
+{
+   uchar i;
+
+   // set the search state to find SearchFamily type devices
+   ctx->SerialNum[0] = search_family;
+   for (i = 1; i < 8; i++)
+      ctx->SerialNum[i] = 0;
+   ctx->LastDiscrepancy = 64;
+   ctx->LastDevice = FALSE;
+}
+
+//--------------------------------------------------------------------------
+// Set the search state of a context to skip the current family code.
+//
+// 'ctx'           - search context
+//
+void owSearchSkipFamily(owSearchContext *ctx)
+{
+   // set the Last discrepancy to last family discrepancy
+   ctx->LastDiscrepancy = ctx->LastFamilyDiscrepancy;
+   ctx->LastFamilyDiscrepancy = 0;
+
+   // check for end of list
+   if (ctx->LastDiscrepancy == 0)
+      ctx->LastDevice = TRUE;
+}
 
 //--------------------------------------------------------------------------
 // The 'owFirst' finds the first device on the 1-Wire Net  This function
@@ -72,9 +361,7 @@ uchar SerialNum[MAX_PORTNUM][8];
 SMALLINT owFirst(int portnum, SMALLINT do_reset, SMALLINT alarm_only)
 {
    // reset the search state
-   LastDiscrepancy[portnum] = 0;
-   LastDevice[portnum] = FALSE;
-   LastFamilyDiscrepancy[portnum] = 0;
+   owSearchReset(&SearchCtx[portnum]);
 
    return owNext(portnum,do_reset,alarm_only);
 }
@@ -100,141 +387,24 @@ SMALLINT owFirst(int portnum, SMALLINT do_reset, SMALLINT alarm_only)
 //                       Serial Number placed in the global SerialNum[portnum]
 //            FALSE (0): when no new device was found.  Either the
 //                       last search was the last device or there
-//                       are no devices on the 1-Wire Net.
+//                       are no devices on the 1-Wire Net, or another
+//                       search context of this task runs a pass on the
+//                       port.
 //
 SMALLINT owNext(int portnum, SMALLINT do_reset, SMALLINT alarm_only)
 {
-   uchar bit_test, search_direction, bit_number;
-   uchar last_zero, serial_byte_number, next_result;
-   uchar serial_byte_mask;
-   uchar lastcrc8;
-
-   // initialize for search
-   bit_number = 1;
-   last_zero = 0;
-   serial_byte_number = 0;
-   serial_byte_mask = 1;
-   next_result = 0;
-   setcrc8(portnum,0);
-
-   // if the last call was not the last one
-   if (!LastDevice[portnum])
-   {
-      // check if reset first is requested
-      if (do_reset)
-      {
-         // reset the 1-wire
-         // if there are no parts on 1-wire, return FALSE
-         if (!owTouchReset(portnum))
-         {
-            // printf("owTouchReset failed\r\n");
-            // reset the search
-            LastDiscrepancy[portnum] = 0;
-            LastFamilyDiscrepancy[portnum] = 0;
-            OWERROR(OWERROR_NO_DEVICES_ON_NET);
-            return FALSE;
-         }
-      }
-
-      // If finding alarming devices issue a different command
-      if (alarm_only)
-         owWriteByte(portnum,0xEC);  // issue the alarming search command
-      else
-         owWriteByte(portnum,0xF0);  // issue the search command
-
-      //pause before beginning the search
-      //usDelay(100);
-
-      // loop to do the search
-      do
-      {
-         // read a bit and its compliment
-         bit_test = owTouchBit(portnum,1) << 1;
-         bit_test |= owTouchBit(portnum,1);
-
-         // check for no devices on 1-wire
-         if (bit_test == 3)
-            break;
-         else
-         {
-            // all devices coupled have 0 or 1
-            if (bit_test > 0)
-              search_direction = !(bit_test & 0x01);  // bit write value for search
-            else
-            {
-               // if this discrepancy if before the Last Discrepancy
-               // on a previous next then pick the same as last time
-               if (bit_number < LastDiscrepancy[portnum])
-                  search_direction = ((SerialNum[portnum][serial_byte_number] & serial_byte_mask) > 0);
-               else
-                  // if equal to last pick 1, if not then pick 0
-                  search_direction = (bit_number == LastDiscrepancy[portnum]);
-
-               // if 0 was picked then record its position in LastZero
-               if (search_direction == 0)
-               {
-                  last_zero = bit_number;
-
-                  // check for Last discrepancy in family
-                  if (last_zero < 9)
-                     LastFamilyDiscrepancy[portnum] = last_zero;
-               }
-            }
-
-            // set or clear the bit in the SerialNum[portnum] byte serial_byte_number
-            // with mask serial_byte_mask
-            if (search_direction == 1)
-              SerialNum[portnum][serial_byte_number] |= serial_byte_mask;
-            else
-              SerialNum[portnum][serial_byte_number] &= ~serial_byte_mask;
-
-            // serial number search direction write bit
-            owTouchBit(portnum,search_direction);
-
-            // increment the byte counter bit_number
-            // and shift the mask serial_byte_mask
-            bit_number++;
-            serial_byte_mask <<= 1;
-
-            // if the mask is 0 then go to new SerialNum[portnum] byte serial_byte_number
-            // and reset mask
-            if (serial_byte_mask == 0)
-            {
-               // The below has been added to accomidate the valid CRC with the
-               // possible changing serial number values of the DS28E04.
-               if (((SerialNum[portnum][0] & 0x7F) == 0x1C) && (serial_byte_number == 1))
-                  lastcrc8 = docrc8(portnum,0x7F);
-               else
-                  lastcrc8 = docrc8(portnum,SerialNum[portnum][serial_byte_number]);  // accumulate the CRC
-
-               serial_byte_number++;
-               serial_byte_mask = 1;
-            }
-         }
-      }
-      while(serial_byte_number < 8);  // loop until through all SerialNum[portnum] bytes 0-7
-
-      // if the search was successful then
-      if (!((bit_number < 65) || lastcrc8))
-      {
-         // search successful so set LastDiscrepancy[portnum],LastDevice[portnum],next_result
-         LastDiscrepancy[portnum] = last_zero;
-         LastDevice[portnum] = (LastDiscrepancy[portnum] == 0);
-         next_result = TRUE;
-      }
-   }
-
-   // if no device found then reset counters so next 'next' will be
-   // like a first
-   if (!next_result || !SerialNum[portnum][0])
-   {
-      LastDiscrepancy[portnum] = 0;
-      LastDevice[portnum] = FALSE;
-      LastFamilyDiscrepancy[portnum] = 0;
-      next_result = FALSE;
-   }
-
-   return next_result;
+   owSearchContext *ctx = &SearchCtx[portnum];
+   SMALLINT result;
+
+   // run a whole pass of the port search context
+   ctx->portnum = portnum;
+   ctx->do_reset = do_reset;
+   ctx->alarm_only = alarm_only;
+   do
+      result = owSearchStep(ctx);
+   while (result == OWSEARCH_MORE);
+
+   return (result == OWSEARCH_FOUND);
 }
 
 //--------------------------------------------------------------------------
@@ -263,13 +433,13 @@ void owSerialNum(int portnum, uchar *serialnum_buf, SMALLINT do_read)
    if (do_read)
    {
       for (i = 0; i < 8; i++)
-         serialnum_buf[i] = SerialNum[portnum][i];
+         serialnum_buf[i] = SearchCtx[portnum].SerialNum[i];
    }
    // set the internal buffer from the data in 'serialnum_buf'
    else
    {
       for (i = 0; i < 8; i++)
-         SerialNum[portnum][i] = serialnum_buf[i];
+         SearchCtx[portnum].SerialNum[i] = serialnum_buf[i];
    }
 }
 
@@ -284,14 +454,7 @@ void owSerialNum(int portnum, uchar *serialnum_buf, SMALLINT do_read)
 //
 void owFamilySearchSetup(int portnum, SMALLINT search_family)
 {
-   uchar i;
-
-   // set the search state to find SearchFamily type devices
-   SerialNum[portnum][0] = search_family;
-   for (i = 1; i < 8; i++)
-      SerialNum[portnum][i] = 0;
-   LastDiscrepancy[portnum] = 64;
-   LastDevice[portnum] = FALSE;
+   owSearchFamily(&SearchCtx[portnum],search_family);
 }
 
 //--------------------------------------------------------------------------
@@ -302,13 +465,7 @@ void owFamilySearchSetup(int portnum, SMALLINT search_family)
 //
 void owSkipFamily(int portnum)
 {
-   // set the Last discrepancy to last family discrepancy
-   LastDiscrepancy[portnum] = LastFamilyDiscrepancy[portnum];
-   LastFamilyDiscrepancy[portnum] = 0;
-
-   // check for end of list
-   if (LastDiscrepancy[portnum] == 0)
-      LastDevice[portnum] = TRUE;
+   owSearchSkipFamily(&SearchCtx[portnum]);
 }
 
 //--------------------------------------------------------------------------
@@ -326,10 +483,25 @@ void owSkipFamily(int portnum)
 //                       are not correct.
 //
 SMALLINT owAccess(int portnum)
+{
+   SMALLINT rt = owAccessMatch(portnum);
+
+   // update the device registry
+   owDevNotify(portnum, SearchCtx[portnum].SerialNum, rt ? OWDEV_ACCESS : OWDEV_FAILED);
+   return rt;
+}
+
+//--------------------------------------------------------------------------
+// Reset and match ROM of 'owAccess'.
+//
+static SMALLINT owAccessMatch(int portnum)
 {
    uchar sendpacket[9];
    uchar i;
 
+   // reset and match are a single bus transaction
+   owLock(portnum);
+
    // reset the 1-wire
    if (owTouchReset(portnum))
    {
@@ -338,15 +510,19 @@ SMALLINT owAccess(int portnum)
       sendpacket[0] = 0x55;
       // Serial Number
       for (i = 1; i < 9; i++)
-         sendpacket[i] = SerialNum[portnum][i-1];
+         sendpacket[i] = SearchCtx[portnum].SerialNum[i-1];
 
       // send/recieve the transfer buffer
       if (owBlock(portnum,FALSE,sendpacket,9))
       {
          // verify that the echo of the writes was correct
          for (i = 1; i < 9; i++)
-            if (sendpacket[i] != SerialNum[portnum][i-1])
+            if (sendpacket[i] != SearchCtx[portnum].SerialNum[i-1])
+            {
+               owUnlock(portnum);
                return FALSE;
+            }
+         owUnlock(portnum);
          if (sendpacket[0] != 0x55)
          {
             OWERROR(OWERROR_WRITE_VERIFY_FAILED);
@@ -362,6 +538,7 @@ SMALLINT owAccess(int portnum)
       OWERROR(OWERROR_NO_DEVICES_ON_NET);
 
    // reset or match echo failed
+   owUnlock(portnum);
    return FALSE;
 }
 
@@ -403,7 +580,7 @@ SMALLINT owVerify(int portnum, SMALLINT alarm_only)
       sendpacket[sendlen++] = 0xFF;
    // now set or clear apropriate bits for search
    for (i = 0; i < 64; i++)
-      bitacc(WRITE_FUNCTION,bitacc(READ_FUNCTION,0,i,&SerialNum[portnum][0]),(int)((i+1)*3-1),&sendpacket[1]);
+      bitacc(WRITE_FUNCTION,bitacc(READ_FUNCTION,0,i,&SearchCtx[portnum].SerialNum[0]),(int)((i+1)*3-1),&sendpacket[1]);
 
    // send/recieve the transfer buffer
    if (owBlock(portnum,TRUE,sendpacket,sendlen))
@@ -414,7 +591,7 @@ SMALLINT owVerify(int portnum, SMALLINT alarm_only)
          tst = (bitacc(READ_FUNCTION,0,i,&sendpacket[1]) << 1) |
                 bitacc(READ_FUNCTION,0,(int)(i+1),&sendpacket[1]);
 
-         s = bitacc(READ_FUNCTION,0,cnt++,&SerialNum[portnum][0]);
+         s = bitacc(READ_FUNCTION,0,cnt++,&SearchCtx[portnum].SerialNum[0]);
 
          if (tst == 0x03)  // no device on line
          {
@@ -457,6 +634,9 @@ SMALLINT owOverdriveAccess(int portnum)
    uchar sendpacket[8];
    uchar i, bad_echo = FALSE;
 
+   // level, speed changes, reset and match are a single bus transaction
+   owLock(portnum);
+
    // make sure normal level
    owLevel(portnum,MODE_NORMAL);
 
@@ -475,18 +655,22 @@ SMALLINT owOverdriveAccess(int portnum)
          // create a buffer to use with block function
          // Serial Number
          for (i = 0; i < 8; i++)
-            sendpacket[i] = SerialNum[portnum][i];
+            sendpacket[i] = SearchCtx[portnum].SerialNum[i];
 
          // send/recieve the transfer buffer
          if (owBlock(portnum,FALSE,sendpacket,8))
          {
             // verify that the echo of the writes was correct
             for (i = 0; i < 8; i++)
-               if (sendpacket[i] != SerialNum[portnum][i])
+               if (sendpacket[i] != SearchCtx[portnum].SerialNum[i])
                   bad_echo = TRUE;
             // if echo ok then success
             if (!bad_echo)
+            {
+               owDevNotify(portnum, SearchCtx[portnum].SerialNum, OWDEV_OVERDRIVE);
+               owUnlock(portnum);
                return TRUE;
+            }
             else
                OWERROR(OWERROR_WRITE_VERIFY_FAILED);
          }
@@ -502,6 +686,7 @@ SMALLINT owOverdriveAccess(int portnum)
    // failure, force back to normal communication speed
    owSpeed(portnum,MODE_NORMAL);
 
+   owUnlock(portnum);
    return FALSE;
 }
 
@@ -35,8 +35,6 @@
 #include "ownet.h"
 #include "sockit_owm.h"
 
-extern sockit_owm_state sockit_owm;
-
 // local function prototypes
 SMALLINT owAcquire(int,char *);
 void     owRelease(int);
@@ -46,7 +44,10 @@ void     owRelease(int);
 //
 // 'portnum'    - number 0 to MAX_PORTNUM-1.  This number is provided to
 //                indicate the symbolic port number.
-// 'port_zstr'  - zero terminated port name.
+// 'port_zstr'  - zero terminated port name, the device name of the
+//                controller instance optionally followed by ':' and the
+//                port select ("/dev/sockit_owm_1:2" or "sockit_owm_1:2"),
+//                NULL or an empty string keeps the default port map.
 //
 // Returns: TRUE - success, port opened
 //
@@ -55,18 +56,28 @@ void     owRelease(int);
 //
 SMALLINT owAcquire(int portnum, char *port_zstr)
 {
-   // check if there are enough ports available
-   if (sockit_owm.own <= portnum) {
+   sockit_owm_state *owm;
+   int sel;
+
+   // an acquired port can not be bound again
+   if ((portnum >= 0) && (portnum < MAX_PORTNUM) && (owm = SOCKIT_OWM(portnum)) != NULL) {
+      if ((owm->use >> SOCKIT_OWM_SEL(portnum)) & 0x1)
+         return FALSE;
+   }
+   // check if the port can be bound to an instance
+   if (sockit_owm_bind(portnum, port_zstr)) {
       // TODO some error message might be added
       return FALSE;
    }
+   owm = SOCKIT_OWM(portnum);
+   sel = SOCKIT_OWM_SEL(portnum);
    // check if port is already in use
-   if ((sockit_owm.use >> portnum) & 0x1) {
+   if ((owm->use >> sel) & 0x1) {
       return FALSE;
    }
    // if it is unused take it
    else {
-      sockit_owm.use |= (0x1 << portnum);
+      owm->use |= (0x1 << sel);
       return TRUE;
    }
 }
@@ -79,9 +90,12 @@ SMALLINT owAcquire(int portnum, char *port_zstr)
 //
 void owRelease(int portnum)
 {
+   sockit_owm_state *owm = SOCKIT_OWM(portnum);
+   int sel = SOCKIT_OWM_SEL(portnum);
+
    // check if port is already in use and release it
-   if ((sockit_owm.use >> portnum) & 0x1) {
-      sockit_owm.use &= ~(0x1 << portnum);
+   if ((owm->use >> sel) & 0x1) {
+      owm->use &= ~(0x1 << sel);
    }
    // releasing an unused port is not supported
    else {
@@ -0,0 +1,576 @@
+//////////////////////////////////////////////////////////////////////////////
+//                                                                          //
+//  Minimalistic 1-wire (onewire) master with Avalon MM bus interface       //
+//                                                                          //
+//  Copyright (C) 2010  Iztok Jeras                                         //
+//                                                                          //
+//////////////////////////////////////////////////////////////////////////////
+//                                                                          //
+//  This program is free software: you can redistribute it and/or modify    //
+//  it under the terms of the GNU Lesser General Public License             //
+//  as published by the Free Software Foundation, either                    //
+//  version 3 of the License, or (at your option) any later version.        //
+//                                                                          //
+//  This program is distributed in the hope that it will be useful,         //
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of          //
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the           //
+//  GNU General Public License for more details.                            //
+//                                                                          //
+//  You should have received a copy of the GNU General Public License       //
+//  along with this program.  If not, see <http://www.gnu.org/licenses/>.   //
+//                                                                          //
+//////////////////////////////////////////////////////////////////////////////
+
+
+
+#include <string.h>
+
+#include "sys/alt_irq.h"
+
+#include "ownet.h"
+#include "owtemp.h"
+#include "owdev.h"
+
+// power mode of the devices on each port, from TempProbePower, valid while
+// no device is added to the port (owDevAdded)
+static SMALLINT TempPortPower[MAX_PORTNUM];
+static ushort   TempPortAdded[MAX_PORTNUM];
+
+// power mode and configuration register of recently used devices, used
+// while no device registry is attached, direct mapped on the CRC byte of
+// the ROM number
+typedef struct
+{
+   uchar    rom[8];
+   uchar    power;
+   uchar    config;
+} TempCacheEntry;
+
+static TempCacheEntry TempCache[TEMP_CACHE_SIZE];
+
+// cached items
+#define TEMP_CACHE_POWER    0
+#define TEMP_CACHE_CONFIG   1
+
+//--------------------------------------------------------------------------
+// Cached power mode or configuration register of a device, from the record
+// in the attached registry or from the local cache.
+//
+// 'SerialNum'  - serial number of the device
+// 'item'       - TEMP_CACHE_POWER or TEMP_CACHE_CONFIG
+//
+// Returns:  the cached value, 0 (OWDEV_POWER_UNKNOWN, unknown configuration)
+//           if it is not cached
+//
+static uchar TempCacheGet(uchar *SerialNum, int item)
+{
+   owDev *dev = owDevLookup(SerialNum);
+   TempCacheEntry *c = &TempCache[SerialNum[7] & (TEMP_CACHE_SIZE - 1)];
+   alt_irq_context ctx;
+   uchar value = 0;
+
+   if (dev)
+      return (item == TEMP_CACHE_POWER) ? dev->power : dev->config;
+
+   ctx = alt_irq_disable_all();
+   if (!memcmp(c->rom,SerialNum,8))
+      value = (item == TEMP_CACHE_POWER) ? c->power : c->config;
+   alt_irq_enable_all(ctx);
+   return value;
+}
+
+//--------------------------------------------------------------------------
+// Keep the power mode or the configuration register of a device, in the
+// record of the attached registry or in the local cache, where it replaces
+// the entry of another device.
+//
+// 'SerialNum'  - serial number of the device
+// 'item'       - TEMP_CACHE_POWER or TEMP_CACHE_CONFIG
+// 'value'      - value to keep, 0 forgets it
+//
+static void TempCacheSet(uchar *SerialNum, int item, uchar value)
+{
+   owDev *dev = owDevLookup(SerialNum);
+   TempCacheEntry *c = &TempCache[SerialNum[7] & (TEMP_CACHE_SIZE - 1)];
+   alt_irq_context ctx;
+
+   if (dev)
+   {
+      if (item == TEMP_CACHE_POWER)
+         dev->power = value;
+      else
+         dev->config = value;
+      return;
+   }
+
+   ctx = alt_irq_disable_all();
+   if (memcmp(c->rom,SerialNum,8))
+   {
+      memcpy(c->rom,SerialNum,8);
+      c->power = OWDEV_POWER_UNKNOWN;
+      c->config = 0;
+   }
+   if (item == TEMP_CACHE_POWER)
+      c->power = value;
+   else
+      c->config = value;
+   alt_irq_enable_all(ctx);
+}
+
+//--------------------------------------------------------------------------
+// Returns:  the power mode of the devices on a port from the last probe,
+//           OWDEV_POWER_UNKNOWN if a device was added since
+//
+static SMALLINT TempPortMode(int portnum)
+{
+   if (TempPortAdded[portnum] != owDevAdded(portnum))
+      TempPortPower[portnum] = OWDEV_POWER_UNKNOWN;
+   return TempPortPower[portnum];
+}
+
+//--------------------------------------------------------------------------
+// Decode the temperature of a scratchpad read with a valid CRC, in integer
+// arithmetic.
+//
+// 'family'     - family code of the device
+// 'sp'         - scratchpad, a DS18S20 scratchpad with a count per C of 0
+//                is not valid and must be rejected by the caller
+//
+// Returns:  temperature in 1/16 Celsius
+//
+int TempDecode(uchar family, uchar *sp)
+{
+   int t;
+
+   if (family == 0x10)
+   {
+      // 0.5 C resolution, extended with the count remain and count per C:
+      // T = TEMP_READ - 0.25 + (COUNT_PER_C - COUNT_REMAIN) / COUNT_PER_C
+      t = sp[0] >> 1;
+      if (sp[1] & 0x01)
+         t |= ~0x7F;
+      t *= 16;
+      if (sp[7])
+         t += -4 + ((sp[7] - sp[6]) * 16) / sp[7];
+   }
+   else
+   {
+      t = (sp[1] << 8) | sp[0];
+      if (t & 0x8000)
+         t |= ~0xFFFF;
+   }
+   return t;
+}
+
+//--------------------------------------------------------------------------
+// Read Power Supply of all devices on a port with Skip ROM, parasite
+// powered devices pull the read slot low.  The result is kept for the port,
+// once all devices are known to be externally powered the readers do not
+// query each device.  Meant to be called at discovery time, the result is
+// dropped when a search adds a device to the port.
+//
+// 'portnum'    - number 0 to MAX_PORTNUM-1.  This number is provided to
+//                indicate the symbolic port number.
+//
+// Returns:  OWDEV_POWER_EXTERNAL all devices are externally powered,
+//           OWDEV_POWER_PARASITE at least one is parasite powered,
+//           OWDEV_POWER_UNKNOWN no device answered the reset
+//
+SMALLINT TempProbePower(int portnum)
+{
+   SMALLINT power = OWDEV_POWER_UNKNOWN;
+
+   // a device added during the probe invalidates the result
+   TempPortAdded[portnum] = owDevAdded(portnum);
+
+   owLock(portnum);
+   if (owTouchReset(portnum) && owWriteByte(portnum,0xCC) && owWriteByte(portnum,0xB4))
+      power = owTouchBit(portnum,1) ? OWDEV_POWER_EXTERNAL : OWDEV_POWER_PARASITE;
+   owUnlock(portnum);
+
+   TempPortPower[portnum] = power;
+   return power;
+}
+
+//--------------------------------------------------------------------------
+// Power mode of a device.  It is taken from the attached device registry
+// (the local cache if none is attached) or the port probe, else the device
+// is queried with Read Power Supply and the result is cached.
+//
+// 'portnum'    - number 0 to MAX_PORTNUM-1.  This number is provided to
+//                indicate the symbolic port number.
+// 'SerialNum'  - serial number of the device
+//
+// Returns:  OWDEV_POWER_EXTERNAL, OWDEV_POWER_PARASITE or
+//           OWDEV_POWER_UNKNOWN if the device did not answer
+//
+SMALLINT TempPowerMode(int portnum, uchar *SerialNum)
+{
+   SMALLINT power = TempCacheGet(SerialNum,TEMP_CACHE_POWER);
+
+   if (power != OWDEV_POWER_UNKNOWN)
+      return power;
+
+   if (TempPortMode(portnum) == OWDEV_POWER_EXTERNAL)
+      power = OWDEV_POWER_EXTERNAL;
+   else
+   {
+      owLock(portnum);
+      owSerialNum(portnum,SerialNum,FALSE);
+      if (owAccess(portnum) && owWriteByte(portnum,0xB4))
+         power = owTouchBit(portnum,1) ? OWDEV_POWER_EXTERNAL : OWDEV_POWER_PARASITE;
+      owUnlock(portnum);
+   }
+
+   TempCacheSet(SerialNum,TEMP_CACHE_POWER,power);
+   return power;
+}
+
+//--------------------------------------------------------------------------
+// Start a conversion on all devices of a port with Skip ROM + Convert T.
+// The strong pull-up is enabled if any device reports parasite power, the
+// port is probed unless that is already known.
+//
+// Returns:  TRUE (1) the conversion was started, the strong pull-up is on
+//           if '*parasite' is TRUE (1)
+//
+static SMALLINT TempConvertAll(int portnum, SMALLINT *parasite)
+{
+   if (TempPortMode(portnum) == OWDEV_POWER_UNKNOWN)
+      TempProbePower(portnum);
+   *parasite = (TempPortPower[portnum] != OWDEV_POWER_EXTERNAL);
+
+   // convert T
+   if (!owTouchReset(portnum) || !owWriteByte(portnum,0xCC))
+      return FALSE;
+   if (*parasite)
+      return owWriteBytePower(portnum,0x44);
+   return owWriteByte(portnum,0x44);
+}
+
+//--------------------------------------------------------------------------
+// Read the scratchpad of a device.
+//
+// 'portnum'    - number 0 to MAX_PORTNUM-1.  This number is provided to
+//                indicate the symbolic port number.
+// 'SerialNum'  - serial number of the device
+// 'sp'         - buffer for the 9 scratchpad bytes
+//
+// Returns:  TRUE (1) the scratchpad was read with a valid CRC
+//
+SMALLINT TempReadScratchpad(int portnum, uchar *SerialNum, uchar *sp)
+{
+   uchar send_block[10],lastcrc8=0xFF;
+   int i;
+
+   // the serial number is set under the port lock
+   owLock(portnum);
+   owSerialNum(portnum,SerialNum,FALSE);
+
+   // read scratchpad command, data bytes and crc8
+   send_block[0] = 0xBE;
+   for (i = 1; i < 10; i++)
+      send_block[i] = 0xFF;
+   if (!owAccess(portnum) || !owBlock(portnum,FALSE,send_block,10))
+   {
+      owUnlock(portnum);
+      return FALSE;
+   }
+   owUnlock(portnum);
+
+   setcrc8(portnum,0);
+   for (i = 1; i < 10; i++)
+      lastcrc8 = docrc8(portnum,sp[i-1] = send_block[i]);
+   return (lastcrc8 == 0x00);
+}
+
+//--------------------------------------------------------------------------
+// Conversion time of a device.
+//
+// 'family'     - family code of the device
+// 'config'     - configuration register (scratchpad byte 4), the DS18S20
+//                has a fixed 12 bit conversion
+//
+// Returns:  worst case conversion time in ms
+//
+int TempConvertTime(uchar family, uchar config)
+{
+   if (family == 0x10)
+      return TEMP_CONVERT_MS;
+   // 93.75 ms at 9 bit resolution, doubled for each additional bit
+   return ((TEMP_CONVERT_MS << ((config >> 5) & 0x03)) + 7) >> 3;
+}
+
+//--------------------------------------------------------------------------
+// Conversion time of a device at its configured resolution.  The
+// configuration register is taken from the attached device registry (the
+// local cache if none is attached), or read from the scratchpad and then
+// cached.
+//
+// 'portnum'    - number 0 to MAX_PORTNUM-1.  This number is provided to
+//                indicate the symbolic port number.
+// 'SerialNum'  - serial number of the device
+//
+// Returns:  conversion time in ms, the worst case if the configuration
+//           could not be read
+//
+int TempDeviceConvertTime(int portnum, uchar *SerialNum)
+{
+   uchar config, sp[9];
+
+   if (SerialNum[0] == 0x10)
+      return TEMP_CONVERT_MS;
+
+   config = TempCacheGet(SerialNum,TEMP_CACHE_CONFIG);
+   if (config)
+      return TempConvertTime(SerialNum[0],config);
+
+   if (!TempReadScratchpad(portnum,SerialNum,sp))
+      return TEMP_CONVERT_MS;
+   TempCacheSet(SerialNum,TEMP_CACHE_CONFIG,sp[4]);
+   return TempConvertTime(SerialNum[0],sp[4]);
+}
+
+//--------------------------------------------------------------------------
+// Wait for a conversion started with Convert T.  Externally powered devices
+// hold the read slots low until the conversion is complete, so the bus is
+// polled every SOCKIT_OWM_TEMP_POLL ms.  The conversion is only taken as
+// complete after two consecutive '1' read slots, a single slot read as '1'
+// by a glitch would return the previous scratchpad.  Parasite powered
+// devices can not signal completion, the strong pull-up is held for the
+// conversion time and then turned off.
+//
+// 'portnum'    - number 0 to MAX_PORTNUM-1.  This number is provided to
+//                indicate the symbolic port number.
+// 'parasite'   - TRUE (1) the strong pull-up is on
+// 'ms'         - conversion time, the polling timeout
+//
+// Returns:  TRUE (1) the conversion is complete
+//
+SMALLINT TempConvertWait(int portnum, SMALLINT parasite, int ms)
+{
+   int t;
+
+   if (parasite)
+   {
+      owDelay(portnum,ms);
+      return (owLevel(portnum,MODE_NORMAL) == MODE_NORMAL);
+   }
+
+   for (t = 0; ; t += SOCKIT_OWM_TEMP_POLL)
+   {
+      if (owTouchBit(portnum,1) && owTouchBit(portnum,1))
+         return TRUE;
+      if (t >= ms)
+         return FALSE;
+      owDelay(portnum,SOCKIT_OWM_TEMP_POLL);
+   }
+}
+
+//--------------------------------------------------------------------------
+// Read the temperature of a list of devices, on one or several ports, with
+// a single conversion.  All devices on the listed ports convert at the same
+// time, so a sweep costs one conversion time plus a scratchpad read per
+// device instead of a conversion per device.  The resolution of the devices
+// is not known, ports with parasite powered devices wait for the 12 bit
+// conversion time.  The listed ports are locked in ascending order for the
+// whole sweep.
+//
+// 'rd'         - list of devices, 'portnum' and 'SerialNum' are inputs,
+//                'Temp' and 'ok' are the results
+// 'num'        - number of list entries
+//
+// Returns:  number of temperatures read and verified
+//
+int ReadTemperatures(TempReading *rd, int num)
+{
+   SMALLINT used[MAX_PORTNUM], conv[MAX_PORTNUM], parasite[MAX_PORTNUM];
+   uchar sp[9];
+   int portnum, i, wait = -1, cnt = 0;
+
+   for (portnum = 0; portnum < MAX_PORTNUM; portnum++)
+      used[portnum] = conv[portnum] = parasite[portnum] = FALSE;
+   for (i = 0; i < num; i++)
+   {
+      rd[i].ok = FALSE;
+      if ((rd[i].portnum >= 0) && (rd[i].portnum < MAX_PORTNUM))
+         used[rd[i].portnum] = TRUE;
+   }
+
+   // start the conversion on all ports
+   for (portnum = 0; portnum < MAX_PORTNUM; portnum++)
+   {
+      if (!used[portnum])
+         continue;
+      owLock(portnum);
+      conv[portnum] = TempConvertAll(portnum,&parasite[portnum]);
+      if (conv[portnum] && parasite[portnum] && (wait < 0))
+         wait = portnum;
+   }
+
+   // wait once for the ports with parasite powered devices (on the
+   // controller of the first one), the other ports are polled, the
+   // conversions run in parallel
+   if (wait >= 0)
+      owDelay(wait,TEMP_CONVERT_MS);
+   for (portnum = 0; portnum < MAX_PORTNUM; portnum++)
+   {
+      if (!conv[portnum])
+         continue;
+      if (parasite[portnum])
+         conv[portnum] = (owLevel(portnum,MODE_NORMAL) == MODE_NORMAL);
+      else
+         conv[portnum] = TempConvertWait(portnum,FALSE,TEMP_CONVERT_MS);
+   }
+
+   for (i = 0; i < num; i++)
+   {
+      portnum = rd[i].portnum;
+      if ((portnum < 0) || (portnum >= MAX_PORTNUM) || !conv[portnum])
+         continue;
+      rd[i].ok = TempReadScratchpad(portnum,rd[i].SerialNum,sp);
+      // the DS18S20 count per C is never 0, reject it like the single reader
+      if (rd[i].ok && (rd[i].SerialNum[0] == 0x10) && (sp[7] == 0))
+         rd[i].ok = FALSE;
+      if (rd[i].ok)
+      {
+         rd[i].Temp = TempDecode(rd[i].SerialNum[0],sp);
+         cnt++;
+      }
+   }
+
+   for (portnum = MAX_PORTNUM - 1; portnum >= 0; portnum--)
+      if (used[portnum])
+         owUnlock(portnum);
+   return cnt;
+}
+
+//--------------------------------------------------------------------------
+// Write the alarm thresholds and the resolution to the scratchpad, they
+// take effect right away and are kept in EEPROM by 'TempCopyConfig'.
+//
+// 'portnum'    - number 0 to MAX_PORTNUM-1.  This number is provided to
+//                indicate the symbolic port number.
+// 'SerialNum'  - serial number of the device
+// 'th', 'tl'   - high and low alarm thresholds in Celsius (-128 to 127)
+// 'bits'       - resolution, 9 to 12 bits (not used by the DS18S20)
+//
+// Returns:  TRUE (1) the scratchpad was written
+//
+SMALLINT TempWriteConfig(int portnum, uchar *SerialNum, int th, int tl, int bits)
+{
+   uchar send_block[4];
+   int send_cnt = 0;
+
+   if ((th < -128) || (th > 127) || (tl < -128) || (tl > 127) || (bits < 9) || (bits > 12))
+      return FALSE;
+
+   // write scratchpad, the DS18S20 has no configuration register
+   send_block[send_cnt++] = 0x4E;
+   send_block[send_cnt++] = (uchar)th;
+   send_block[send_cnt++] = (uchar)tl;
+   if (SerialNum[0] != 0x10)
+      send_block[send_cnt++] = (uchar)(((bits - 9) << 5) | 0x1F);
+
+   owLock(portnum);
+   owSerialNum(portnum,SerialNum,FALSE);
+   if (!owAccess(portnum) || !owBlock(portnum,FALSE,send_block,send_cnt))
+   {
+      owUnlock(portnum);
+      return FALSE;
+   }
+   owUnlock(portnum);
+
+   if (SerialNum[0] != 0x10)
+      TempCacheSet(SerialNum,TEMP_CACHE_CONFIG,send_block[3]);
+   return TRUE;
+}
+
+//--------------------------------------------------------------------------
+// Read the alarm thresholds and the resolution from the scratchpad.
+//
+// 'portnum'    - number 0 to MAX_PORTNUM-1.  This number is provided to
+//                indicate the symbolic port number.
+// 'SerialNum'  - serial number of the device
+// 'th', 'tl'   - high and low alarm thresholds in Celsius
+// 'bits'       - resolution, 9 to 12 bits (9 for the DS18S20)
+//
+// Returns:  TRUE (1) the scratchpad was read with a valid CRC
+//
+SMALLINT TempReadConfig(int portnum, uchar *SerialNum, int *th, int *tl, int *bits)
+{
+   uchar sp[9];
+
+   owLock(portnum);
+   if (!TempReadScratchpad(portnum,SerialNum,sp))
+   {
+      owUnlock(portnum);
+      return FALSE;
+   }
+   owUnlock(portnum);
+
+   *th = (sp[2] & 0x80) ? (sp[2] | ~0xFF) : sp[2];
+   *tl = (sp[3] & 0x80) ? (sp[3] | ~0xFF) : sp[3];
+   if (SerialNum[0] == 0x10)
+      *bits = 9;
+   else
+   {
+      *bits = 9 + ((sp[4] >> 5) & 0x03);
+      TempCacheSet(SerialNum,TEMP_CACHE_CONFIG,sp[4]);
+   }
+   return TRUE;
+}
+
+//--------------------------------------------------------------------------
+// Copy the alarm thresholds and the configuration from the scratchpad to
+// EEPROM, parasite powered devices get the strong pull-up for the write.
+//
+// 'portnum'    - number 0 to MAX_PORTNUM-1.  This number is provided to
+//                indicate the symbolic port number.
+// 'SerialNum'  - serial number of the device
+//
+// Returns:  TRUE (1) the copy is complete
+//
+SMALLINT TempCopyConfig(int portnum, uchar *SerialNum)
+{
+   SMALLINT parasite, rt = FALSE;
+
+   owLock(portnum);
+   parasite = (TempPowerMode(portnum,SerialNum) != OWDEV_POWER_EXTERNAL);
+
+   // copy scratchpad
+   owSerialNum(portnum,SerialNum,FALSE);
+   if (owAccess(portnum))
+   {
+      if (parasite ? owWriteBytePower(portnum,0x48) : owWriteByte(portnum,0x48))
+         rt = TempConvertWait(portnum,parasite,TEMP_COPY_MS);
+   }
+
+   owUnlock(portnum);
+   return rt;
+}
+
+//--------------------------------------------------------------------------
+// Recall the alarm thresholds and the configuration from EEPROM to the
+// scratchpad.
+//
+// 'portnum'    - number 0 to MAX_PORTNUM-1.  This number is provided to
+//                indicate the symbolic port number.
+// 'SerialNum'  - serial number of the device
+//
+// Returns:  TRUE (1) the recall is complete
+//
+SMALLINT TempRecallConfig(int portnum, uchar *SerialNum)
+{
+   SMALLINT rt = FALSE;
+
+   owLock(portnum);
+   owSerialNum(portnum,SerialNum,FALSE);
+   if (owAccess(portnum) && owWriteByte(portnum,0xB8))
+      rt = TempConvertWait(portnum,FALSE,TEMP_COPY_MS);
+   owUnlock(portnum);
+
+   // the configuration is not known until read back
+   TempCacheSet(SerialNum,TEMP_CACHE_CONFIG,0);
+   return rt;
+}
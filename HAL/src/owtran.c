@@ -67,11 +67,15 @@ SMALLINT owBlock(int portnum, SMALLINT do_reset, uchar *tran_buf, SMALLINT tran_
       return FALSE;
    }
 
+   // the block is a single bus transaction
+   owLock(portnum);
+
    // check if need to do a owTouchReset first
    if (do_reset)
    {
       if (!owTouchReset(portnum))
       {
+         owUnlock(portnum);
          OWERROR(OWERROR_NO_DEVICES_ON_NET);
          return FALSE;
       }
@@ -81,6 +85,7 @@ SMALLINT owBlock(int portnum, SMALLINT do_reset, uchar *tran_buf, SMALLINT tran_
    for (i = 0; i < tran_len; i++)
       tran_buf[i] = (uchar)owTouchByte(portnum,tran_buf[i]);
 
+   owUnlock(portnum);
    return TRUE;
 }
 
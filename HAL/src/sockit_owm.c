@@ -36,15 +36,125 @@
 // but due to global variables in the public domain kit, this is not possible
 //#include <fcntl.h>
 
+#include <string.h>
+#include <stdlib.h>
+
 #include "sys/alt_dev.h"
 #include "sys/alt_irq.h"
 #include "sys/ioctl.h"
 #include "sys/alt_errno.h"
 
+#include "ownet.h"
 #include "sockit_owm_regs.h"
 #include "sockit_owm.h"
+#include "sockit_owm_async.h"
+
+//////////////////////////////////////////////////////////////////////////////
+// instance list and port map
+//////////////////////////////////////////////////////////////////////////////
+
+// registered instances
+static sockit_owm_state* sockit_owm_list = NULL;
+
+// portnum to instance/port binding
+sockit_owm_port sockit_owm_map [MAX_PORTNUM];
+
+// register a new instance, its ports are added to the unused entries of
+// the port map
+static void sockit_owm_register (sockit_owm_state* sp)
+{
+  int portnum;
+  alt_u32 sel = 0;
+
+  sp->next = sockit_owm_list;
+  sockit_owm_list = sp;
+  sockit_owm_ctl (sp);
+
+  for (portnum=0; (portnum<MAX_PORTNUM) && (sel<sp->own); portnum++) {
+    if (sockit_owm_map[portnum].owm == NULL) {
+      sockit_owm_map[portnum].owm = sp;
+      sockit_owm_map[portnum].sel = sel++;
+    }
+  }
+}
+
+// the interrupt is enabled only for cycles longer than the spin threshold
+#define SOCKIT_OWM_IEN(sp, t) (((sp)->ien && ((t) > (sp)->spn)) ? SOCKIT_OWM_CTL_IEN_MSK : 0x00)
+
+void sockit_owm_ctl (sockit_owm_state *sp)
+{
+  alt_u32 sel, ovd, ctl;
+
+  for (sel=0; sel<sp->own; sel++) {
+    ovd = (sp->ovd >> sel) & 0x1;
+    ctl = (sp->pwr << SOCKIT_OWM_CTL_POWER_OFST    )
+        | (sel     << SOCKIT_OWM_CTL_SEL_OFST      )
+        | (           SOCKIT_OWM_CTL_CYC_MSK       )
+        | (ovd      ? SOCKIT_OWM_CTL_OVD_MSK : 0x00);
+    sp->ctl[sel] = ctl | SOCKIT_OWM_IEN (sp, ovd ? SOCKIT_OWM_T_BIT_O : SOCKIT_OWM_T_BIT_N);
+    sp->rst[sel] = ctl | SOCKIT_OWM_IEN (sp, ovd ? SOCKIT_OWM_T_RST_O : SOCKIT_OWM_T_RST_N)
+                       | SOCKIT_OWM_CTL_RST_MSK;
+  }
+  // delay cycles run on port 0, the PWR bit follows the port 0 power
+  sp->dly = (sp->pwr << SOCKIT_OWM_CTL_POWER_OFST)
+          | ((sp->pwr & 0x1) ? SOCKIT_OWM_CTL_PWR_MSK : 0x00)
+          | SOCKIT_OWM_CTL_CYC_MSK | SOCKIT_OWM_CTL_DLY_MSK
+          | SOCKIT_OWM_IEN (sp, SOCKIT_OWM_T_DLY);
+}
+
+int sockit_owm_spin (int portnum, int us)
+{
+  sockit_owm_state* sp = SOCKIT_OWM(portnum);
+  int spn = sp->spn;
+
+  if (us >= 0) {
+    sp->spn = us;
+    sockit_owm_ctl (sp);
+  }
+  return spn;
+}
+
+void sockit_owm_wait_stats (int portnum, sockit_owm_wst *wst, int clear)
+{
+  sockit_owm_state* sp = SOCKIT_OWM(portnum);
+
+  if (wst)    *wst = sp->wst;
+  if (clear)  memset (&sp->wst, 0, sizeof (sp->wst));
+}
+
+int sockit_owm_bind (int portnum, const char *port_zstr)
+{
+  sockit_owm_state* sp;
+  const char* sep;
+  const char* base;
+  size_t len;
+  alt_u32 sel = 0;
+
+  if ((portnum < 0) || (portnum >= MAX_PORTNUM))  return -EINVAL;
+
+  // keep the default map
+  if ((port_zstr == NULL) || (*port_zstr == '\0'))
+    return (sockit_owm_map[portnum].owm == NULL) ? -ENODEV : 0;
+
+  // split "name:sel"
+  sep = strchr (port_zstr, ':');
+  len = sep ? (size_t) (sep - port_zstr) : strlen (port_zstr);
+  if (sep)  sel = strtoul (sep+1, NULL, 0);
+
+  // match the full device name, or the name without the directory
+  for (sp=sockit_owm_list; sp!=NULL; sp=sp->next) {
+    base = strrchr (sp->name, '/');
+    base = base ? base+1 : sp->name;
+    if (((strlen (sp->name) == len) && !strncmp (sp->name, port_zstr, len)) ||
+        ((strlen (base    ) == len) && !strncmp (base,     port_zstr, len)))  break;
+  }
+  if (sp == NULL)        return -ENODEV;
+  if (sel >= sp->own)    return -EINVAL;
 
-extern sockit_owm_state sockit_owm;
+  sockit_owm_map[portnum].owm = sp;
+  sockit_owm_map[portnum].sel = sel;
+  return 0;
+}
 
 #ifndef SOCKIT_OWM_POLLING
 
@@ -53,27 +163,33 @@ extern sockit_owm_state sockit_owm;
 //////////////////////////////////////////////////////////////////////////////
 
 #ifdef ALT_ENHANCED_INTERRUPT_API_PRESENT
-static void sockit_owm_irq ();
+static void sockit_owm_irq (void * state);
 #else
-static void sockit_owm_irq (alt_u32 id);
+static void sockit_owm_irq (void * state, alt_u32 id);
 #endif
 
-void sockit_owm_init (alt_u32 irq)
+void sockit_owm_init (sockit_owm_state* sp, alt_u32 irq_controller_id, alt_u32 irq)
 {
   int error;
-  // initialize semaphore for 1-wire cycle locking
-  error = ALT_FLAG_CREATE (sockit_owm.irq, 0) ||
-          ALT_SEM_CREATE  (sockit_owm.cyc, 1);
+  alt_u32 sel;
+  // initialize semaphores for 1-wire cycle and per port transaction locking
+  error = ALT_FLAG_CREATE (&sp->irq, 0) ||
+          ALT_FLAG_CREATE (&sp->evt, 0) ||
+          ALT_SEM_CREATE  (&sp->cyc, 1);
+  for (sel=0; (sel<sp->own) && !error; sel++)
+    error = ALT_SEM_CREATE (&sp->trn[sel], 1);
 
   if (!error) {
     // enable interrupt
-    sockit_owm.ien = 0x1;
-    // register the interrupt handler
+    sp->ien = 0x1;
+    sp->spn = SOCKIT_OWM_SPIN;
+    // register the interrupt handler, the instance is the handler context
 #ifdef ALT_ENHANCED_INTERRUPT_API_PRESENT
-    alt_ic_isr_register (0, irq, sockit_owm_irq, NULL, 0x0);
+    alt_ic_isr_register (irq_controller_id, irq, sockit_owm_irq, sp, 0x0);
 #else
-    alt_irq_register (irq, NULL, sockit_owm_irq);
+    alt_irq_register (irq, sp, sockit_owm_irq);
 #endif
+    sockit_owm_register (sp);
   }
 }
 
@@ -83,10 +199,28 @@ static void sockit_owm_irq(void * state)
 static void sockit_owm_irq(void * state, alt_u32 id)
 #endif
 {
+  sockit_owm_state* sp = (sockit_owm_state*) state;
+  alt_u32 ctl, flg;
   // clear onewire interrupts
-  IORD_SOCKIT_OWM_CTL (sockit_owm.base);
+  ctl = IORD_SOCKIT_OWM_CTL (sp->base);
+  // the flag bit of the port (SEL) the cycle or program was running on
+  flg = 1 << ((ctl & SOCKIT_OWM_CTL_SEL_MSK) >> SOCKIT_OWM_CTL_SEL_OFST);
+  // clear the program end interrupt, and set the flag indicating a completed program
+  if (sp->prg_e) {
+    if (IORD_SOCKIT_OWM_PRG (sp->base) & SOCKIT_OWM_PRG_STS_MSK) {
+      ALT_FLAG_POST (sp->irq, flg, OS_FLAG_SET);
+      return;
+    }
+    // a program end interrupt does not complete a 1-wire cycle
+    if (!(ctl & SOCKIT_OWM_CTL_IRQ_MSK))  return;
+  }
+  // the asynchronous engine owns the controller while transactions are queued
+  if (sp->aqn) {
+    sockit_owm_async_irq (sp, ctl);
+    return;
+  }
   // set the flag indicating a completed 1-wire cycle
-  ALT_FLAG_POST (sockit_owm.irq, 0x1, OS_FLAG_SET);
+  ALT_FLAG_POST (sp->irq, flg, OS_FLAG_SET);
 }
 #else
 
@@ -94,4 +228,20 @@ static void sockit_owm_irq(void * state, alt_u32 id)
 // polling implementation
 //////////////////////////////////////////////////////////////////////////////
 
+void sockit_owm_init (sockit_owm_state* sp, alt_u32 irq_controller_id, alt_u32 irq)
+{
+  int error;
+  alt_u32 sel;
+  // initialize semaphores for 1-wire cycle and per port transaction locking
+  error = ALT_SEM_CREATE (&sp->cyc, 1);
+  for (sel=0; (sel<sp->own) && !error; sel++)
+    error = ALT_SEM_CREATE (&sp->trn[sel], 1);
+
+  if (!error) {
+    // the polling driver always spins, the threshold is only reported
+    sp->spn = SOCKIT_OWM_SPIN;
+    sockit_owm_register (sp);
+  }
+}
+
 #endif
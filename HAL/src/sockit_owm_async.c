@@ -0,0 +1,262 @@
+//////////////////////////////////////////////////////////////////////////////
+//                                                                          //
+//  Minimalistic 1-wire (onewire) master with Avalon MM bus interface       //
+//                                                                          //
+//  Copyright (C) 2010  Iztok Jeras                                         //
+//                                                                          //
+//////////////////////////////////////////////////////////////////////////////
+//                                                                          //
+//  This program is free software: you can redistribute it and/or modify    //
+//  it under the terms of the GNU Lesser General Public License             //
+//  as published by the Free Software Foundation, either                    //
+//  version 3 of the License, or (at your option) any later version.        //
+//                                                                          //
+//  This program is distributed in the hope that it will be useful,         //
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of          //
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the           //
+//  GNU General Public License for more details.                            //
+//                                                                          //
+//  You should have received a copy of the GNU General Public License       //
+//  along with this program.  If not, see <http://www.gnu.org/licenses/>.   //
+//                                                                          //
+//////////////////////////////////////////////////////////////////////////////
+
+
+
+#include "sys/alt_errno.h"
+#include "sys/alt_irq.h"
+
+#include "sockit_owm_regs.h"
+#include "sockit_owm.h"
+#include "sockit_owm_async.h"
+#include "sockit_owm_lnk.h"
+#include "ownet.h"
+
+//////////////////////////////////////////////////////////////////////////////
+// transaction engine
+//////////////////////////////////////////////////////////////////////////////
+
+// transaction phases, in order
+#define SOCKIT_OWM_TXN_RST 0  // reset and presence detect
+#define SOCKIT_OWM_TXN_ROM 1  // match ROM (or skip ROM) command
+#define SOCKIT_OWM_TXN_CMD 2  // command bytes
+#define SOCKIT_OWM_TXN_DLY 3  // delay cycles
+#define SOCKIT_OWM_TXN_RDB 4  // read bytes
+#define SOCKIT_OWM_TXN_END 5
+
+// number of bytes (delay cycles) in the current phase
+static int sockit_owm_async_len (sockit_owm_state *sp, sockit_owm_txn *txn)
+{
+  switch (txn->stp) {
+    case SOCKIT_OWM_TXN_ROM:  return txn->rom ? 9 : 1;
+    case SOCKIT_OWM_TXN_CMD:  return txn->cmd_n;
+    case SOCKIT_OWM_TXN_DLY:  return (txn->dly * sp->f_dly) >> 16;
+    case SOCKIT_OWM_TXN_RDB:  return txn->rd_n;
+  }
+  return 0;
+}
+
+// current byte of a write phase
+static int sockit_owm_async_byte (sockit_owm_txn *txn)
+{
+  switch (txn->stp) {
+    case SOCKIT_OWM_TXN_ROM:
+      if (txn->pos == 0)  return txn->rom ? 0x55 : 0xcc;
+      return txn->rom [txn->pos-1];
+    case SOCKIT_OWM_TXN_CMD:
+      return txn->cmd [txn->pos];
+  }
+  return 0xff;
+}
+
+// start the current cycle of the running transaction
+static void sockit_owm_async_cycle (sockit_owm_state *sp, sockit_owm_txn *txn)
+{
+  alt_u32 ien = sp->ien ? SOCKIT_OWM_CTL_IEN_MSK : 0x00;
+  alt_u32 pwr;
+
+  switch (txn->stp) {
+    case SOCKIT_OWM_TXN_RST:
+      IOWR_SOCKIT_OWM_CTL (sp->base, sp->rst[txn->sel] | ien);
+      break;
+    case SOCKIT_OWM_TXN_DLY:
+      // delay on the transaction port, with the requested strong pull-up
+      pwr = sp->pwr | (txn->pwr ? (1 << txn->sel) : 0);
+      IOWR_SOCKIT_OWM_CTL (sp->base, ( pwr       << SOCKIT_OWM_CTL_POWER_OFST    )
+                                   | ( txn->sel  << SOCKIT_OWM_CTL_SEL_OFST      )
+                                   | ((pwr & 0x1) ? SOCKIT_OWM_CTL_PWR_MSK : 0x00)
+                                   | (              SOCKIT_OWM_CTL_CYC_MSK       )
+                                   | (              SOCKIT_OWM_CTL_DLY_MSK       ) | ien);
+      break;
+    default:
+      // data cycle, the cached control word also ends the strong pull-up
+      if ((txn->stp == SOCKIT_OWM_TXN_RDB) && (txn->bit == 0))  txn->rd [txn->pos] = 0;
+      IOWR_SOCKIT_OWM_CTL (sp->base, sp->ctl[txn->sel] | ien
+                                   | ((sockit_owm_async_byte (txn) >> txn->bit) & SOCKIT_OWM_CTL_DAT_MSK));
+      break;
+  }
+}
+
+// remove the running transaction from the queue and start the next one
+static void sockit_owm_async_done (sockit_owm_state *sp, int sts)
+{
+  sockit_owm_txn *txn = sp->aqh;
+
+  sp->aqh = txn->next;
+  if (sp->aqh == NULL)  sp->aqt = NULL;
+
+  // release the port lock after the last transaction queued for the port,
+  // and the controller lock after the last transaction in the queue
+  if (--sp->aq[txn->sel] == 0) {
+    sp->lck[txn->sel] = 0;
+    sp->tsk[txn->sel] = NULL;
+    ALT_SEM_POST (sp->trn[txn->sel]);
+  }
+  if ((--sp->aqn == 0) && (SOCKIT_OWM_PORTS(sp) > 1))  ALT_SEM_POST (sp->cyc);
+
+  txn->sts = sts;
+  if (txn->cb)  txn->cb (txn);
+  // wake up all tasks waiting for a completion
+  ALT_FLAG_POST (sp->evt, 0x1, OS_FLAG_SET);
+  ALT_FLAG_POST (sp->evt, 0x1, OS_FLAG_CLR);
+
+  if (sp->aqh)  sockit_owm_async_cycle (sp, sp->aqh);
+}
+
+void sockit_owm_async_irq (sockit_owm_state *sp, alt_u32 ctl)
+{
+  sockit_owm_txn *txn = sp->aqh;
+
+  // a cycle is still running (the interrupt was raised by an earlier one)
+  if (ctl & SOCKIT_OWM_CTL_CYC_MSK)  return;
+
+  // store the result of the completed cycle
+  switch (txn->stp) {
+    case SOCKIT_OWM_TXN_RST:
+      if (ctl & SOCKIT_OWM_CTL_DAT_MSK) {
+        // no presence detect
+        sockit_owm_async_done (sp, -EIO);
+        return;
+      }
+      break;
+    case SOCKIT_OWM_TXN_DLY:
+      txn->pos++;
+      break;
+    default:
+      if (txn->stp == SOCKIT_OWM_TXN_RDB)
+        txn->rd [txn->pos] |= (ctl & SOCKIT_OWM_CTL_DAT_MSK) << txn->bit;
+      if (++txn->bit == 8) {
+        txn->bit = 0;
+        txn->pos++;
+      }
+      break;
+  }
+
+  // skip completed and empty phases
+  while ((txn->stp == SOCKIT_OWM_TXN_RST) || (txn->pos >= sockit_owm_async_len (sp, txn))) {
+    txn->stp++;
+    txn->pos = 0;
+    txn->bit = 0;
+    if (txn->stp == SOCKIT_OWM_TXN_END) {
+      sockit_owm_async_done (sp, 0);
+      return;
+    }
+  }
+
+  sockit_owm_async_cycle (sp, txn);
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// queue control
+//////////////////////////////////////////////////////////////////////////////
+
+int sockit_owm_async_submit (sockit_owm_txn *txn)
+{
+  sockit_owm_state *owm;
+  alt_irq_context ctx;
+  alt_u32 sel;
+
+  if ((txn->portnum < 0) || (txn->portnum >= MAX_PORTNUM))  return -EINVAL;
+  if ((owm = SOCKIT_OWM(txn->portnum)) == NULL)             return -ENODEV;
+  if ((txn->cmd_n < 0) || (txn->rd_n < 0) || (txn->dly < 0))  return -EINVAL;
+  sel = SOCKIT_OWM_SEL(txn->portnum);
+
+  txn->sts  = -EINPROGRESS;
+  txn->sel  = sel;
+  txn->stp  = SOCKIT_OWM_TXN_RST;
+  txn->pos  = 0;
+  txn->bit  = 0;
+  txn->next = NULL;
+
+  // the first transaction for a port takes the port lock (with the engine
+  // recorded as the owner), the first transaction in the queue takes the
+  // controller lock, both are released by the engine when the queue drains
+  ctx = alt_irq_disable_all ();
+  if (owm->aq[sel] == 0) {
+    // a task holding the port lock (owLock) would wait for itself
+    if (owm->lck[sel] && (owm->tsk[sel] == SOCKIT_OWM_TASK)) {
+      alt_irq_enable_all (ctx);
+      return -EDEADLK;
+    }
+    alt_irq_enable_all (ctx);
+    sockit_owm_lock (txn->portnum);
+    ctx = alt_irq_disable_all ();
+    owm->tsk[sel] = owm;
+  }
+  if (owm->aqn == 0) {
+    alt_irq_enable_all (ctx);
+    sockit_owm_cyc_lock (owm);
+    ctx = alt_irq_disable_all ();
+  }
+
+  // append, an idle engine is started with the reset cycle
+  owm->aq[sel]++;
+  if (owm->aqn++) {
+    owm->aqt->next = txn;
+    owm->aqt = txn;
+  } else {
+    owm->aqh = owm->aqt = txn;
+    sockit_owm_async_cycle (owm, txn);
+  }
+  alt_irq_enable_all (ctx);
+
+  return 0;
+}
+
+// advance the queue if the current cycle has ended
+static int sockit_owm_async_step (sockit_owm_state *owm)
+{
+  alt_irq_context ctx;
+  int aqn;
+
+  ctx = alt_irq_disable_all ();
+  if (owm->aqn)  sockit_owm_async_irq (owm, IORD_SOCKIT_OWM_CTL (owm->base));
+  aqn = owm->aqn;
+  alt_irq_enable_all (ctx);
+
+  return aqn;
+}
+
+int sockit_owm_async_poll (int portnum)
+{
+  return sockit_owm_async_step (SOCKIT_OWM(portnum));
+}
+
+void sockit_owm_async_drain (sockit_owm_state *sp)
+{
+  while (sockit_owm_async_step (sp));
+}
+
+int sockit_owm_async_wait (sockit_owm_txn *txn)
+{
+  while (txn->sts == -EINPROGRESS) {
+#ifdef SOCKIT_OWM_POLLING
+    sockit_owm_async_poll (txn->portnum);
+#else
+    // the one tick timeout covers a completion between the status check
+    // and the pend
+    ALT_FLAG_PEND (SOCKIT_OWM(txn->portnum)->evt, 0x1, OS_FLAG_WAIT_SET_ANY, 1);
+#endif
+  }
+  return txn->sts;
+}
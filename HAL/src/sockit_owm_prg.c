@@ -0,0 +1,249 @@
+//////////////////////////////////////////////////////////////////////////////
+//                                                                          //
+//  Minimalistic 1-wire (onewire) master with Avalon MM bus interface       //
+//                                                                          //
+//  Copyright (C) 2010  Iztok Jeras                                         //
+//                                                                          //
+//////////////////////////////////////////////////////////////////////////////
+//                                                                          //
+//  This program is free software: you can redistribute it and/or modify    //
+//  it under the terms of the GNU Lesser General Public License             //
+//  as published by the Free Software Foundation, either                    //
+//  version 3 of the License, or (at your option) any later version.        //
+//                                                                          //
+//  This program is distributed in the hope that it will be useful,         //
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of          //
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the           //
+//  GNU General Public License for more details.                            //
+//                                                                          //
+//  You should have received a copy of the GNU General Public License       //
+//  along with this program.  If not, see <http://www.gnu.org/licenses/>.   //
+//                                                                          //
+//////////////////////////////////////////////////////////////////////////////
+
+
+
+#include "sys/alt_errno.h"
+
+#include "sockit_owm_regs.h"
+#include "sockit_owm.h"
+#include "ownet.h"
+#include "sockit_owm_lnk.h"
+#include "sockit_owm_prg.h"
+
+//////////////////////////////////////////////////////////////////////////////
+// assembler
+//////////////////////////////////////////////////////////////////////////////
+
+void sockit_owm_prg_init (sockit_owm_prg *prg, alt_u8 *buf, int max, int org)
+{
+  prg->buf = buf;
+  prg->org = org;
+  prg->len = 0;
+  prg->max = max;
+  prg->err = 0;
+}
+
+// current program memory address, used as a jump label
+int sockit_owm_prg_here (sockit_owm_prg *prg)
+{
+  return prg->org + prg->len;
+}
+
+// append a single byte to the program image
+static void sockit_owm_prg_byte (sockit_owm_prg *prg, int dat)
+{
+  if (prg->len < prg->max)  prg->buf [prg->len++] = (alt_u8) dat;
+  else                      prg->err = 1;
+}
+
+void sockit_owm_prg_end (sockit_owm_prg *prg)
+{
+  sockit_owm_prg_byte (prg, SOCKIT_OWM_OP_END);
+}
+
+void sockit_owm_prg_rst (sockit_owm_prg *prg)
+{
+  sockit_owm_prg_byte (prg, SOCKIT_OWM_OP_RST);
+}
+
+void sockit_owm_prg_wri (sockit_owm_prg *prg, const alt_u8 *dat, int n)
+{
+  int i;
+  sockit_owm_prg_byte (prg, SOCKIT_OWM_OP_WRI);
+  sockit_owm_prg_byte (prg, n);
+  for (i=0; i<n; i++)  sockit_owm_prg_byte (prg, dat[i]);
+}
+
+void sockit_owm_prg_wrp (sockit_owm_prg *prg, int n)
+{
+  sockit_owm_prg_byte (prg, SOCKIT_OWM_OP_WRP);
+  sockit_owm_prg_byte (prg, n);
+}
+
+void sockit_owm_prg_rdp (sockit_owm_prg *prg, int n)
+{
+  sockit_owm_prg_byte (prg, SOCKIT_OWM_OP_RDP);
+  sockit_owm_prg_byte (prg, n);
+}
+
+void sockit_owm_prg_crc (sockit_owm_prg *prg)
+{
+  sockit_owm_prg_byte (prg, SOCKIT_OWM_OP_CRC);
+}
+
+void sockit_owm_prg_dly (sockit_owm_prg *prg, int n)
+{
+  sockit_owm_prg_byte (prg, SOCKIT_OWM_OP_DLY);
+  sockit_owm_prg_byte (prg, n);
+}
+
+void sockit_owm_prg_pwr (sockit_owm_prg *prg, int on)
+{
+  sockit_owm_prg_byte (prg, SOCKIT_OWM_OP_PWR);
+  sockit_owm_prg_byte (prg, on ? 1 : 0);
+}
+
+void sockit_owm_prg_sp0 (sockit_owm_prg *prg, int adr)
+{
+  sockit_owm_prg_byte (prg, SOCKIT_OWM_OP_SP0);
+  sockit_owm_prg_byte (prg, adr);
+}
+
+void sockit_owm_prg_sp1 (sockit_owm_prg *prg, int adr)
+{
+  sockit_owm_prg_byte (prg, SOCKIT_OWM_OP_SP1);
+  sockit_owm_prg_byte (prg, adr);
+}
+
+void sockit_owm_prg_ldc (sockit_owm_prg *prg, int n)
+{
+  sockit_owm_prg_byte (prg, SOCKIT_OWM_OP_LDC);
+  sockit_owm_prg_byte (prg, n);
+}
+
+void sockit_owm_prg_djn (sockit_owm_prg *prg, int adr)
+{
+  sockit_owm_prg_byte (prg, SOCKIT_OWM_OP_DJN);
+  sockit_owm_prg_byte (prg, adr);
+}
+
+void sockit_owm_prg_scratchpads (sockit_owm_prg *prg, int tbl, int num, int dat)
+{
+  const alt_u8 match = 0x55;
+  const alt_u8 read  = 0xbe;
+  int loop;
+
+  sockit_owm_prg_sp0 (prg, tbl);
+  sockit_owm_prg_sp1 (prg, dat);
+  sockit_owm_prg_ldc (prg, num);
+  loop = sockit_owm_prg_here (prg);
+  // match ROM with the next table entry
+  sockit_owm_prg_rst (prg);
+  sockit_owm_prg_wri (prg, &match, 1);
+  sockit_owm_prg_wrp (prg, 8);
+  // read scratchpad and check its CRC
+  sockit_owm_prg_wri (prg, &read, 1);
+  sockit_owm_prg_rdp (prg, 9);
+  sockit_owm_prg_crc (prg);
+  sockit_owm_prg_djn (prg, loop);
+  sockit_owm_prg_end (prg);
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// loader
+//////////////////////////////////////////////////////////////////////////////
+
+// check the program engine is implemented and the address range fits
+static int sockit_owm_prg_check (sockit_owm_state *owm, int adr, int len)
+{
+  if (!owm->prg_e)                                  return -ENODEV;
+  if ((adr < 0) || (adr + len > (1 << owm->paw)))   return -EINVAL;
+  return 0;
+}
+
+int sockit_owm_prg_load (int portnum, int adr, const alt_u8 *buf, int len)
+{
+  sockit_owm_state *owm = SOCKIT_OWM(portnum);
+  int i, error;
+
+  if ((error = sockit_owm_prg_check (owm, adr, len)))  return error;
+
+  // set the memory address, the program is not started
+  IOWR_SOCKIT_OWM_PRG (owm->base, adr << SOCKIT_OWM_PRG_PMA_OFST);
+  // write data (the address is incremented by the controller)
+  for (i=0; i<len; i++)
+    IOWR_SOCKIT_OWM_PMD (owm->base, buf[i]);
+
+  return 0;
+}
+
+int sockit_owm_prg_read (int portnum, int adr, alt_u8 *buf, int len)
+{
+  sockit_owm_state *owm = SOCKIT_OWM(portnum);
+  int i, error;
+
+  if ((error = sockit_owm_prg_check (owm, adr, len)))  return error;
+
+  // set the memory address, the program is not started
+  IOWR_SOCKIT_OWM_PRG (owm->base, adr << SOCKIT_OWM_PRG_PMA_OFST);
+  // read data (the address is incremented by the controller)
+  for (i=0; i<len; i++)
+    buf[i] = IORD_SOCKIT_OWM_PMD (owm->base) & SOCKIT_OWM_PMD_DAT_MSK;
+
+  return 0;
+}
+
+// start the program at 'pc' on port 'portnum', the 1-wire is locked
+// till the end of the program, so each run must be followed by a wait
+int sockit_owm_prg_run (int portnum, int pc, int ovd)
+{
+  sockit_owm_state *owm = SOCKIT_OWM(portnum);
+  int sel = SOCKIT_OWM_SEL(portnum);
+  int error;
+
+  if ((error = sockit_owm_prg_check (owm, pc, 1)))  return error;
+
+  // lock transfer, the program owns the controller till it ends
+  owLock(portnum);
+  sockit_owm_cyc_lock (owm);
+
+  // select the port, without starting a 1-wire cycle, RST and DAT both
+  // set (the idle cycle encoding) keep the line released until the first
+  // cycle of the program
+  IOWR_SOCKIT_OWM_CTL (owm->base, (owm->pwr << SOCKIT_OWM_CTL_POWER_OFST    )
+                                | (sel      << SOCKIT_OWM_CTL_SEL_OFST      )
+                                | (owm->ien  ? SOCKIT_OWM_CTL_IEN_MSK : 0x00)
+                                | (((owm->ovd >> sel) & 0x1) ? SOCKIT_OWM_CTL_OVD_MSK : 0x00)
+                                | ((owm->pwr & 0x1) ? SOCKIT_OWM_CTL_PWR_MSK : 0x00)
+                                | SOCKIT_OWM_CTL_DLY_MSK);
+
+  // start the program
+  IOWR_SOCKIT_OWM_PRG (owm->base, (pc        << SOCKIT_OWM_PRG_PC_OFST      )
+                                | (owm->ien  ? SOCKIT_OWM_PRG_IEN_MSK : 0x00)
+                                | (ovd       ? SOCKIT_OWM_PRG_OVD_MSK : 0x00)
+                                | (            SOCKIT_OWM_PRG_RUN_MSK       ));
+
+  return 0;
+}
+
+// wait for the program end, returns -EIO if the program reported an error
+int sockit_owm_prg_wait (int portnum)
+{
+  sockit_owm_state *owm = SOCKIT_OWM(portnum);
+  alt_u32 reg;
+
+#ifndef SOCKIT_OWM_POLLING
+  int sel = SOCKIT_OWM_SEL(portnum);
+  // wait for irq to set the program end flag of this port
+  ALT_FLAG_PEND (owm->irq, 1 << sel, OS_FLAG_WAIT_SET_ANY + OS_FLAG_CONSUME, 0);
+#endif
+  // wait for the program to stop running
+  while ((reg = IORD_SOCKIT_OWM_PRG (owm->base)) & SOCKIT_OWM_PRG_RUN_MSK);
+
+  // release transfer lock
+  sockit_owm_cyc_unlock (owm);
+  owUnlock(portnum);
+
+  return (reg & SOCKIT_OWM_PRG_ERR_MSK) ? -EIO : 0;
+}
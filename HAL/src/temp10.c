@@ -31,6 +31,7 @@
 //
 #include "ownet.h"
 #include "temp10.h"
+#include "owtemp.h"
 
 //----------------------------------------------------------------------
 // Read the temperature of a DS1920/DS1820 (family code 0x10)
@@ -39,51 +40,59 @@
 //                 OpenCOM to indicate the port number.
 // 'SerialNum'   - Serial Number of DS1920/DS1820 to read temperature from
 // 'Temp '       - pointer to variable where that temperature will be
-//                 returned
+//                 returned, in 1/16 Celsius
 //
 // Returns: TRUE(1)  temperature has been read and verified
 //          FALSE(0) could not read the temperature, perhaps device is not
 //                   in contact
 //
-int ReadTemperature10(int portnum, uchar *SerialNum, float *Temp)
+int ReadTemperature10Int(int portnum, uchar *SerialNum, int *Temp)
 {
    uchar rt=FALSE;
    uchar send_block[30],lastcrc8;
-   int send_cnt, tsht, i, loop=0;
-   float tmp,cr,cpc;
-   int power;
+   int send_cnt, i, loop=0;
+   int cr,cpc;
+   int wait;
+   SMALLINT parasite;
+
+   // convert and read back are a single bus transaction
+   owLock(portnum);
 
    // set the device serial number to the counter device
    owSerialNum(portnum,SerialNum,FALSE);
 
    for (loop = 0; loop < 2; loop ++)
    {
-      // check if the chip is connected to VDD
-      if (owAccess(portnum))
-      {
-         owWriteByte(portnum,0xB4);
-         power = owReadByte(portnum);
-      } 
+      // check if the chip is connected to VDD, the result is cached
+      parasite = (TempPowerMode(portnum,SerialNum) != OWDEV_POWER_EXTERNAL);
+
+      // parasite powered devices are held to the conversion time,
+      // externally powered devices are polled
+      wait = TEMP_CONVERT_MS;
 
       // access the device
       if (owAccess(portnum))
       {
          // send the convert command and if nesessary start power delivery
-         if (power) { 
+         if (parasite) {
             if (!owWriteBytePower(portnum,0x44))
+            {
+               owUnlock(portnum);
                return FALSE;
+            }
          } else {
             if (!owWriteByte(portnum,0x44))
+            {
+               owUnlock(portnum);
                return FALSE;
+            }
          }
 
-         // sleep for 1 second
-         msDelay(1000);
-
-         // turn off the 1-Wire Net strong pull-up
-         if (power) { 
-            if (owLevel(portnum,MODE_NORMAL) != MODE_NORMAL)
-               return FALSE;
+         // wait for the conversion, this turns off the strong pull-up
+         if (!TempConvertWait(portnum,parasite,wait))
+         {
+            owUnlock(portnum);
+            return FALSE;
          }
 
          // access the device
@@ -109,21 +118,19 @@ int ReadTemperature10(int portnum, uchar *SerialNum, float *Temp)
                // verify CRC8 is correct
                if (lastcrc8 == 0x00)
                {
-                  // calculate the high-res temperature
-                  tsht = send_block[1]/2;
-                  if (send_block[2] & 0x01)
-                     tsht |= -128;
-                  tmp = (float)(tsht);
+                  // count remain and count per C
                   cr = send_block[7];
                   cpc = send_block[8];
                   if (((cpc - cr) == 1) && (loop == 0))
                      continue;
                   if (cpc == 0)
+                  {
+                     owUnlock(portnum);
                      return FALSE;
-                  else
-                     tmp = tmp - (float)0.25 + (cpc - cr)/cpc;
+                  }
 
-                  *Temp = tmp;
+                  // calculate the high-res temperature
+                  *Temp = TempDecode(0x10,&send_block[1]);
                   // success
                   rt = TRUE;
                   break;
@@ -135,5 +142,30 @@ int ReadTemperature10(int portnum, uchar *SerialNum, float *Temp)
    }
 
    // return the result flag rt
+   owUnlock(portnum);
    return rt;
 }
+
+//----------------------------------------------------------------------
+// Read the temperature of a DS1920/DS1820 (family code 0x10), floating point
+// version of 'ReadTemperature10Int'.
+//
+// 'portnum'     - number 0 to MAX_PORTNUM-1.  This number was provided to
+//                 OpenCOM to indicate the port number.
+// 'SerialNum'   - Serial Number of DS1920/DS1820 to read temperature from
+// 'Temp '       - pointer to variable where that temperature will be
+//                 returned, in Celsius
+//
+// Returns: TRUE(1)  temperature has been read and verified
+//          FALSE(0) could not read the temperature, perhaps device is not
+//                   in contact
+//
+int ReadTemperature10(int portnum, uchar *SerialNum, float *Temp)
+{
+   int tsht;
+
+   if (!ReadTemperature10Int(portnum,SerialNum,&tsht))
+      return FALSE;
+   *Temp = ((float) tsht)/16;
+   return TRUE;
+}
@@ -31,6 +31,7 @@
 //
 #include "ownet.h"
 #include "temp42.h"
+#include "owtemp.h"
 
 //----------------------------------------------------------------------
 // Read the temperature of a DS28EA00 (family code 0x42)
@@ -39,50 +40,62 @@
 //                 OpenCOM to indicate the port number.
 // 'SerialNum'   - Serial Number of DS18B20 to read temperature from
 // 'Temp '       - pointer to variable where that temperature will be
-//                 returned
+//                 returned, in 1/16 Celsius
 //
 // Returns: TRUE(1)  temperature has been read and verified
 //          FALSE(0) could not read the temperature, perhaps device is not
 //                   in contact
 //
-int ReadTemperature42(int portnum, uchar *SerialNum, float *Temp)
+int ReadTemperature42Int(int portnum, uchar *SerialNum, int *Temp)
 {
    uchar rt=FALSE;
    uchar send_block[30],lastcrc8;
-   int send_cnt, tsht, i, loop=0;
-   int power;
+   int send_cnt, i, loop=0;
+   int wait;
+   SMALLINT parasite;
+
+   // convert and read back are a single bus transaction
+   owLock(portnum);
 
    // set the device serial number to the counter device
    owSerialNum(portnum,SerialNum,FALSE);
 
    for (loop = 0; loop < 2; loop ++)
    {
-      // check if the chip is connected to VDD
-      if (owOverdriveAccess(portnum))
-      {
-         owWriteByte(portnum,0xB4);
-         power = owReadByte(portnum);
-      } 
+      // the power mode and configuration queries use a normal speed match
+      // ROM, an earlier overdrive access left the port in overdrive
+      owSpeed(portnum,MODE_NORMAL);
+
+      // check if the chip is connected to VDD, the result is cached
+      parasite = (TempPowerMode(portnum,SerialNum) != OWDEV_POWER_EXTERNAL);
+
+      // parasite powered devices are held to the conversion time of the
+      // configured resolution, externally powered devices are polled
+      wait = parasite ? TempDeviceConvertTime(portnum,SerialNum) : TEMP_CONVERT_MS;
 
       // access the device
       if (owOverdriveAccess(portnum))
       {
          // send the convert command and if nesessary start power delivery
-         if (power) { 
+         if (parasite) {
             if (!owWriteBytePower(portnum,0x44))
+            {
+               owUnlock(portnum);
                return FALSE;
+            }
          } else {
             if (!owWriteByte(portnum,0x44))
+            {
+               owUnlock(portnum);
                return FALSE;
+            }
          }
 
-         // sleep for 1 second
-         msDelay(1000);
-
-         // turn off the 1-Wire Net strong pull-up
-         if (power) { 
-            if (owLevel(portnum,MODE_NORMAL) != MODE_NORMAL)
-               return FALSE;
+         // wait for the conversion, this turns off the strong pull-up
+         if (!TempConvertWait(portnum,parasite,wait))
+         {
+            owUnlock(portnum);
+            return FALSE;
          }
 
          // access the device
@@ -109,11 +122,7 @@ int ReadTemperature42(int portnum, uchar *SerialNum, float *Temp)
                if (lastcrc8 == 0x00)
                {
                   // calculate the high-res temperature
-            	  tsht =        send_block[2] << 8;
-            	  tsht = tsht | send_block[1];
-            	  if (tsht & 0x00001000)
-            		  tsht = tsht | 0xffff0000;
-                  *Temp = ((float) tsht)/16;
+                  *Temp = TempDecode(0x42,&send_block[1]);
                   // success
                   rt = TRUE;
                   break;
@@ -125,5 +134,30 @@ int ReadTemperature42(int portnum, uchar *SerialNum, float *Temp)
    // exit overdrive mode
    owSpeed(portnum, MODE_NORMAL);
    // return the result flag rt
+   owUnlock(portnum);
    return rt;
 }
+
+//----------------------------------------------------------------------
+// Read the temperature of a DS28EA00 (family code 0x42), floating point
+// version of 'ReadTemperature42Int'.
+//
+// 'portnum'     - number 0 to MAX_PORTNUM-1.  This number was provided to
+//                 OpenCOM to indicate the port number.
+// 'SerialNum'   - Serial Number of DS28EA00 to read temperature from
+// 'Temp '       - pointer to variable where that temperature will be
+//                 returned, in Celsius
+//
+// Returns: TRUE(1)  temperature has been read and verified
+//          FALSE(0) could not read the temperature, perhaps device is not
+//                   in contact
+//
+int ReadTemperature42(int portnum, uchar *SerialNum, float *Temp)
+{
+   int tsht;
+
+   if (!ReadTemperature42Int(portnum,SerialNum,&tsht))
+      return FALSE;
+   *Temp = ((float) tsht)/16;
+   return TRUE;
+}
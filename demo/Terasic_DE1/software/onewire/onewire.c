@@ -22,6 +22,7 @@
 #include "temp10.h"
 #include "temp28.h"
 #include "temp42.h"
+#include "owtemp.h"
 
 // defines
 #define MAXDEVICES         20
@@ -32,10 +33,15 @@ void DisplaySerialNum(uchar sn[8]);
 
 int main()
 {
-  uchar FamilySN[MAXDEVICES][8];
-  float current_temp;
+  uchar FamilySN[3][MAXDEVICES][8];
+  FamilyBucket bucket[3] = {{0x10, FamilySN[0], MAXDEVICES},
+                            {0x28, FamilySN[1], MAXDEVICES},
+                            {0x42, FamilySN[2], MAXDEVICES}};
+  uchar *sn;
+  int current_temp, tenths;
   int i = 0;
   int j = 0;
+  int k = 0;
   int NumDevices = 0;
   SMALLINT didRead = 0;
 
@@ -60,29 +66,33 @@ int main()
   do
   {
      j = 0;
-     // Find the device(s)
-     NumDevices  = 0;
-     NumDevices += FindDevices(portnum, &FamilySN[NumDevices], 0x10, MAXDEVICES-NumDevices);
-     NumDevices += FindDevices(portnum, &FamilySN[NumDevices], 0x28, MAXDEVICES-NumDevices);
-     NumDevices += FindDevices(portnum, &FamilySN[NumDevices], 0x42, MAXDEVICES-NumDevices);
+     // Find the device(s) of all three families in a single search
+     NumDevices = FindFamilies(portnum, bucket, 3);
+     // the power mode is probed once for the port
+     TempProbePower(portnum);
      if (NumDevices)
      {
         printf("\r\n");
         // read the temperature and print serial number and temperature
-        for (i = NumDevices; i; i--)
+        for (k = 0; k < 3; k++)
+        for (i = 0; i < bucket[k].num; i++)
         {
+           sn = FamilySN[k][i];
            printf("(%d) ", j++);
-           DisplaySerialNum(FamilySN[i-1]);
-           if (FamilySN[i-1][0] == 0x10)
-              didRead = ReadTemperature10(portnum, FamilySN[i-1],&current_temp);
-           if (FamilySN[i-1][0] == 0x28)
-              didRead = ReadTemperature28(portnum, FamilySN[i-1],&current_temp);
-           if (FamilySN[i-1][0] == 0x42)
-              didRead = ReadTemperature42(portnum, FamilySN[i-1],&current_temp);
+           DisplaySerialNum(sn);
+           if (sn[0] == 0x10)
+              didRead = ReadTemperature10Int(portnum, sn,&current_temp);
+           if (sn[0] == 0x28)
+              didRead = ReadTemperature28Int(portnum, sn,&current_temp);
+           if (sn[0] == 0x42)
+              didRead = ReadTemperature42Int(portnum, sn,&current_temp);
 
            if (didRead)
            {
-              printf(" %5.1f Celsius\r\n", current_temp);
+              // 1/16 Celsius to rounded tenths, without floating point
+              tenths = (current_temp * 10 + ((current_temp < 0) ? -8 : 8)) / 16;
+              printf(" %s%d.%d Celsius\r\n", (tenths < 0) ? "-" : "",
+                     ((tenths < 0) ? -tenths : tenths) / 10, ((tenths < 0) ? -tenths : tenths) % 10);
            }
            else
            {
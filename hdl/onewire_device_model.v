@@ -0,0 +1,329 @@
+//////////////////////////////////////////////////////////////////////////////
+//                                                                          //
+//  1-wire (owr) device model with ROM functions and scratchpad             //
+//                                                                          //
+//  Copyright (C) 2010  Iztok Jeras                                         //
+//                                                                          //
+//////////////////////////////////////////////////////////////////////////////
+//                                                                          //
+//  This HDL is free hardware: you can redistribute it and/or modify        //
+//  it under the terms of the GNU Lesser General Public License             //
+//  as published by the Free Software Foundation, either                    //
+//  version 3 of the License, or (at your option) any later version.        //
+//                                                                          //
+//  This RTL is distributed in the hope that it will be useful,             //
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of          //
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the           //
+//  GNU General Public License for more details.                            //
+//                                                                          //
+//  You should have received a copy of the GNU General Public License       //
+//  along with this program.  If not, see <http://www.gnu.org/licenses/>.   //
+//                                                                          //
+//////////////////////////////////////////////////////////////////////////////
+//                                                                          //
+//  Slot timing is the same as in onewire_slave_model, on top of it the     //
+//  model implements a DS18B20 like device:                                 //
+//  - 64bit ROM (family code, 48bit serial number, CRC)                     //
+//  - Search ROM (F0), Alarm Search (EC), Match ROM (55), Skip ROM (CC),    //
+//    Read ROM (33)                                                         //
+//  - Read Scratchpad (BE), Write Scratchpad (4E), Convert T (44),          //
+//    Read Power Supply (B4)                                                //
+//  Many devices can be connected to the same wire, search arbitration is   //
+//  the result of the wired-AND bus.                                        //
+//                                                                          //
+//  Faults can be injected with the 'flt' input:                            //
+//  - flt[0] presence pulse is missing                                      //
+//  - flt[1] transmitted data bits are inverted (bit flips)                 //
+//  - flt[2] the line is stuck low                                          //
+//  - flt[3] slow device, read data '0' is driven 3/4 of a time slot late   //
+//                                                                          //
+//////////////////////////////////////////////////////////////////////////////
+
+`timescale 1us / 1ns
+
+module onewire_device_model #(
+  // time slot (min=15.0, typ=30.0, max=60.0)
+  parameter TS = 30.0,
+  // ROM number
+  parameter  [7:0] FAMILY = 8'h28,
+  parameter [47:0] SERIAL = 48'h0000_0000_0001,
+  // measured temperature (1/16 C)
+  parameter [15:0] TEMP   = 16'h0191
+)(
+  // configuration
+  input  wire ena,    // response enable
+  input  wire ovd,    // overdrive mode select
+  input  wire [3:0] flt,  // fault injection
+  // status
+  output reg  sel,    // device is selected (ROM function completed)
+  // 1-wire
+  inout  wire owr
+);
+
+// protocol states
+localparam ST_IDLE   = 0;  // deselected, waiting for a reset
+localparam ST_ROM    = 1;  // receiving a ROM command
+localparam ST_SEARCH = 2;  // ROM search
+localparam ST_MATCH  = 3;  // receiving a ROM number
+localparam ST_FUNC   = 4;  // receiving a function command
+localparam ST_TX     = 5;  // transmitting bytes
+localparam ST_RX     = 6;  // receiving scratchpad bytes
+localparam ST_DONE   = 7;  // read slots return '1'
+
+// ROM number
+wire [63:0] rom = {crc_rom (FAMILY, SERIAL), SERIAL, FAMILY};
+
+// scratchpad
+reg   [7:0] sp [0:8];
+
+// protocol state
+integer     state;
+integer     bit_n;  // bit counter
+integer     cnt;    // search slot phase, received byte counter
+integer     len;    // transmit/receive length
+reg   [7:0] dat;    // receive byte
+reg  [71:0] tx;     // transmit shift register
+
+// IO
+reg pul;
+reg dat_w;
+
+// events
+event sample_dat;
+event sample_rst;
+
+integer i;
+
+//////////////////////////////////////////////////////////////////////////////
+// CRC
+//////////////////////////////////////////////////////////////////////////////
+
+function [7:0] crc8 (
+  input [7:0] crc,
+  input [7:0] dat
+);
+  integer i;
+begin
+  crc8 = crc;
+  for (i=0; i<8; i=i+1)
+    crc8 = {1'b0, crc8[7:1]} ^ ((crc8[0] ^ dat[i]) ? 8'h8c : 8'h00);
+end endfunction
+
+function [7:0] crc_rom (
+  input  [7:0] family,
+  input [47:0] serial
+);
+  integer i;
+begin
+  crc_rom = crc8 (8'h00, family);
+  for (i=0; i<6; i=i+1)
+    crc_rom = crc8 (crc_rom, serial[8*i+:8]);
+end endfunction
+
+task sp_crc; begin
+  sp[8] = 8'h00;
+  for (i=0; i<8; i=i+1)  sp[8] = crc8 (sp[8], sp[i]);
+end endtask
+
+//////////////////////////////////////////////////////////////////////////////
+// IO
+//////////////////////////////////////////////////////////////////////////////
+
+// onewire open collector signal
+assign owr = (pul | flt[2]) & ena ? 1'b0 : 1'bz;
+
+//////////////////////////////////////////////////////////////////////////////
+// power up state
+//////////////////////////////////////////////////////////////////////////////
+
+initial begin
+  pul   = 1'b0;
+  sel   = 1'b0;
+  state = ST_IDLE;
+  // power-on temperature is 85 C
+  sp[0] = 8'h50;
+  sp[1] = 8'h05;
+  sp[2] = 8'h4b;
+  sp[3] = 8'h46;
+  sp[4] = 8'h7f;
+  sp[5] = 8'hff;
+  sp[6] = 8'h0c;
+  sp[7] = 8'h10;
+  sp_crc;
+end
+
+//////////////////////////////////////////////////////////////////////////////
+// protocol
+//////////////////////////////////////////////////////////////////////////////
+
+// alarm condition (integer temperature compared with TH and TL)
+wire signed [7:0] t_int = {sp[1][3:0], sp[0][7:4]};
+wire              alarm = (t_int >= $signed(sp[2])) || (t_int <= $signed(sp[3]));
+
+// start transmitting bytes
+task transmit (
+  input [71:0] buf_,
+  input integer n
+); begin
+  state = ST_TX;
+  tx    = buf_;
+  len   = n;
+  bit_n = 0;
+end endtask
+
+// value driven by the device during a time slot
+function drive (input dummy); begin
+  case (state)
+    ST_SEARCH : drive = (cnt == 0) ? rom[bit_n] : (cnt == 1) ? ~rom[bit_n] : 1'b1;
+    ST_TX     : drive = tx[bit_n];
+    default   : drive = 1'b1;
+  endcase
+end endfunction
+
+// reset pulse detected
+task reset; begin
+  state = ST_ROM;
+  sel   = 1'b0;
+  bit_n = 0;
+  dat   = 8'h00;
+end endtask
+
+// line value sampled during a time slot
+task slot (input b); begin
+  case (state)
+    ST_ROM, ST_FUNC, ST_RX : begin
+      dat = {b, dat[7:1]};
+      bit_n = bit_n + 1;
+      if (bit_n == 8) begin
+        bit_n = 0;
+        if (state == ST_ROM) begin
+          cnt = 0;
+          case (dat)
+            8'hf0 : state = ST_SEARCH;
+            8'hec : state = alarm ? ST_SEARCH : ST_IDLE;
+            8'h55 : state = ST_MATCH;
+            8'hcc : begin state = ST_FUNC; sel = 1'b1; end
+            8'h33 : begin transmit (rom, 8); sel = 1'b1; end
+            default : state = ST_IDLE;
+          endcase
+        end else if (state == ST_FUNC) begin
+          case (dat)
+            8'hbe : begin
+              sp_crc;
+              transmit ({sp[8], sp[7], sp[6], sp[5], sp[4], sp[3], sp[2], sp[1], sp[0]}, 9);
+            end
+            8'h4e : begin state = ST_RX; len = 3; cnt = 0; end
+            8'h44 : begin
+              // the conversion completes immediately
+              sp[0] = TEMP[7:0];
+              sp[1] = TEMP[15:8];
+              sp_crc;
+              state = ST_DONE;
+            end
+            8'hb4 : state = ST_DONE;
+            default : state = ST_IDLE;
+          endcase
+        end else begin
+          sp[2+cnt] = dat;
+          cnt = cnt + 1;
+          if (cnt == len) begin
+            sp[4] = {1'b0, sp[4][6:5], 5'h1f};
+            sp_crc;
+            state = ST_DONE;
+          end
+        end
+        dat = 8'h00;
+      end
+    end
+    ST_SEARCH : begin
+      if (cnt < 2)  cnt = cnt + 1;
+      else begin
+        cnt = 0;
+        if (b != rom[bit_n])  state = ST_IDLE;
+        else begin
+          bit_n = bit_n + 1;
+          if (bit_n == 64) begin  state = ST_FUNC;  sel = 1'b1;  bit_n = 0;  end
+        end
+      end
+    end
+    ST_MATCH : begin
+      if (b != rom[bit_n])  state = ST_IDLE;
+      else begin
+        bit_n = bit_n + 1;
+        if (bit_n == 64) begin  state = ST_FUNC;  sel = 1'b1;  bit_n = 0;  end
+      end
+    end
+    ST_TX : begin
+      bit_n = bit_n + 1;
+      if (bit_n == 8*len)  state = ST_DONE;
+    end
+    default : ;
+  endcase
+end endtask
+
+//////////////////////////////////////////////////////////////////////////////
+// events inside a cycle
+//////////////////////////////////////////////////////////////////////////////
+
+always @ (negedge owr)  if (ena)  transfer (ovd);
+
+task automatic transfer (
+  input ovd
+); begin
+  // drive the read data response (a slow device starts late)
+  if (flt[3]) begin
+    if (ovd)  #(3*TS/32);
+    else      #(3*TS/4);
+  end
+  pul = ~(drive (1'b0) ^ (flt[1] & (state == ST_TX)));
+  // wait 1 time slot
+  if (flt[3]) begin
+    if (ovd)  #(1*TS/32);
+    else      #(1*TS/4);
+  end else begin
+    if (ovd)  #(1*TS/8);
+    else      #(1*TS);
+  end
+  // write data is sampled here
+  -> sample_dat;
+  dat_w = owr;
+  // release the wire
+  pul = 1'b0;
+  // fork into data or reset cycle
+  fork
+    // transfer data
+    begin : transfer_dat
+      // if cycle ends before reset is detected
+      if (~owr) @ (posedge owr);
+      // disable reset path
+      disable transfer_rst;
+      // process the data bit
+      slot (dat_w);
+    end
+    // transfer reset
+    begin : transfer_rst
+      // wait 7 time slots
+      if (ovd)  #(7*TS/8);
+      else      #(7*TS);
+      // reset is sampled here
+      -> sample_rst;
+      // if reset is detected disable data path
+      if (~owr) disable transfer_dat;
+      // wait for reset low to end
+      @ (posedge owr)
+      reset;
+      // wait 1 time slot
+      if (ovd)  #(1*TS/8);
+      else      #(1*TS);
+      // provide presence pulse
+      pul = ~flt[0];
+      // wait 4 time slot
+      if (ovd)  #(4*TS/8);
+      else      #(4*TS);
+      // release the wire
+      pul = 1'b0;
+    end
+  join
+end endtask
+
+endmodule
@@ -38,6 +38,12 @@ localparam CDR_E = 1;
 localparam CDR_E = 0;
 `endif
 
+`ifdef PRG_E
+localparam PRG_E = 1;
+`else
+localparam PRG_E = 0;
+`endif
+
 `ifdef PRESET_50_10
 localparam OVD_E = 1'b1;   // overdrive functionality enable
 localparam BTP_N = "5.0";  // normal    mode
@@ -73,7 +79,7 @@ localparam OWN   =  3;    // slaves with different timing (min, typ, max)
 `endif
 
 // computed bus address port width
-localparam BAW   = (BDW==32) ? 1 : 2;
+localparam BAW   = (BDW==32) ? (PRG_E ? 2 : 1) : 2;
 
 // clock dividers for normal and overdrive mode
 // NOTE! must be round integer values
@@ -128,6 +134,45 @@ integer        n;
 // overdrive enable loop
 integer        i;
 
+// program engine test
+reg      [7:0] prg_mem [0:15];
+
+// cycle timing budgets in base periods (bit 0 low, bit 1 low, bit cycle,
+// reset low, reset cycle, delay cycle), independent of the RTL parameters
+`ifdef PRESET_60_05
+localparam integer TB_DAT0_N = 10, TB_DAT1_N = 1, TB_BIT_N = 11, TB_RSTL_N = 80, TB_RST_N = 160, TB_DLY_N = 160;
+localparam integer TB_DAT0_O = 12, TB_DAT1_O = 2, TB_BIT_O = 16, TB_RSTL_O = 96, TB_RST_O = 192;
+`elsif PRESET_75
+localparam integer TB_DAT0_N =  8, TB_DAT1_N = 1, TB_BIT_N =  9, TB_RSTL_N = 64, TB_RST_N = 128, TB_DLY_N = 128;
+localparam integer TB_DAT0_O =  6, TB_DAT1_O = 1, TB_BIT_O =  8, TB_RSTL_O = 48, TB_RST_O =  96;
+`else
+localparam integer TB_DAT0_N = 12, TB_DAT1_N = 1, TB_BIT_N = 13, TB_RSTL_N = 96, TB_RST_N = 192, TB_DLY_N = 200;
+localparam integer TB_DAT0_O =  6, TB_DAT1_O = 1, TB_BIT_O =  8, TB_RSTL_O = 48, TB_RST_O =  96;
+`endif
+
+// cycle timing measurement
+reg             tim_run;              // measurement is running
+integer         tim_low;              // line low time (clock periods)
+integer         tim_irq;              // CTL write to interrupt latency (clock periods)
+
+// multi device test (device models on wire 0)
+`ifdef DEVN
+localparam DEVN  = `DEVN;  // number of device models
+`else
+localparam DEVN  =  8;     // number of device models
+`endif
+reg             dev_ena;              // device model enable
+reg       [3:0] dev_flt;              // fault injection into the first device model
+wire [DEVN-1:0] dev_sel;              // device model selected
+reg      [63:0] dev_rom [0:DEVN-1];   // ROM numbers found by search
+integer         dev_num;              // number of devices found by search
+real            dev_t;                // search start time
+reg      [63:0] rom;                  // ROM number
+reg      [71:0] sp;                   // scratchpad
+reg       [7:0] crc;                  // CRC
+reg             prs;                  // presence
+integer         j, k;
+
 //////////////////////////////////////////////////////////////////////////////
 // configuration printout and waveforms
 //////////////////////////////////////////////////////////////////////////////
@@ -143,6 +188,7 @@ initial begin
   $display ("NOTE: Ports : BDW=%0d, BAW=%0d, OWN=%0d", BDW, BAW, OWN);
   $display ("NOTE: Clock : FRQ=%3.2fMHz, TCP=%3.2fns", FRQ/1_000_000.0, TCP);
   $display ("NOTE: Divide: CDR_E=%0b, CDR_N=%0d, CDR_O=%0d", CDR_E, CDR_N, CDR_O);
+  $display ("NOTE: Engine: PRG_E=%0b", PRG_E);
   $display ("NOTE: Config: OVD_E=%0b, BTP_N=%1.2fus, BTP_O=%1.2fus",
                            OVD_E, (CDR_N+1)*1_000_000/FRQ, (CDR_O+1)*1_000_000/FRQ);
 end
@@ -176,6 +222,9 @@ initial begin
 
   // long delay to skip presence pulse
   slave_ena = 1'b0;
+  dev_ena   = 1'b0;
+  dev_flt   = 4'b0000;
+  tim_run   = 1'b0;
   #1000_000;
 
   // set clock divider ratios
@@ -317,6 +366,206 @@ initial begin
   repeat (10) @(posedge clk);
   avalon_request (16'd0, 4'h0, 3'b111);
 
+  // program engine test (reset, skip ROM, read two bytes, check CRC)
+  if (PRG_E & (BDW==32)) begin
+    repeat (10) @(posedge clk);
+    slave_sel   = 0;
+    slave_ovd   = 0;
+    slave_ena   = 1'b1;
+    slave_dat_r = 1'b1;
+    // select the port, power off
+    avalon_request (16'd0, slave_sel, 3'b111);
+    // load the program at address 0x00, read data at address 0x10
+    prg_mem[0] = 8'h01;                   // RST
+    prg_mem[1] = 8'h02;  prg_mem[2] = 8'd1;  prg_mem[3] = 8'hcc;  // WRI 1, 0xcc
+    prg_mem[4] = 8'h09;  prg_mem[5] = 8'h10;  // SP1 0x10
+    prg_mem[6] = 8'h04;  prg_mem[7] = 8'd2;   // RDP 2
+    prg_mem[8] = 8'h05;                   // CRC
+    prg_mem[9] = 8'h00;                   // END
+    avalon_cycle (1, 2, 4'hf, 32'h0000_0000, data);
+    for (n=0; n<10; n=n+1)  avalon_cycle (1, 3, 4'hf, {24'h0000_00, prg_mem[n]}, data);
+    // run the program from address 0x00
+    avalon_cycle (1, 2, 4'hf, 32'h0010_0001, data);
+    // poll till the program ends
+    data = 32'h01;
+    while (data & 32'h01) begin
+      repeat (64) @ (posedge clk);
+      avalon_cycle (0, 2, 4'hf, 32'hxxxx_xxxx, data);
+    end
+    // the CRC of two 0xff bytes is not zero, so the error status is expected
+    if (data[1] !== 1'b1) begin
+      error = error+1;
+      $display("ERROR: (t=%0t)  Program engine CRC error status expected.", $time);
+    end
+    // check read data and CRC status (memory address was set to 0x10 at start)
+    avalon_cycle (0, 3, 4'hf, 32'hxxxx_xxxx, data);
+    if (data[7:0] !== 8'hff) begin
+      error = error+1;
+      $display("ERROR: (t=%0t)  Wrong program engine read data (0x%02x).", $time, data[7:0]);
+    end
+    avalon_cycle (0, 3, 4'hf, 32'hxxxx_xxxx, data);
+    if (data[7:0] !== 8'hff) begin
+      error = error+1;
+      $display("ERROR: (t=%0t)  Wrong program engine read data (0x%02x).", $time, data[7:0]);
+    end
+    avalon_cycle (0, 3, 4'hf, 32'hxxxx_xxxx, data);
+    if (data[7:0] !== 8'hb4) begin
+      error = error+1;
+      $display("ERROR: (t=%0t)  Wrong program engine CRC status (0x%02x).", $time, data[7:0]);
+    end
+    // check the last read slot was seen by the slave as write '1'
+    if (slave_dat_w[slave_sel] !== 1'b1) begin
+      error = error+1;
+      $display("ERROR: (t=%0t)  Wrong program engine read slot.", $time);
+    end
+  end
+
+  // multi device test (search, match ROM, scratchpad)
+  repeat (10) @(posedge clk);
+  slave_ena = 1'b0;
+  dev_ena   = 1'b1;
+  // select the port, power off
+  avalon_request (16'd0, 4'd0, 3'b111);
+
+  // search all devices
+  dev_t = $realtime;
+  owr_search (8'hf0, dev_num);
+  dev_t = $realtime - dev_t;
+  $display("NOTE: Search: %0d devices in %0.3fms (%0.3fms per device)", dev_num, dev_t/1_000_000, dev_t/1_000_000/(dev_num ? dev_num : 1));
+  if (dev_num != DEVN) begin
+    error = error+1;
+    $display("ERROR: (t=%0t)  Search found %0d devices (%0d expected).", $time, dev_num, DEVN);
+  end
+  // each ROM number must have a valid CRC and must be found exactly once
+  for (j=0; j<dev_num; j=j+1) begin
+    rom = dev_rom[j];
+    crc = 8'h00;
+    for (k=0; k<8; k=k+1)  crc = crc8 (crc, rom[8*k+:8]);
+    if (crc !== 8'h00) begin
+      error = error+1;
+      $display("ERROR: (t=%0t)  Wrong ROM CRC (0x%016x).", $time, rom);
+    end
+  end
+  for (j=0; j<DEVN; j=j+1) begin
+    rom = dev_rom_exp (j);
+    n = 0;
+    for (k=0; k<dev_num; k=k+1)  if (dev_rom[k] === rom)  n = n+1;
+    if (n != 1) begin
+      error = error+1;
+      $display("ERROR: (t=%0t)  ROM 0x%016x found %0d times.", $time, rom, n);
+    end
+  end
+
+  // skip ROM, start temperature conversion on all devices
+  owr_reset (prs);
+  owr_byte (8'hcc, crc);
+  owr_byte (8'h44, crc);
+
+  // match ROM, read scratchpad
+  rom = dev_rom[0];
+  owr_reset (prs);
+  owr_byte (8'h55, crc);
+  for (k=0; k<8; k=k+1)  owr_byte (rom[8*k+:8], crc);
+  // only the addressed device is selected
+  if ((dev_sel == 0) || (dev_sel & (dev_sel-1))) begin
+    error = error+1;
+    $display("ERROR: (t=%0t)  Match ROM selected devices 0x%0x.", $time, dev_sel);
+  end
+  owr_byte (8'hbe, crc);
+  crc = 8'h00;
+  for (k=0; k<9; k=k+1) begin
+    owr_byte (8'hff, sp[8*k+:8]);
+    crc = crc8 (crc, sp[8*k+:8]);
+  end
+  if (crc !== 8'h00) begin
+    error = error+1;
+    $display("ERROR: (t=%0t)  Wrong scratchpad CRC (0x%018x).", $time, sp);
+  end
+  if (sp[15:0] !== 16'h0191) begin
+    error = error+1;
+    $display("ERROR: (t=%0t)  Wrong temperature (0x%04x).", $time, sp[15:0]);
+  end
+
+  // skip ROM, write scratchpad (alarm limits out of range)
+  owr_reset (prs);
+  owr_byte (8'hcc, crc);
+  owr_byte (8'h4e, crc);
+  owr_byte (8'h7f, crc);  // TH
+  owr_byte (8'h80, crc);  // TL
+  owr_byte (8'h7f, crc);  // configuration
+  // alarm search, no device responds
+  owr_search (8'hec, dev_num);
+  if (dev_num != 0) begin
+    error = error+1;
+    $display("ERROR: (t=%0t)  Alarm search found %0d devices (0 expected).", $time, dev_num);
+  end
+
+  // match ROM, write scratchpad (alarm on a single device)
+  rom = dev_rom_exp (DEVN-1);
+  owr_reset (prs);
+  owr_byte (8'h55, crc);
+  for (k=0; k<8; k=k+1)  owr_byte (rom[8*k+:8], crc);
+  owr_byte (8'h4e, crc);
+  owr_byte (8'h00, crc);  // TH
+  owr_byte (8'h80, crc);  // TL
+  owr_byte (8'h7f, crc);  // configuration
+  // alarm search, only the addressed device responds
+  owr_search (8'hec, dev_num);
+  if ((dev_num != 1) || (dev_rom[0] !== dev_rom_exp (DEVN-1))) begin
+    error = error+1;
+    $display("ERROR: (t=%0t)  Alarm search found %0d devices (1 expected).", $time, dev_num);
+  end
+
+  // fault injection, bit flips and a slow device corrupt the scratchpad read
+  rom = dev_rom_exp (0);
+  for (j=0; j<3; j=j+1) begin
+    dev_flt = (j==0) ? 4'b0010 : (j==1) ? 4'b1000 : 4'b0000;
+    owr_reset (prs);
+    owr_byte (8'h55, crc);
+    for (k=0; k<8; k=k+1)  owr_byte (rom[8*k+:8], crc);
+    owr_byte (8'hbe, crc);
+    crc = 8'h00;
+    for (k=0; k<9; k=k+1) begin
+      owr_byte (8'hff, sp[8*k+:8]);
+      crc = crc8 (crc, sp[8*k+:8]);
+    end
+    if ((crc === 8'h00) !== (dev_flt == 4'b0000)) begin
+      error = error+1;
+      $display("ERROR: (t=%0t)  Wrong scratchpad CRC status (0x%02x) with fault 0x%0x.", $time, crc, dev_flt);
+    end
+    // a stuck line after the faulty read (recovery is checked by the next loop)
+    if (j==1) begin
+      dev_flt = 4'b0100;
+      owr_bit (1'b1, prs);
+      if (prs !== 1'b0) begin
+        error = error+1;
+        $display("ERROR: (t=%0t)  Stuck low line was not detected.", $time);
+      end
+      dev_flt = 4'b0000;
+    end
+  end
+  dev_ena = 1'b0;
+
+  // cycle timing and interrupt latency (no slave is connected)
+  $display("NOTE: Timing: cycle    speed  low[clk] budget   irq[clk] budget");
+  timing_cycle (3'b000, "write 0", TB_DAT0_N, TB_BIT_N);
+  timing_cycle (3'b001, "write 1", TB_DAT1_N, TB_BIT_N);
+  timing_cycle (3'b010, "reset"  , TB_RSTL_N, TB_RST_N);
+  timing_cycle (3'b011, "delay"  ,         0, TB_DLY_N);
+  if (OVD_E) begin
+    timing_cycle (3'b100, "write 0", TB_DAT0_O, TB_BIT_O);
+    timing_cycle (3'b101, "write 1", TB_DAT1_O, TB_BIT_O);
+    timing_cycle (3'b110, "reset"  , TB_RSTL_O, TB_RST_O);
+  end
+  // an idle cycle must end immediately
+  avalon_request (16'd0, 4'd0, 3'b111);
+  avalon_polling (1, n);
+  $display("NOTE: Timing: %-8s %-6s %8d %6d %10d %6d", "idle", "-", 0, 0, n, 1);
+  if (n>1) begin
+    error = error+1;
+    $display("ERROR: (t=%0t)  Idle cycle status was active for %0d reads.", $time, n);
+  end
+
   // wait a few cycles and finish
   repeat (10) @(posedge clk);
   $finish(); 
@@ -363,6 +612,171 @@ task avalon_polling (
   end
 end endtask
 
+//////////////////////////////////////////////////////////////////////////////
+// cycle timing measurement
+//////////////////////////////////////////////////////////////////////////////
+
+// line low time and interrupt latency counters
+always @ (posedge clk)
+if (tim_run) begin
+  tim_irq <= tim_irq + 1;
+  tim_low <= tim_low + owr_e[0];
+end
+
+// run a cycle with the interrupt enabled, compare timing against budgets
+task timing_cycle (
+  input      [2:0] cmd,      // command {ovd, rst, dat}
+  input  [8*8-1:0] name,     // cycle name
+  input    integer low_exp,  // line low time budget (base periods)
+  input    integer irq_exp   // cycle time budget (base periods)
+);
+  integer cdr;
+begin
+  cdr = (cmd[2] ? CDR_O : CDR_N) + 1;
+  low_exp = low_exp * cdr;
+  irq_exp = irq_exp * cdr;
+  tim_low = 0;
+  tim_irq = 0;
+  // start the cycle on wire 0 with the interrupt enabled
+  if (BDW==32) begin
+    avalon_cycle (1, 0, 4'hf, {24'h0000_00, 1'b1, 3'b000, 1'b1, cmd}, data);
+  end else begin
+    avalon_cycle (1, 1, 1'b1, 8'h00, data);
+    avalon_cycle (1, 0, 1'b1, {1'b1, 3'b000, 1'b1, cmd}, data);
+  end
+  tim_run = 1'b1;
+  // wait for the interrupt (with a timeout)
+  fork : timing_wait
+    begin
+      @ (posedge avalon_interrupt);
+      disable timing_wait;
+    end
+    begin
+      repeat (2*irq_exp+100) @ (posedge clk);
+      disable timing_wait;
+    end
+  join
+  tim_run = 1'b0;
+  // clear the interrupt status
+  if (BDW==32)  avalon_cycle (0, 0, 4'hf, 32'hxxxx_xxxx, data);
+  else          avalon_cycle (0, 0, 1'b1,  8'hxx       , data);
+  // summary table row
+  $display("NOTE: Timing: %-8s %-6s %8d %6d %10d %6d", name, cmd[2] ? "ovd" : "normal", tim_low, low_exp, tim_irq, irq_exp);
+  // slower or faster than the budget is an error (two clock periods for synchronization)
+  if ((tim_low < low_exp) || (tim_low > low_exp+2)) begin
+    error = error+1;
+    $display("ERROR: (t=%0t)  Wrong %0s line low time (%0d, expected %0d).", $time, name, tim_low, low_exp);
+  end
+  if ((tim_irq < irq_exp) || (tim_irq > irq_exp+2)) begin
+    error = error+1;
+    $display("ERROR: (t=%0t)  Wrong %0s interrupt latency (%0d, expected %0d).", $time, name, tim_irq, irq_exp);
+  end
+end endtask
+
+//////////////////////////////////////////////////////////////////////////////
+// 1-wire transfers on wire 0 in normal mode
+//////////////////////////////////////////////////////////////////////////////
+
+// reset, returns presence
+task owr_reset (
+  output prs
+); begin
+  avalon_request (16'd0, 4'd0, 3'b010);
+  avalon_polling (8, n);
+  prs = ~data[0];
+end endtask
+
+// bit transfer
+task owr_bit (
+  input  dat_w,
+  output dat_r
+); begin
+  avalon_request (16'd0, 4'd0, {2'b00, dat_w});
+  avalon_polling (8, n);
+  dat_r = data[0];
+end endtask
+
+// byte transfer (LSB first)
+task owr_byte (
+  input  [7:0] dat_w,
+  output [7:0] dat_r
+);
+  integer b;
+begin
+  for (b=0; b<8; b=b+1)  owr_bit (dat_w[b], dat_r[b]);
+end endtask
+
+// ROM search (0xf0 - Search ROM, 0xec - Alarm Search), results in dev_rom
+task owr_search (
+  input  [7:0] cmd,
+  output integer num
+);
+  integer   lst;  // last discrepancy
+  integer   dsc;  // discrepancy in the current pass
+  integer   b;
+  reg       prs, id, cmp, dir, tmp, fin;
+  reg [7:0] dat;
+begin
+  num = 0;
+  lst = 0;
+  fin = 1'b0;
+  rom = 64'd0;
+  while (~fin) begin
+    owr_reset (prs);
+    owr_byte (cmd, dat);
+    dsc = 0;
+    for (b=0; b<64; b=b+1) begin
+      owr_bit (1'b1, id);
+      owr_bit (1'b1, cmp);
+      if (id & cmp) begin
+        // no device participates in the search
+        fin = 1'b1;
+        b   = 64;
+      end else begin
+        if (id ^ cmp)       dir = id;
+        else if (b+1 < lst) dir = rom[b];
+        else                dir = (b+1 == lst);
+        if (~(id ^ cmp) & ~dir)  dsc = b+1;
+        rom[b] = dir;
+        owr_bit (dir, tmp);
+      end
+    end
+    if (~fin) begin
+      dev_rom[num] = rom;
+      num = num+1;
+      lst = dsc;
+      if ((lst == 0) || (num == DEVN))  fin = 1'b1;
+    end
+  end
+end endtask
+
+// CRC8 (x^8 + x^5 + x^4 + 1)
+function [7:0] crc8 (
+  input [7:0] crc,
+  input [7:0] dat
+);
+  integer i;
+begin
+  crc8 = crc;
+  for (i=0; i<8; i=i+1)
+    crc8 = {1'b0, crc8[7:1]} ^ ((crc8[0] ^ dat[i]) ? 8'h8c : 8'h00);
+end endfunction
+
+// device model family code and serial number
+function  [7:0] dev_family (input integer d);  dev_family = (d%4 == 0) ? 8'h10 : 8'h28;      endfunction
+function [47:0] dev_serial (input integer d);  dev_serial = (d+1) * 48'h0000_9e37_79b9;      endfunction
+
+// device model ROM number
+function [63:0] dev_rom_exp (
+  input integer d
+);
+  integer i;
+begin
+  dev_rom_exp = {8'h00, dev_serial (d), dev_family (d)};
+  for (i=0; i<7; i=i+1)
+    dev_rom_exp[63:56] = crc8 (dev_rom_exp[63:56], dev_rom_exp[8*i+:8]);
+end endfunction
+
 //////////////////////////////////////////////////////////////////////////////
 // Avalon transfer cycle generation task
 //////////////////////////////////////////////////////////////////////////////
@@ -405,6 +819,7 @@ assign avalon_waitrequest = 1'b0;
 sockit_owm #(
   .OVD_E    (OVD_E),
   .CDR_E    (CDR_E),
+  .PRG_E    (PRG_E),
   .BDW      (BDW  ),
   .BAW      (BAW  ),
   .OWN      (OWN  ),
@@ -539,4 +954,23 @@ onewire_slave_model #(
 
 `endif
 
+// device models with ROM numbers on wire 0
+genvar d;
+generate for (d=0; d<DEVN; d=d+1) begin : device
+  onewire_device_model #(
+    .TS     (30),
+    .FAMILY (dev_family (d)),
+    .SERIAL (dev_serial (d))
+  ) onewire_device (
+    // configuration
+    .ena    (dev_ena),
+    .ovd    (1'b0),
+    .flt    ((d == 0) ? dev_flt : 4'b0000),
+    // status
+    .sel    (dev_sel[d]),
+    // 1-wire signal
+    .owr    (owr[0])
+  );
+end endgenerate
+
 endmodule
@@ -47,18 +47,48 @@
 //                                                                          //
 //////////////////////////////////////////////////////////////////////////////
 
+
+//////////////////////////////////////////////////////////////////////////////
+//                                                                          //
+// The optional program engine (PRG_E, only for BDW=32) executes short      //
+// 1-wire programs stored in a small memory of 2**PAW bytes. The same       //
+// memory is used for program code, ROM tables and read data buffers.       //
+// Each instruction is an opcode byte, optionally followed by an operand:   //
+//                                                                          //
+// 0x00       END  - end of program, set status (and interrupt)             //
+// 0x01       RST  - reset, on missing presence set error and end           //
+// 0x02 n d.. WRI  - write n immediate bytes following the operand          //
+// 0x03 n     WRP  - write n bytes from memory at P0, P0 += n               //
+// 0x04 n     RDP  - read  n bytes into memory at P1, P1 += n               //
+// 0x05       CRC  - store CRC8 of read data at P1++, set error if not 0    //
+// 0x06 n     DLY  - n delay cycles (same as CPU delay cycles)              //
+// 0x07 b     PWR  - strong pull-up on the selected port on (1) or off (0)  //
+// 0x08 a     SP0  - set source pointer P0 to address a                     //
+// 0x09 a     SP1  - set destination pointer P1 to address a                //
+// 0x0a n     LDC  - load loop counter (0 stands for 256)                   //
+// 0x0b a     DJN  - decrement loop counter, jump to a if not zero          //
+//                                                                          //
+// The CRC8 accumulator is cleared by RST and CRC instructions. The program //
+// runs on the port selected by the last write into the control register.  //
+// While a program is running the CPU should not start 1-wire cycles or     //
+// access the program memory.                                               //
+//                                                                          //
+//////////////////////////////////////////////////////////////////////////////
+
 module sockit_owm #(
   // enable implementation of optional functionality
   parameter OVD_E =    1,  // overdrive functionality is implemented by default
   parameter CDR_E =    1,  // clock divider register is implemented by default
+  parameter PRG_E =    0,  // program engine is not implemented by default
+  parameter PAW   =    6,  // program memory address width (up to 8)
   // interface parameters
   parameter BDW   =   32,  // bus data width
   parameter OWN   =    1,  // number of 1-wire ports
   // computed bus address port width
 `ifdef __ICARUS__
-  parameter BAW   = (BDW==32) ? 1 : 2,
+  parameter BAW   = (BDW==32) ? (PRG_E ? 2 : 1) : 2,
 `else
-  parameter BAW   = 1,  // TODO, the above is correct, but does not work well with Altera SOPC Builder
+  parameter BAW   = PRG_E ? 2 : 1,  // TODO, the above is correct, but does not work well with Altera SOPC Builder
 `endif
   // base time period
   parameter BTP_N = "5.0", // normal    mode (5.0us, options are "7.5", "5.0" and "6.0")
@@ -118,6 +148,40 @@ localparam SDW = $clog2(OWN);
 localparam TDW =       (T_RSTH_O+T_RSTL_O) >       (T_RSTH_N+T_RSTL_N)
                ? $clog2(T_RSTH_O+T_RSTL_O) : $clog2(T_RSTH_N+T_RSTL_N);
 
+// program engine is only available with a 32bit bus
+localparam PRG = (BDW==32) ? PRG_E : 0;
+
+// the program engine registers are selected by the address bit BAW-1, with
+// a single address bit they would alias CTL/CDR, the missing module makes
+// such a configuration fail at elaboration time
+generate if (PRG && (BAW < 2)) begin : check_baw
+  sockit_owm_error_PRG_E_requires_BAW_2 check_baw ();
+end endgenerate
+
+// program engine opcodes
+localparam OP_END = 4'h0;
+localparam OP_RST = 4'h1;
+localparam OP_WRI = 4'h2;
+localparam OP_WRP = 4'h3;
+localparam OP_RDP = 4'h4;
+localparam OP_CRC = 4'h5;
+localparam OP_DLY = 4'h6;
+localparam OP_PWR = 4'h7;
+localparam OP_SP0 = 4'h8;
+localparam OP_SP1 = 4'h9;
+localparam OP_LDC = 4'ha;
+localparam OP_DJN = 4'hb;
+
+// program engine states
+localparam PRG_IDL = 3'd0;  // idle
+localparam PRG_OPC = 3'd1;  // opcode fetch
+localparam PRG_ARG = 3'd2;  // operand fetch
+localparam PRG_DAT = 3'd3;  // write data fetch
+localparam PRG_CYC = 3'd4;  // 1-wire cycle request
+localparam PRG_WAI = 3'd5;  // wait for the 1-wire cycle end
+localparam PRG_NXT = 3'd6;  // 1-wire cycle result
+localparam PRG_STO = 3'd7;  // CRC store
+
 //////////////////////////////////////////////////////////////////////////////
 // local signals
 //////////////////////////////////////////////////////////////////////////////
@@ -128,10 +192,17 @@ wire bus_wen_ctl_sts;
 wire bus_wen_pwr_sel;
 wire bus_wen_cdr_n;
 wire bus_wen_cdr_o;
+wire bus_sel_prg;
+wire bus_ren_prg;
+wire bus_ren_pmd;
+wire bus_wen_prg;
+wire bus_wen_pmd;
 
 // read data bus segments
 wire     [7:0] bus_rdt_ctl_sts;
 wire [PDW-1:0] bus_rdt_pwr_sel;
+wire    [31:0] bus_rdt_prg;
+wire     [7:0] bus_rdt_pmd;
 
 // clock divider
 reg  [CDW-1:0] div;
@@ -143,6 +214,19 @@ wire           pls;
 reg            owr_cyc;  // cycle status
 reg  [TDW-1:0] cnt;      // cycle counter
 
+// cycle request (from CPU bus or program engine)
+wire           cyc_wen;  // cycle request
+wire     [3:0] cyc_wdt;  // cycle command {cyc, ovd, rst, dat}
+
+// program engine signals
+wire           prg_req;  // cycle request
+wire     [1:0] prg_cmd;  // cycle command {rst, dat}
+wire           prg_ovd;  // cycle overdrive
+wire           prg_run;  // program is running
+wire           prg_irq;  // program end interrupt
+wire           prg_pwr_wen;  // power write enable
+wire           prg_pwr;      // power write data
+
 // port select
 //generate if (OWN>1) begin : sel_declaration
 reg  [SDW-1:0] owr_sel;
@@ -228,7 +312,10 @@ endgenerate
 
 // bus read data
 generate if (BDW==32) begin
-  assign bus_rdt = (bus_adr[0]==1'b0) ? {bus_rdt_pwr_sel, bus_rdt_ctl_sts} : (cdr_o << 16 | cdr_n);
+  assign bus_rdt = (bus_sel_prg==1'b1) ? ((bus_adr[0]==1'b0) ? bus_rdt_prg
+                                                            : {24'h0000_00, bus_rdt_pmd})
+                                      : ((bus_adr[0]==1'b0) ? {bus_rdt_pwr_sel, bus_rdt_ctl_sts}
+                                                            : (cdr_o << 16 | cdr_n));
 end else if (BDW==8) begin
   assign bus_rdt = (bus_adr[1]==1'b0) ? ((bus_adr[0]==1'b0) ? bus_rdt_ctl_sts
                                                             : bus_rdt_pwr_sel)
@@ -240,19 +327,30 @@ end endgenerate
 // bus write
 //////////////////////////////////////////////////////////////////////////////
 
+// program engine registers are placed above the clock divider register
+assign bus_sel_prg = PRG ? bus_adr[BAW-1] : 1'b0;
+
 // combined write/read enable and address decoder
 generate if (BDW==32) begin
-  assign bus_ren_ctl_sts = bus_ren & bus_adr[0] == 1'b0;
-  assign bus_wen_ctl_sts = bus_wen & bus_adr[0] == 1'b0;
-  assign bus_wen_pwr_sel = bus_wen & bus_adr[0] == 1'b0;
-  assign bus_wen_cdr_n   = bus_wen & bus_adr[0] == 1'b1;
-  assign bus_wen_cdr_o   = bus_wen & bus_adr[0] == 1'b1;
+  assign bus_ren_ctl_sts = bus_ren & bus_adr[0] == 1'b0 & ~bus_sel_prg;
+  assign bus_wen_ctl_sts = bus_wen & bus_adr[0] == 1'b0 & ~bus_sel_prg;
+  assign bus_wen_pwr_sel = bus_wen & bus_adr[0] == 1'b0 & ~bus_sel_prg;
+  assign bus_wen_cdr_n   = bus_wen & bus_adr[0] == 1'b1 & ~bus_sel_prg;
+  assign bus_wen_cdr_o   = bus_wen & bus_adr[0] == 1'b1 & ~bus_sel_prg;
+  assign bus_ren_prg     = bus_ren & bus_adr[0] == 1'b0 &  bus_sel_prg;
+  assign bus_ren_pmd     = bus_ren & bus_adr[0] == 1'b1 &  bus_sel_prg;
+  assign bus_wen_prg     = bus_wen & bus_adr[0] == 1'b0 &  bus_sel_prg;
+  assign bus_wen_pmd     = bus_wen & bus_adr[0] == 1'b1 &  bus_sel_prg;
 end else if (BDW==8) begin
   assign bus_ren_ctl_sts = bus_ren & bus_adr[1:0] == 2'b00;
   assign bus_wen_ctl_sts = bus_wen & bus_adr[1:0] == 2'b00;
   assign bus_wen_pwr_sel = bus_wen & bus_adr[1:0] == 2'b01;
   assign bus_wen_cdr_n   = bus_wen & bus_adr[1:0] == 2'b10;
   assign bus_wen_cdr_o   = bus_wen & bus_adr[1:0] == 2'b11;
+  assign bus_ren_prg     = 1'b0;
+  assign bus_ren_pmd     = 1'b0;
+  assign bus_wen_prg     = 1'b0;
+  assign bus_wen_pmd     = 1'b0;
 end endgenerate
 
 //////////////////////////////////////////////////////////////////////////////
@@ -291,10 +389,10 @@ endgenerate
 
 // clock divider
 always @ (posedge clk, posedge rst)
-if (rst)        div <= 'd0;
+if (rst)                  div <= 'd0;
 else begin
-  if (bus_wen)  div <= 'd0;
-  else          div <= pls ? 'd0 : div + owr_cyc;
+  if (bus_wen | prg_req)  div <= 'd0;
+  else                    div <= pls ? 'd0 : div + owr_cyc;
 end
 
 // divided clock pulse
@@ -315,6 +413,7 @@ generate if (OWN>1) begin : sel_implementation
   always @ (posedge clk, posedge rst)
   if (rst)                   owr_pwr <= {OWN{1'b0}};
   else if (bus_wen_pwr_sel)  owr_pwr <= bus_wdt[(BDW==32 ? 16 : 4)+:OWN];
+  else if (prg_pwr_wen)      owr_pwr [owr_sel] <= prg_pwr;
 end else begin
   // port select
   initial                    owr_sel <= 'd0; 
@@ -322,6 +421,7 @@ end else begin
   always @ (posedge clk, posedge rst)
   if (rst)                   owr_pwr <= 1'b0;
   else if (bus_wen_ctl_sts)  owr_pwr <= bus_wdt[4];
+  else if (prg_pwr_wen)      owr_pwr <= prg_pwr;
 end endgenerate
 
 //////////////////////////////////////////////////////////////////////////////
@@ -329,43 +429,47 @@ end endgenerate
 //////////////////////////////////////////////////////////////////////////////
 
 // bus interrupt
-assign bus_irq = irq_ena & irq_sts;
+assign bus_irq = irq_ena & irq_sts | prg_irq;
 
 // interrupt enable
 always @ (posedge clk, posedge rst)
 if (rst)                   irq_ena <= 1'b0;     
 else if (bus_wen_ctl_sts)  irq_ena <= bus_wdt[7]; 
 
-// transmit status (active after onewire cycle ends)
+// transmit status (active after onewire cycle ends, unless a program is running)
 always @ (posedge clk, posedge rst)
-if (rst)                           irq_sts <= 1'b0;
+if (rst)                                      irq_sts <= 1'b0;
 else begin
-  if (bus_wen_ctl_sts)             irq_sts <= 1'b0;
-  else if (pls & (cnt == t_zero))  irq_sts <= 1'b1;
-  else if (bus_ren_ctl_sts)        irq_sts <= 1'b0;
+  if (bus_wen_ctl_sts)                        irq_sts <= 1'b0;
+  else if (pls & (cnt == t_zero) & ~prg_run)  irq_sts <= 1'b1;
+  else if (bus_ren_ctl_sts)                   irq_sts <= 1'b0;
 end
 
 //////////////////////////////////////////////////////////////////////////////
 // onewire state machine
 //////////////////////////////////////////////////////////////////////////////
 
-assign req_ovd = OVD_E ? bus_wen_ctl_sts & bus_wdt[2] : 1'b0; 
+// cycles are requested by CPU control register writes or by the program engine
+assign cyc_wen = bus_wen_ctl_sts | prg_req;
+assign cyc_wdt = bus_wen_ctl_sts ? bus_wdt[3:0] : {1'b1, prg_ovd, prg_cmd};
+
+assign req_ovd = OVD_E ? cyc_wen & cyc_wdt[2] : 1'b0; 
 
 // overdrive
 always @ (posedge clk, posedge rst)
 if (rst)                   owr_ovd <= 1'b0;
-else if (bus_wen_ctl_sts)  owr_ovd <= req_ovd;
+else if (cyc_wen)          owr_ovd <= req_ovd;
 
 // reset
 always @ (posedge clk, posedge rst)
 if (rst)                   owr_rst <= 1'b0;
-else if (bus_wen_ctl_sts)  owr_rst <= bus_wdt[1];
+else if (cyc_wen)          owr_rst <= cyc_wdt[1];
 
 // transmit data, reset, overdrive
 always @ (posedge clk, posedge rst)
 if (rst)                           owr_dat <= 1'b0;
 else begin
-  if (bus_wen_ctl_sts)             owr_dat <= bus_wdt[0];
+  if (cyc_wen)                     owr_dat <= cyc_wdt[0];
   else if (pls & (cnt == t_zero))  owr_dat <= owr_smp;
 end
 
@@ -373,7 +477,7 @@ end
 always @ (posedge clk, posedge rst)
 if (rst)                           owr_cyc <= 1'b0;
 else begin
-  if (bus_wen_ctl_sts)             owr_cyc <= bus_wdt[3] & ~&bus_wdt[2:0];
+  if (cyc_wen)                     owr_cyc <= cyc_wdt[3] & ~&cyc_wdt[2:0];
   else if (pls & (cnt == t_zero))  owr_cyc <= 1'b0;
 end
 
@@ -381,7 +485,7 @@ end
 always @ (posedge clk, posedge rst)
 if (rst)                 cnt <= 'd0;
 else begin
-  if (bus_wen_ctl_sts)   cnt <= (&bus_wdt[1:0] ? t_idl : bus_wdt[1] ? t_rst : t_bit) - 'd1;
+  if (cyc_wen)           cnt <= (&cyc_wdt[1:0] ? t_idl : cyc_wdt[1] ? t_rst : t_bit) - 'd1;
   else if (pls)          cnt <= cnt - 'd1;
 end
 
@@ -396,7 +500,7 @@ end
 always @ (posedge clk, posedge rst)
 if (rst)                                owr_oen <= 1'b0;
 else begin
-  if (bus_wen_ctl_sts)                  owr_oen <= ~&bus_wdt[1:0];
+  if (cyc_wen)                          owr_oen <= ~&cyc_wdt[1:0];
   else if (pls) begin
     if      (owr_rst & (cnt == t_rsth)) owr_oen <= 1'b0;  // reset
     else if (owr_dat & (cnt == t_dat1)) owr_oen <= 1'b0;  // write 1, read
@@ -404,6 +508,186 @@ else begin
   end
 end
 
+//////////////////////////////////////////////////////////////////////////////
+// program engine
+//////////////////////////////////////////////////////////////////////////////
+
+generate if (PRG) begin : prg_implementation
+
+  // program memory (code, ROM tables and read data)
+  reg      [7:0] mem [0:2**PAW-1];
+
+  // control and status
+  reg            run;    // program is running
+  reg            err;    // error status (missing presence, CRC)
+  reg            ovd;    // overdrive mode for program cycles
+  reg            sts;    // program end status
+  reg            ien;    // program end interrupt enable
+  // pointers and counters
+  reg  [PAW-1:0] pc;     // program counter
+  reg  [PAW-1:0] pma;    // CPU memory access address
+  reg  [PAW-1:0] p0;     // source      pointer
+  reg  [PAW-1:0] p1;     // destination pointer
+  reg      [7:0] lc;     // loop counter
+  // instruction execution
+  reg      [2:0] state;  // engine state
+  reg      [3:0] opc;    // opcode
+  reg      [7:0] arg;    // operand (byte/cycle counter)
+  reg      [7:0] sft;    // data byte shift register
+  reg      [2:0] bcn;    // bit counter
+  reg      [7:0] crc;    // CRC8 accumulator
+
+  // memory data at the program counter
+  wire     [7:0] mdt = mem[pc];
+
+  // end of 1-wire cycle
+  wire           cyc_end = owr_cyc & pls & (cnt == t_zero);
+
+  // CPU bus read data
+  assign bus_rdt_prg = {8'h00, 8'h00 | pma, 8'h00 | pc, ien, sts, 3'b000, ovd, err, run};
+  assign bus_rdt_pmd = mem[pma];
+
+  // program memory write (CPU bus, read data, CRC status)
+  always @ (posedge clk)
+  if (bus_wen_pmd)                                          mem[pma] <= bus_wdt[7:0];
+  else if (~bus_wen_prg) begin
+    if ((state == PRG_NXT) & (opc == OP_RDP) & (&bcn))      mem[p1 ] <= {owr_dat, sft[7:1]};
+    else if (state == PRG_STO)                              mem[p1 ] <= crc;
+  end
+
+  // engine state machine
+  always @ (posedge clk, posedge rst)
+  if (rst) begin
+    run   <= 1'b0;
+    err   <= 1'b0;
+    ovd   <= 1'b0;
+    sts   <= 1'b0;
+    ien   <= 1'b0;
+    pc    <= 'd0;
+    pma   <= 'd0;
+    p0    <= 'd0;
+    p1    <= 'd0;
+    lc    <= 8'd0;
+    state <= PRG_IDL;
+    opc   <= OP_END;
+    arg   <= 8'd0;
+    sft   <= 8'd0;
+    bcn   <= 3'd0;
+    crc   <= 8'd0;
+  end else if (bus_wen_prg) begin
+    // CPU control register write starts or stops the program
+    run   <= bus_wdt[0];
+    err   <= 1'b0;
+    ovd   <= OVD_E ? bus_wdt[2] : 1'b0;
+    sts   <= 1'b0;
+    ien   <= bus_wdt[7];
+    pc    <= bus_wdt[ 8+:PAW];
+    pma   <= bus_wdt[16+:PAW];
+    crc   <= 8'd0;
+    state <= bus_wdt[0] ? PRG_OPC : PRG_IDL;
+  end else begin
+    // CPU status read clears the program end status
+    if (bus_ren_prg)                sts <= 1'b0;
+    // CPU memory access address increment
+    if (bus_ren_pmd | bus_wen_pmd)  pma <= pma + 'd1;
+    // instruction execution
+    case (state)
+      PRG_OPC : begin
+        opc <= mdt[3:0];
+        pc  <= pc + 'd1;
+        case (mdt[3:0])
+          OP_END  : begin run <= 1'b0; sts <= 1'b1;              state <= PRG_IDL; end
+          OP_RST  :                                              state <= PRG_CYC;
+          OP_CRC  :                                              state <= PRG_STO;
+          OP_WRI, OP_WRP, OP_RDP, OP_DLY, OP_PWR,
+          OP_SP0, OP_SP1, OP_LDC, OP_DJN :                       state <= PRG_ARG;
+          default : begin run <= 1'b0; sts <= 1'b1; err <= 1'b1; state <= PRG_IDL; end
+        endcase
+      end
+      PRG_ARG : begin
+        arg <= mdt;
+        pc  <= pc + 'd1;
+        case (opc)
+          OP_WRI, OP_WRP :                                  state <= ~|mdt ? PRG_OPC : PRG_DAT;
+          OP_RDP  : begin sft <= 8'hff; bcn <= 3'd0;        state <= ~|mdt ? PRG_OPC : PRG_CYC; end
+          OP_DLY  :                                         state <= ~|mdt ? PRG_OPC : PRG_CYC;
+          OP_SP0  : begin p0 <= mdt[PAW-1:0];               state <= PRG_OPC; end
+          OP_SP1  : begin p1 <= mdt[PAW-1:0];               state <= PRG_OPC; end
+          OP_LDC  : begin lc <= mdt;                        state <= PRG_OPC; end
+          OP_DJN  : begin lc <= lc - 'd1;
+                          if (lc != 8'd1)  pc <= mdt[PAW-1:0];
+                                                            state <= PRG_OPC; end
+          default :                                         state <= PRG_OPC;  // OP_PWR
+        endcase
+      end
+      PRG_DAT : begin
+        if (opc == OP_WRI) begin  sft <= mdt;      pc <= pc + 'd1;  end
+        else               begin  sft <= mem[p0];  p0 <= p0 + 'd1;  end
+        bcn   <= 3'd0;
+        state <= PRG_CYC;
+      end
+      PRG_CYC :                  state <= PRG_WAI;
+      PRG_WAI : if (cyc_end)     state <= PRG_NXT;
+      PRG_NXT : begin
+        case (opc)
+          OP_RST : begin
+            crc <= 8'd0;
+            if (owr_dat) begin  run <= 1'b0; sts <= 1'b1; err <= 1'b1;  state <= PRG_IDL;  end
+            else                                                        state <= PRG_OPC;
+          end
+          OP_DLY : begin
+            arg   <= arg - 'd1;
+            state <= (arg == 8'd1) ? PRG_OPC : PRG_CYC;
+          end
+          default : begin  // OP_WRI, OP_WRP, OP_RDP
+            sft <= {owr_dat, sft[7:1]};
+            bcn <= bcn + 'd1;
+            // CRC8 (X^8 + X^5 + X^4 + 1) of read data
+            if (opc == OP_RDP)  crc <= {1'b0, crc[7:1]} ^ ((crc[0] ^ owr_dat) ? 8'h8c : 8'h00);
+            if (~&bcn)          state <= PRG_CYC;
+            else begin
+              arg <= arg - 'd1;
+              if (opc == OP_RDP) begin  p1 <= p1 + 'd1;  sft <= 8'hff;  end
+              state <= (arg == 8'd1) ? PRG_OPC : (opc == OP_RDP) ? PRG_CYC : PRG_DAT;
+            end
+          end
+        endcase
+      end
+      PRG_STO : begin
+        p1    <= p1 + 'd1;
+        err   <= err | (|crc);
+        crc   <= 8'd0;
+        state <= PRG_OPC;
+      end
+      default : ;  // PRG_IDL
+    endcase
+  end
+
+  // 1-wire cycle request
+  assign prg_req = (state == PRG_CYC);
+  assign prg_cmd = (opc == OP_RST) ? 2'b10 : (opc == OP_DLY) ? 2'b11 : {1'b0, sft[0]};
+  assign prg_ovd = ovd & (opc != OP_DLY);  // delay cycles are always in normal mode
+  // program status
+  assign prg_run = run;
+  assign prg_irq = ien & sts;
+  // strong pull-up
+  assign prg_pwr_wen = (state == PRG_ARG) & (opc == OP_PWR) & ~bus_wen_prg;
+  assign prg_pwr     = mdt[0];
+
+end else begin : prg_none
+
+  assign bus_rdt_prg = 32'h0000_0000;
+  assign bus_rdt_pmd =  8'h00;
+  assign prg_req     = 1'b0;
+  assign prg_cmd     = 2'b00;
+  assign prg_ovd     = 1'b0;
+  assign prg_run     = 1'b0;
+  assign prg_irq     = 1'b0;
+  assign prg_pwr_wen = 1'b0;
+  assign prg_pwr     = 1'b0;
+
+end endgenerate
+
 //////////////////////////////////////////////////////////////////////////////
 // IO
 //////////////////////////////////////////////////////////////////////////////
@@ -77,5 +77,60 @@
 #define SOCKIT_OWM_CDR_O_MSK             (0xffff0000)  // overdrive mode
 #define SOCKIT_OWM_CDR_O_OFST            (16)
 
+//////////////////////////////////////////////////////////////////////////////
+// program engine control status register                                   //
+//////////////////////////////////////////////////////////////////////////////
+
+#define SOCKIT_OWM_PRG_REG               2
+#define IOADDR_SOCKIT_OWM_PRG(base)      IO_CALC_ADDRESS_NATIVE(base, SOCKIT_OWM_PRG_REG)
+#define IORD_SOCKIT_OWM_PRG(base)        IORD(base, SOCKIT_OWM_PRG_REG)
+#define IOWR_SOCKIT_OWM_PRG(base, data)  IOWR(base, SOCKIT_OWM_PRG_REG, data)
+
+#define SOCKIT_OWM_PRG_RUN_MSK           (0x00000001)  // program run (write), running (read)
+#define SOCKIT_OWM_PRG_RUN_OFST          (0)
+#define SOCKIT_OWM_PRG_ERR_MSK           (0x00000002)  // error status (missing presence, CRC)
+#define SOCKIT_OWM_PRG_ERR_OFST          (1)
+#define SOCKIT_OWM_PRG_OVD_MSK           (0x00000004)  // overdrive
+#define SOCKIT_OWM_PRG_OVD_OFST          (2)
+#define SOCKIT_OWM_PRG_STS_MSK           (0x00000040)  // program end status
+#define SOCKIT_OWM_PRG_STS_OFST          (6)
+#define SOCKIT_OWM_PRG_IEN_MSK           (0x00000080)  // program end irq enable
+#define SOCKIT_OWM_PRG_IEN_OFST          (7)
+
+#define SOCKIT_OWM_PRG_PC_MSK            (0x0000ff00)  // program counter
+#define SOCKIT_OWM_PRG_PC_OFST           (8)
+
+#define SOCKIT_OWM_PRG_PMA_MSK           (0x00ff0000)  // program memory access address
+#define SOCKIT_OWM_PRG_PMA_OFST          (16)
+
+//////////////////////////////////////////////////////////////////////////////
+// program engine memory data register                                      //
+//////////////////////////////////////////////////////////////////////////////
+
+#define SOCKIT_OWM_PMD_REG               3
+#define IOADDR_SOCKIT_OWM_PMD(base)      IO_CALC_ADDRESS_NATIVE(base, SOCKIT_OWM_PMD_REG)
+#define IORD_SOCKIT_OWM_PMD(base)        IORD(base, SOCKIT_OWM_PMD_REG)
+#define IOWR_SOCKIT_OWM_PMD(base, data)  IOWR(base, SOCKIT_OWM_PMD_REG, data)
+
+#define SOCKIT_OWM_PMD_DAT_MSK           (0x000000ff)  // data byte (address auto increment)
+#define SOCKIT_OWM_PMD_DAT_OFST          (0)
+
+//////////////////////////////////////////////////////////////////////////////
+// program engine opcodes                                                   //
+//////////////////////////////////////////////////////////////////////////////
+
+#define SOCKIT_OWM_OP_END                (0x00)  // end of program
+#define SOCKIT_OWM_OP_RST                (0x01)  // reset, end with error if no presence
+#define SOCKIT_OWM_OP_WRI                (0x02)  // write n immediate bytes
+#define SOCKIT_OWM_OP_WRP                (0x03)  // write n bytes from memory at P0
+#define SOCKIT_OWM_OP_RDP                (0x04)  // read  n bytes into memory at P1
+#define SOCKIT_OWM_OP_CRC                (0x05)  // store CRC8 status at P1
+#define SOCKIT_OWM_OP_DLY                (0x06)  // n delay cycles
+#define SOCKIT_OWM_OP_PWR                (0x07)  // strong pull-up on/off
+#define SOCKIT_OWM_OP_SP0                (0x08)  // set source      pointer P0
+#define SOCKIT_OWM_OP_SP1                (0x09)  // set destination pointer P1
+#define SOCKIT_OWM_OP_LDC                (0x0a)  // load loop counter
+#define SOCKIT_OWM_OP_DJN                (0x0b)  // decrement loop counter, jump if not zero
+
 
 #endif /* __SOCKIT_OWM_REGS_H__ */
@@ -0,0 +1,45 @@
+//////////////////////////////////////////////////////////////////////////////
+//                                                                          //
+//  Minimalistic 1-wire (onewire) master with Avalon MM bus interface       //
+//                                                                          //
+//  Copyright (C) 2010  Iztok Jeras                                         //
+//                                                                          //
+//////////////////////////////////////////////////////////////////////////////
+//                                                                          //
+//  This program is free software: you can redistribute it and/or modify    //
+//  it under the terms of the GNU Lesser General Public License             //
+//  as published by the Free Software Foundation, either                    //
+//  version 3 of the License, or (at your option) any later version.        //
+//                                                                          //
+//  This program is distributed in the hope that it will be useful,         //
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of          //
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the           //
+//  GNU General Public License for more details.                            //
+//                                                                          //
+//  You should have received a copy of the GNU General Public License       //
+//  along with this program.  If not, see <http://www.gnu.org/licenses/>.   //
+//                                                                          //
+//////////////////////////////////////////////////////////////////////////////
+
+
+
+// host replacement for the Altera HAL header
+
+#ifndef __ALT_TYPES_H__
+#define __ALT_TYPES_H__
+
+#include <stdint.h>
+
+typedef int8_t   alt_8;
+typedef uint8_t  alt_u8;
+typedef int16_t  alt_16;
+typedef uint16_t alt_u16;
+typedef int32_t  alt_32;
+typedef uint32_t alt_u32;
+typedef int64_t  alt_64;
+typedef uint64_t alt_u64;
+
+#define ALT_INLINE        __inline__
+#define ALT_ALWAYS_INLINE __attribute__ ((always_inline))
+
+#endif // __ALT_TYPES_H__
@@ -0,0 +1,51 @@
+//////////////////////////////////////////////////////////////////////////////
+//                                                                          //
+//  Minimalistic 1-wire (onewire) master with Avalon MM bus interface       //
+//                                                                          //
+//  Copyright (C) 2010  Iztok Jeras                                         //
+//                                                                          //
+//////////////////////////////////////////////////////////////////////////////
+//                                                                          //
+//  This program is free software: you can redistribute it and/or modify    //
+//  it under the terms of the GNU Lesser General Public License             //
+//  as published by the Free Software Foundation, either                    //
+//  version 3 of the License, or (at your option) any later version.        //
+//                                                                          //
+//  This program is distributed in the hope that it will be useful,         //
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of          //
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the           //
+//  GNU General Public License for more details.                            //
+//                                                                          //
+//  You should have received a copy of the GNU General Public License       //
+//  along with this program.  If not, see <http://www.gnu.org/licenses/>.   //
+//                                                                          //
+//////////////////////////////////////////////////////////////////////////////
+
+
+
+// host replacement for the Altera HAL header, register accesses are
+// forwarded to the simulation backend (RTL model or virtual bus)
+
+#ifndef __IO_H__
+#define __IO_H__
+
+#include "alt_types.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif // __cplusplus
+
+extern alt_u32 sockit_owm_host_rd (void *base, int reg);
+extern void    sockit_owm_host_wr (void *base, int reg, alt_u32 dat);
+
+#ifdef __cplusplus
+}
+#endif // __cplusplus
+
+#define IO_CALC_ADDRESS_NATIVE(base, reg)  ((void *) (((alt_u32 *) (base)) + (reg)))
+
+#define IORD(base, reg)       sockit_owm_host_rd ((void *) (base), (reg))
+#define IOWR(base, reg, dat)  sockit_owm_host_wr ((void *) (base), (reg), (dat))
+
+#endif // __IO_H__
@@ -0,0 +1,49 @@
+//////////////////////////////////////////////////////////////////////////////
+//                                                                          //
+//  Minimalistic 1-wire (onewire) master with Avalon MM bus interface       //
+//                                                                          //
+//  Copyright (C) 2010  Iztok Jeras                                         //
+//                                                                          //
+//////////////////////////////////////////////////////////////////////////////
+//                                                                          //
+//  This program is free software: you can redistribute it and/or modify    //
+//  it under the terms of the GNU Lesser General Public License             //
+//  as published by the Free Software Foundation, either                    //
+//  version 3 of the License, or (at your option) any later version.        //
+//                                                                          //
+//  This program is distributed in the hope that it will be useful,         //
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of          //
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the           //
+//  GNU General Public License for more details.                            //
+//                                                                          //
+//  You should have received a copy of the GNU General Public License       //
+//  along with this program.  If not, see <http://www.gnu.org/licenses/>.   //
+//                                                                          //
+//////////////////////////////////////////////////////////////////////////////
+
+
+
+// host replacement for the Altera HAL header, the driver always polls the
+// CYC bit after waiting for the flag, so pending can return immediately
+
+#ifndef __ALT_FLAG_H__
+#define __ALT_FLAG_H__
+
+#define OS_FLAG_WAIT_CLR_ALL   0
+#define OS_FLAG_WAIT_CLR_ANY   1
+#define OS_FLAG_WAIT_SET_ALL   2
+#define OS_FLAG_WAIT_SET_ANY   3
+#define OS_FLAG_CONSUME        0x80
+
+#define OS_FLAG_CLR            0
+#define OS_FLAG_SET            1
+
+#define ALT_FLAG_GRP(group)
+#define ALT_EXTERN_FLAG_GRP(group)
+#define ALT_STATIC_FLAG_GRP(group)
+
+#define ALT_FLAG_CREATE(group, flags)                 0
+#define ALT_FLAG_PEND(group, flags, wait, timeout)    ((void) (flags))
+#define ALT_FLAG_POST(group, flags, opt)              ((void) (flags))
+
+#endif // __ALT_FLAG_H__
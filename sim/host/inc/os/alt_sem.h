@@ -0,0 +1,40 @@
+//////////////////////////////////////////////////////////////////////////////
+//                                                                          //
+//  Minimalistic 1-wire (onewire) master with Avalon MM bus interface       //
+//                                                                          //
+//  Copyright (C) 2010  Iztok Jeras                                         //
+//                                                                          //
+//////////////////////////////////////////////////////////////////////////////
+//                                                                          //
+//  This program is free software: you can redistribute it and/or modify    //
+//  it under the terms of the GNU Lesser General Public License             //
+//  as published by the Free Software Foundation, either                    //
+//  version 3 of the License, or (at your option) any later version.        //
+//                                                                          //
+//  This program is distributed in the hope that it will be useful,         //
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of          //
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the           //
+//  GNU General Public License for more details.                            //
+//                                                                          //
+//  You should have received a copy of the GNU General Public License       //
+//  along with this program.  If not, see <http://www.gnu.org/licenses/>.   //
+//                                                                          //
+//////////////////////////////////////////////////////////////////////////////
+
+
+
+// host replacement for the Altera HAL header, a single threaded host
+// program does not need the cycle lock
+
+#ifndef __ALT_SEM_H__
+#define __ALT_SEM_H__
+
+#define ALT_SEM(sem)
+#define ALT_EXTERN_SEM(sem)
+#define ALT_STATIC_SEM(sem)
+
+#define ALT_SEM_CREATE(sem, value)  0
+#define ALT_SEM_PEND(sem, timeout)  ((void) 0)
+#define ALT_SEM_POST(sem)           ((void) 0)
+
+#endif // __ALT_SEM_H__
@@ -0,0 +1,57 @@
+//////////////////////////////////////////////////////////////////////////////
+//                                                                          //
+//  Minimalistic 1-wire (onewire) master with Avalon MM bus interface       //
+//                                                                          //
+//  Copyright (C) 2010  Iztok Jeras                                         //
+//                                                                          //
+//////////////////////////////////////////////////////////////////////////////
+//                                                                          //
+//  This program is free software: you can redistribute it and/or modify    //
+//  it under the terms of the GNU Lesser General Public License             //
+//  as published by the Free Software Foundation, either                    //
+//  version 3 of the License, or (at your option) any later version.        //
+//                                                                          //
+//  This program is distributed in the hope that it will be useful,         //
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of          //
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the           //
+//  GNU General Public License for more details.                            //
+//                                                                          //
+//  You should have received a copy of the GNU General Public License       //
+//  along with this program.  If not, see <http://www.gnu.org/licenses/>.   //
+//                                                                          //
+//////////////////////////////////////////////////////////////////////////////
+
+
+
+// host replacement for the Altera HAL header, the registered handler is
+// called by the simulation backend while the interrupt line is active
+
+#ifndef __ALT_IRQ_H__
+#define __ALT_IRQ_H__
+
+#include "system.h"
+#include "alt_types.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif // __cplusplus
+
+#define ALT_IRQ_NOT_CONNECTED  (-1)
+
+typedef void (*alt_isr_func) (void *isr_context);
+
+extern int  alt_ic_isr_register (alt_u32 ic_id, alt_u32 irq, alt_isr_func isr, void *isr_context, void *flags);
+
+// the handler is only called from register accesses, so there is nothing
+// to disable
+typedef int alt_irq_context;
+
+static inline alt_irq_context alt_irq_disable_all (void)  { return 0; }
+static inline void alt_irq_enable_all (alt_irq_context context)  { (void) context; }
+
+#ifdef __cplusplus
+}
+#endif // __cplusplus
+
+#endif // __ALT_IRQ_H__
@@ -0,0 +1,62 @@
+//////////////////////////////////////////////////////////////////////////////
+//                                                                          //
+//  Minimalistic 1-wire (onewire) master with Avalon MM bus interface       //
+//                                                                          //
+//  Copyright (C) 2010  Iztok Jeras                                         //
+//                                                                          //
+//////////////////////////////////////////////////////////////////////////////
+//                                                                          //
+//  This program is free software: you can redistribute it and/or modify    //
+//  it under the terms of the GNU Lesser General Public License             //
+//  as published by the Free Software Foundation, either                    //
+//  version 3 of the License, or (at your option) any later version.        //
+//                                                                          //
+//  This program is distributed in the hope that it will be useful,         //
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of          //
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the           //
+//  GNU General Public License for more details.                            //
+//                                                                          //
+//  You should have received a copy of the GNU General Public License       //
+//  along with this program.  If not, see <http://www.gnu.org/licenses/>.   //
+//                                                                          //
+//////////////////////////////////////////////////////////////////////////////
+
+
+
+// host replacement for the generated BSP header, describes a single
+// sockit_owm instance, the defaults match the RTL parameter defaults
+// (1MHz clock, 5us normal and 1us overdrive base time period)
+
+#ifndef __SYSTEM_H__
+#define __SYSTEM_H__
+
+#define ALT_ENHANCED_INTERRUPT_API_PRESENT
+
+#ifndef SOCKIT_OWM_OWN
+#define SOCKIT_OWM_OWN    1
+#endif
+#ifndef SOCKIT_OWM_OVD_E
+#define SOCKIT_OWM_OVD_E  1
+#endif
+#ifndef SOCKIT_OWM_CDR_E
+#define SOCKIT_OWM_CDR_E  0
+#endif
+#ifndef SOCKIT_OWM_PRG_E
+#define SOCKIT_OWM_PRG_E  0
+#endif
+#ifndef SOCKIT_OWM_PAW
+#define SOCKIT_OWM_PAW    6
+#endif
+
+#define SOCKIT_OWM_NAME   "/dev/sockit_owm"
+#define SOCKIT_OWM_BASE   0x1000
+#define SOCKIT_OWM_IRQ    0
+#define SOCKIT_OWM_IRQ_INTERRUPT_CONTROLLER_ID 0
+#define SOCKIT_OWM_BTP_N  "5.0"
+#define SOCKIT_OWM_BTP_O  "1.0"
+#define SOCKIT_OWM_CDR_N  4
+#define SOCKIT_OWM_CDR_O  0
+// u16.16 inverse of the 1ms delay cycle (200 * 5us)
+#define SOCKIT_OWM_F_DLY  0x10000
+
+#endif // __SYSTEM_H__
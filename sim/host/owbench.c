@@ -0,0 +1,262 @@
+//////////////////////////////////////////////////////////////////////////////
+//                                                                          //
+//  Minimalistic 1-wire (onewire) master with Avalon MM bus interface       //
+//                                                                          //
+//  Copyright (C) 2010  Iztok Jeras                                         //
+//                                                                          //
+//////////////////////////////////////////////////////////////////////////////
+//                                                                          //
+//  This program is free software: you can redistribute it and/or modify    //
+//  it under the terms of the GNU Lesser General Public License             //
+//  as published by the Free Software Foundation, either                    //
+//  version 3 of the License, or (at your option) any later version.        //
+//                                                                          //
+//  This program is distributed in the hope that it will be useful,         //
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of          //
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the           //
+//  GNU General Public License for more details.                            //
+//                                                                          //
+//  You should have received a copy of the GNU General Public License       //
+//  along with this program.  If not, see <http://www.gnu.org/licenses/>.   //
+//                                                                          //
+//////////////////////////////////////////////////////////////////////////////
+
+
+
+//////////////////////////////////////////////////////////////////////////////
+//                                                                          //
+// HAL driver benchmark                                                     //
+//                                                                          //
+// Runs each API call over a set of topologies (device count, family,       //
+// speed and power) on the virtual time bus simulator and prints one JSON   //
+// object per line with the average cost of a single call:                  //
+// - bus_us     1-wire bus time in microseconds                             //
+// - ctl_wr     CTL register writes                                         //
+// - ctl_rd     CTL register reads                                          //
+// - irq        interrupts taken                                            //
+// - crc_bytes  bytes processed by the software CRC (docrc8/docrc16)        //
+//                                                                          //
+// The CRC functions are counted with the linker option                     //
+// -Wl,--wrap=docrc8,--wrap=docrc16                                         //
+//                                                                          //
+//////////////////////////////////////////////////////////////////////////////
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "system.h"
+#include "ownet.h"
+#include "temp10.h"
+#include "temp28.h"
+#include "temp42.h"
+
+#include "sockit_owm_host.h"
+#include "owsim.h"
+
+#ifndef OWBENCH_REV
+#define OWBENCH_REV "unknown"
+#endif
+
+static owsim    sim;
+static uint64_t crc_bytes;
+
+//--------------------------------------------------------------------------
+// software CRC counters
+//
+extern uchar  __real_docrc8  (int portnum, uchar x);
+extern ushort __real_docrc16 (int portnum, ushort cdata);
+
+uchar __wrap_docrc8 (int portnum, uchar x)
+{
+  crc_bytes++;
+  return __real_docrc8 (portnum, x);
+}
+
+ushort __wrap_docrc16 (int portnum, ushort cdata)
+{
+  crc_bytes++;
+  return __real_docrc16 (portnum, cdata);
+}
+
+//--------------------------------------------------------------------------
+// measurement
+//
+typedef struct owbench_cnt_s
+{
+  uint64_t    t, ctl_wr, ctl_rd, irq, crc;
+} owbench_cnt;
+
+typedef struct owbench_s
+{
+  // topology
+  int         num;
+  int         family;
+  int         ovd;
+  int         parasite;
+  // accumulated cost of the measured calls
+  owbench_cnt beg, sum;
+  int         calls;
+} owbench;
+
+static void bench_clear (owbench *b)
+{
+  memset (&b->sum, 0, sizeof (owbench_cnt));
+  b->calls = 0;
+}
+
+static void bench_begin (owbench *b)
+{
+  b->beg.t      = sim.t;
+  b->beg.ctl_wr = sim.n_ctl_wr;
+  b->beg.ctl_rd = sim.n_ctl_rd;
+  b->beg.irq    = sim.n_irq;
+  b->beg.crc    = crc_bytes;
+}
+
+static void bench_end (owbench *b)
+{
+  b->sum.t      += sim.t        - b->beg.t;
+  b->sum.ctl_wr += sim.n_ctl_wr - b->beg.ctl_wr;
+  b->sum.ctl_rd += sim.n_ctl_rd - b->beg.ctl_rd;
+  b->sum.irq    += sim.n_irq    - b->beg.irq;
+  b->sum.crc    += crc_bytes    - b->beg.crc;
+  b->calls++;
+}
+
+static void bench_report (owbench *b, const char *op)
+{
+  double n = b->calls ? b->calls : 1;
+
+  printf ("{\"rev\":\"%s\",\"op\":\"%s\",\"devices\":%d,\"family\":\"0x%02X\","
+          "\"speed\":\"%s\",\"power\":\"%s\",\"calls\":%d,"
+          "\"bus_us\":%.3f,\"ctl_wr\":%.2f,\"ctl_rd\":%.2f,\"irq\":%.2f,\"crc_bytes\":%.2f}\n",
+          OWBENCH_REV, op, b->num, b->family,
+          b->ovd ? "overdrive" : "normal", b->parasite ? "parasite" : "external", b->calls,
+          b->sum.t / 1.0e3 / n, b->sum.ctl_wr / n, b->sum.ctl_rd / n, b->sum.irq / n, b->sum.crc / n);
+  bench_clear (b);
+}
+
+// switch all devices to overdrive speed (Overdrive Skip ROM)
+static void bench_speed (owbench *b)
+{
+  owSpeed (0, MODE_NORMAL);
+  if (b->ovd) {
+    owTouchReset (0);
+    owWriteByte (0, 0x3C);
+    owSpeed (0, MODE_OVERDRIVE);
+  }
+}
+
+static int bench_topology (owbench *b)
+{
+  sockit_owm_host host = {owsim_rd, owsim_wr, &sim};
+  uchar (*sn)[8];
+  uchar buf[10];
+  owslave *dev;
+  float temp;
+  int i, n, ok;
+
+  if (owsim_init (&sim, SOCKIT_OWM_OWN, SOCKIT_OWM_BTP_N, SOCKIT_OWM_BTP_O))  return -1;
+  dev = owsim_populate (&sim, 0, b->num, b->family, b->parasite, 1);
+  sn  = malloc ((b->num+1) * sizeof (*sn));
+  if (!dev || !sn)  return -1;
+  sockit_owm_host_init (&host);
+  if (!owAcquire (0, NULL))  return -1;
+  bench_speed (b);
+  bench_clear (b);
+
+  // search the whole network
+  n = 0;
+  do {
+    bench_begin (b);
+    ok = n ? owNext (0, TRUE, FALSE) : owFirst (0, TRUE, FALSE);
+    bench_end (b);
+    if (ok)  owSerialNum (0, sn[n++], TRUE);
+  } while (ok && (n <= b->num));
+  bench_report (b, "owNext");
+
+  // select each device
+  for (i=0; i<n; i++) {
+    owSerialNum (0, sn[i], FALSE);
+    bench_begin (b);
+    owAccess (0);
+    bench_end (b);
+  }
+  bench_report (b, "owAccess");
+
+  // read the scratchpad of each device
+  for (i=0; i<n; i++) {
+    owSerialNum (0, sn[i], FALSE);
+    owAccess (0);
+    memset (buf, 0xFF, sizeof (buf));
+    buf[0] = 0xBE;
+    bench_begin (b);
+    owBlock (0, FALSE, buf, sizeof (buf));
+    bench_end (b);
+  }
+  bench_report (b, "owBlock");
+
+  // verify each device
+  for (i=0; i<n; i++) {
+    owSerialNum (0, sn[i], FALSE);
+    bench_begin (b);
+    owVerify (0, FALSE);
+    bench_end (b);
+  }
+  bench_report (b, "owVerify");
+
+  // read the temperature of each device
+  for (i=0; i<n; i++) {
+    bench_begin (b);
+    if (b->family == 0x10)  ReadTemperature10 (0, sn[i], &temp);
+    if (b->family == 0x28)  ReadTemperature28 (0, sn[i], &temp);
+    if (b->family == 0x42)  ReadTemperature42 (0, sn[i], &temp);
+    bench_end (b);
+    // ReadTemperature42 returns to normal speed
+    bench_speed (b);
+  }
+  bench_report (b, (b->family == 0x10) ? "ReadTemperature10" :
+                   (b->family == 0x28) ? "ReadTemperature28" : "ReadTemperature42");
+
+  owRelease (0);
+  owsim_free (&sim);
+  free (dev);
+  free (sn);
+  return (n == b->num) ? 0 : -1;
+}
+
+//--------------------------------------------------------------------------
+// arguments: comma separated list of device counts (default "1,10,100")
+//
+int main (int argc, char **argv)
+{
+  static const int family[] = {0x10, 0x28, 0x42};
+  char list[256], *tok;
+  owbench b;
+  int f, p, o, err = 0;
+
+  strncpy (list, (argc > 1) ? argv[1] : "1,10,100", sizeof (list) - 1);
+  list[sizeof (list) - 1] = '\0';
+
+  for (tok = strtok (list, ","); tok; tok = strtok (NULL, ",")) {
+    b.num = atoi (tok);
+    if (b.num < 1)  continue;
+    for (f=0; f<3; f++) {
+      b.family = family[f];
+      for (p=0; p<2; p++) {
+        b.parasite = p;
+        // only the DS28EA00 supports overdrive
+        for (o=0; o<=(b.family == 0x42); o++) {
+          b.ovd = o;
+          if (bench_topology (&b)) {
+            fprintf (stderr, "ERROR: %d devices, family 0x%02X, %s speed, %s power\n", b.num, b.family,
+                     b.ovd ? "overdrive" : "normal", b.parasite ? "parasite" : "external");
+            err++;
+          }
+        }
+      }
+    }
+  }
+  return err ? 1 : 0;
+}
@@ -0,0 +1,244 @@
+//////////////////////////////////////////////////////////////////////////////
+//                                                                          //
+//  Minimalistic 1-wire (onewire) master with Avalon MM bus interface       //
+//                                                                          //
+//  Copyright (C) 2010  Iztok Jeras                                         //
+//                                                                          //
+//////////////////////////////////////////////////////////////////////////////
+//                                                                          //
+//  This program is free software: you can redistribute it and/or modify    //
+//  it under the terms of the GNU Lesser General Public License             //
+//  as published by the Free Software Foundation, either                    //
+//  version 3 of the License, or (at your option) any later version.        //
+//                                                                          //
+//  This program is distributed in the hope that it will be useful,         //
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of          //
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the           //
+//  GNU General Public License for more details.                            //
+//                                                                          //
+//  You should have received a copy of the GNU General Public License       //
+//  along with this program.  If not, see <http://www.gnu.org/licenses/>.   //
+//                                                                          //
+//////////////////////////////////////////////////////////////////////////////
+
+
+
+//////////////////////////////////////////////////////////////////////////////
+//                                                                          //
+// HAL driver fault recovery cost                                           //
+//                                                                          //
+// Runs the demo application flow (search, then ReadTemperatureXX for each  //
+// device and owVerify after a failed read) on the virtual time bus         //
+// simulator, once without faults and once for each fault class. A search   //
+// which misses devices is repeated (up to OWFAULT_RETRY times). The        //
+// report lists the cost of each operation and the extra cost spent by the  //
+// driver compared to the fault free run:                                   //
+// - bus_ms     1-wire bus time for each call                               //
+// - ctl        CTL register accesses (writes and reads) for each call      //
+// - faults     number of injected faults                                   //
+// - failed     calls which returned FALSE (searches which missed devices)  //
+//              or a stale temperature (the devices change temperature in   //
+//              each round)                                                 //
+// - extra      bus time and CTL accesses of the successful calls above     //
+//              the same calls of the fault free run, for each successful   //
+//              call and for each fault injected into them (failed calls    //
+//              may end early, so they do not measure the recovery cost)    //
+// - fail_ms    bus time for each failed call                               //
+//                                                                          //
+//////////////////////////////////////////////////////////////////////////////
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "system.h"
+#include "ownet.h"
+#include "temp10.h"
+#include "temp28.h"
+#include "temp42.h"
+
+#include "sockit_owm_host.h"
+#include "owsim.h"
+
+static owsim sim;
+
+static const char *owfault_name [OWSIM_FAULT_NUM] = {
+  "none", "noise", "presence", "short", "slow"
+};
+
+// default fault rates [1/65536] (presence faults are only injected into
+// reset cycles, so the rate is higher)
+static const unsigned owfault_rate [OWSIM_FAULT_NUM] = {
+  0, 64, 4096, 64, 64
+};
+
+#define OWFAULT_RETRY  4
+
+// accumulated cost of an operation, the extra cost of a successful call is
+// taken against the same call of the fault free run (a call can be faster,
+// when an earlier failed call left a conversion running, that is not
+// counted as a negative recovery cost)
+typedef struct owfault_cnt_s
+{
+  uint64_t    t, ctl, flt;
+  uint64_t    t0, ctl0, flt0;       // start of the running call
+  uint64_t    xt, xctl;             // extra cost of the successful calls
+  uint64_t    xflt;                 // faults injected into successful calls
+  uint64_t    ft;                   // bus time of the failed calls
+  uint64_t    *call_t, *call_ctl;   // cost of each call (fault free run)
+  int         calls, failed;
+} owfault_cnt;
+
+#define OWFAULT_SEARCH  0
+#define OWFAULT_READ    1
+
+static void fault_begin (owfault_cnt *c)
+{
+  c->t0   = sim.t;
+  c->ctl0 = sim.n_ctl_wr + sim.n_ctl_rd;
+  c->flt0 = sim.flt.n;
+}
+
+// the fault free run 'b' is NULL while it is recorded
+static void fault_end (owfault_cnt *c, const owfault_cnt *b, int ok)
+{
+  uint64_t t   = sim.t - c->t0;
+  uint64_t ctl = sim.n_ctl_wr + sim.n_ctl_rd - c->ctl0;
+  uint64_t flt = sim.flt.n - c->flt0;
+
+  if (!b) {
+    c->call_t  [c->calls] = t;
+    c->call_ctl[c->calls] = ctl;
+  } else if (ok) {
+    c->xt   += (t   > b->call_t  [c->calls]) ? t   - b->call_t  [c->calls] : 0;
+    c->xctl += (ctl > b->call_ctl[c->calls]) ? ctl - b->call_ctl[c->calls] : 0;
+    c->xflt += flt;
+  }
+  if (!ok)  c->ft += t;
+  c->t   += t;
+  c->ctl += ctl;
+  c->flt += flt;
+  c->calls++;
+  c->failed += !ok;
+}
+
+static int fault_read (int family, uchar *sn, int *temp)
+{
+  if (family == 0x10)  return ReadTemperature10Int (0, sn, temp);
+  if (family == 0x28)  return ReadTemperature28Int (0, sn, temp);
+  if (family == 0x42)  return ReadTemperature42Int (0, sn, temp);
+  return FALSE;
+}
+
+// device temperature in round 'r' [1/16 C]
+#define OWFAULT_TEMP(r)  ((20 << 4) + (r))
+
+// one run of the application flow with the given fault class, compared to
+// the fault free run 'b' (NULL for the fault free run)
+static int fault_run (int num, int family, int rounds, int type, unsigned rate, owfault_cnt *c, const owfault_cnt *b)
+{
+  sockit_owm_host host = {owsim_rd, owsim_wr, &sim};
+  uchar (*sn)[8];
+  owslave *dev;
+  int i, r, t, n, ok, temp;
+
+  if (owsim_init (&sim, SOCKIT_OWM_OWN, SOCKIT_OWM_BTP_N, SOCKIT_OWM_BTP_O))  return -1;
+  dev = owsim_populate (&sim, 0, num, family, 0, 1);
+  sn  = malloc ((num+1) * sizeof (*sn));
+  if (!dev || !sn)  return -1;
+  sockit_owm_host_init (&host);
+  if (!owAcquire (0, NULL))  return -1;
+  memset (c, 0, 2 * sizeof (owfault_cnt));
+  if (!b) {
+    c[OWFAULT_SEARCH].call_t   = malloc (rounds * sizeof (uint64_t));
+    c[OWFAULT_SEARCH].call_ctl = malloc (rounds * sizeof (uint64_t));
+    c[OWFAULT_READ].call_t     = malloc (rounds * num * sizeof (uint64_t));
+    c[OWFAULT_READ].call_ctl   = malloc (rounds * num * sizeof (uint64_t));
+    if (!c[OWFAULT_SEARCH].call_t || !c[OWFAULT_SEARCH].call_ctl ||
+        !c[OWFAULT_READ].call_t   || !c[OWFAULT_READ].call_ctl)  return -1;
+  }
+
+  // the serial numbers are taken from the fault free search, and each
+  // device is read once, so every run starts with the same (filled) power
+  // and configuration cache
+  n = 0;
+  for (ok = owFirst (0, TRUE, FALSE); ok && (n < num); ok = owNext (0, TRUE, FALSE))
+    owSerialNum (0, sn[n++], TRUE);
+  for (i=0; i<n; i++)  fault_read (family, sn[i], &temp);
+
+  owsim_inject (&sim, type, rate, 1);
+  for (r=0; r<rounds; r++) {
+    // search, repeated if a device was missed
+    fault_begin (&c[OWFAULT_SEARCH]);
+    for (t=0; t<OWFAULT_RETRY; t++) {
+      i = 0;
+      for (ok = owFirst (0, TRUE, FALSE); ok && (i <= num); ok = owNext (0, TRUE, FALSE))  i++;
+      if (i == num)  break;
+    }
+    fault_end (&c[OWFAULT_SEARCH], b ? &b[OWFAULT_SEARCH] : NULL, i == num);
+
+    // read each device, verify its presence after a failed read, a stale
+    // reading (the temperature of the previous round) is a failure
+    for (i=0; i<num; i++)  dev[i].temp = OWFAULT_TEMP(r);
+    for (i=0; i<n; i++) {
+      fault_begin (&c[OWFAULT_READ]);
+      ok = fault_read (family, sn[i], &temp) && (temp == OWFAULT_TEMP(r));
+      if (!ok)  owVerify (0, FALSE);
+      fault_end (&c[OWFAULT_READ], b ? &b[OWFAULT_READ] : NULL, ok);
+    }
+  }
+
+  owRelease (0);
+  owsim_free (&sim);
+  free (dev);
+  free (sn);
+  return (n == num) ? 0 : -1;
+}
+
+static void fault_report (const char *op, int type, const owfault_cnt *c, unsigned rate)
+{
+  double n  = c->calls ? c->calls : 1;
+  double no = (c->calls > c->failed) ? c->calls - c->failed : 1;
+  double nf = c->failed ? c->failed : 1;
+
+  printf ("%-8s  %6u  %-8s  %6d  %10.3f  %9.1f  %6llu  %6d  %12.3f  %9.1f  %12.3f  %9.1f  %10.3f\n",
+          owfault_name[type], rate ? rate : owfault_rate[type], op, c->calls, c->t / 1.0e6 / n, c->ctl / n,
+          (unsigned long long) c->flt, c->failed,
+          c->xt / 1.0e6 / no, c->xctl / no,
+          c->xflt ? c->xt / 1.0e6 / c->xflt : 0.0, c->xflt ? (double) c->xctl / c->xflt : 0.0,
+          c->ft / 1.0e6 / nf);
+}
+
+//--------------------------------------------------------------------------
+// arguments: number of devices (10), family code (0x28), rounds (10),
+//            fault rate for each cycle in 1/65536 units (class defaults)
+//
+int main (int argc, char **argv)
+{
+  int      num    = (argc > 1) ? atoi (argv[1]) : 10;
+  int      family = (argc > 2) ? strtol (argv[2], NULL, 0) : 0x28;
+  int      rounds = (argc > 3) ? atoi (argv[3]) : 10;
+  unsigned rate   = (argc > 4) ? strtoul (argv[4], NULL, 0) : 0;
+  owfault_cnt base[2], cnt[2];
+  int type;
+
+  printf ("%d devices, family 0x%02X, %d rounds\n\n", num, family, rounds);
+  printf ("%-8s  %-6s  %-8s  %6s  %10s  %9s  %6s  %6s  %12s  %9s  %12s  %9s  %10s\n",
+          "fault", "rate", "op", "calls", "bus_ms", "ctl", "faults", "failed",
+          "extra_ms", "extra_ctl", "ms/fault", "ctl/fault", "fail_ms");
+
+  for (type=0; type<OWSIM_FAULT_NUM; type++) {
+    if (fault_run (num, family, rounds, type, rate ? rate : owfault_rate[type], type ? cnt : base, type ? base : NULL)) {
+      fprintf (stderr, "ERROR: fault free search did not find %d devices\n", num);
+      return 1;
+    }
+    fault_report ("search", type, type ? &cnt[OWFAULT_SEARCH] : &base[OWFAULT_SEARCH], rate);
+    fault_report ("read",   type, type ? &cnt[OWFAULT_READ]   : &base[OWFAULT_READ],   rate);
+  }
+
+  for (type=0; type<2; type++) {
+    free (base[type].call_t);
+    free (base[type].call_ctl);
+  }
+  return 0;
+}
@@ -0,0 +1,158 @@
+//////////////////////////////////////////////////////////////////////////////
+//                                                                          //
+//  Minimalistic 1-wire (onewire) master with Avalon MM bus interface       //
+//                                                                          //
+//  Copyright (C) 2010  Iztok Jeras                                         //
+//                                                                          //
+//////////////////////////////////////////////////////////////////////////////
+//                                                                          //
+//  This program is free software: you can redistribute it and/or modify    //
+//  it under the terms of the GNU Lesser General Public License             //
+//  as published by the Free Software Foundation, either                    //
+//  version 3 of the License, or (at your option) any later version.        //
+//                                                                          //
+//  This program is distributed in the hope that it will be useful,         //
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of          //
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the           //
+//  GNU General Public License for more details.                            //
+//                                                                          //
+//  You should have received a copy of the GNU General Public License       //
+//  along with this program.  If not, see <http://www.gnu.org/licenses/>.   //
+//                                                                          //
+//////////////////////////////////////////////////////////////////////////////
+
+
+
+
+//////////////////////////////////////////////////////////////////////////////
+//                                                                          //
+// Link layer call overhead benchmark                                       //
+//                                                                          //
+// Measures the CPU time of the driver per 1-wire byte against a backend    //
+// with no timing (every cycle ends at the first CTL read), for the         //
+// application calling owTouchByte and for the transaction layer (owBlock). //
+// The script builds it with and without SOCKIT_OWM_INLINE, the difference  //
+// between the builds is the call overhead saved by the inline link layer.  //
+// On x86 hosts the time is also reported in TSC cycles.                    //
+//                                                                          //
+//////////////////////////////////////////////////////////////////////////////
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define OWINLINE_TSC 1
+#else
+#define OWINLINE_TSC 0
+#endif
+
+#include "system.h"
+#include "ownet.h"
+#include "sockit_owm_regs.h"
+
+#include "sockit_owm_host.h"
+
+#ifdef SOCKIT_OWM_INLINE
+#define OWINLINE_BUILD "inline"
+#else
+#define OWINLINE_BUILD "call"
+#endif
+
+//--------------------------------------------------------------------------
+// backend without bus timing, CYC and DAT always read as 0
+//
+static alt_u32 null_rd (void *ctx, int reg)
+{
+  return 0;
+}
+
+static void null_wr (void *ctx, int reg, alt_u32 dat)
+{
+}
+
+//--------------------------------------------------------------------------
+// measured loops, each transfers 'n' bytes
+//
+static volatile int sum;
+
+static void loop_byte (long n)
+{
+  long i;
+  for (i=0; i<n; i++)
+    sum += owTouchByte (0, i & 0xFF);
+}
+
+static void loop_bit (long n)
+{
+  long i;
+  int  b;
+  for (i=0; i<n; i++)
+    for (b=0; b<8; b++)
+      sum += owTouchBit (0, 1);
+}
+
+static void loop_block (long n)
+{
+  uchar buf[160];
+  long i;
+  memset (buf, 0xFF, sizeof (buf));
+  for (i=0; i<n; i+=sizeof (buf))
+    sum += owBlock (0, FALSE, buf, (n-i < sizeof (buf)) ? n-i : sizeof (buf));
+}
+
+//--------------------------------------------------------------------------
+// best of OWINLINE_REP runs (host timing is noisy)
+//
+#define OWINLINE_REP 5
+
+static void measure (const char *op, void (*loop) (long), long n)
+{
+  struct timespec beg, end;
+  double ns, ns_min = 0;
+  uint64_t tsc = 0, tsc_min = 0;
+  int r;
+
+  for (r=0; r<OWINLINE_REP; r++) {
+    clock_gettime (CLOCK_MONOTONIC, &beg);
+#if OWINLINE_TSC
+    tsc = __rdtsc ();
+#endif
+    loop (n);
+#if OWINLINE_TSC
+    tsc = __rdtsc () - tsc;
+#endif
+    clock_gettime (CLOCK_MONOTONIC, &end);
+    ns = (end.tv_sec - beg.tv_sec) * 1.0e9 + (end.tv_nsec - beg.tv_nsec);
+    if (!r || (ns  < ns_min ))  ns_min  = ns;
+    if (!r || (tsc < tsc_min))  tsc_min = tsc;
+  }
+
+  printf ("%-8s %-12s %10ld %12.2f", OWINLINE_BUILD, op, n, ns_min / n);
+  if (OWINLINE_TSC)  printf (" %12.2f\n", (double) tsc_min / n);
+  else               printf (" %12s\n", "-");
+}
+
+//--------------------------------------------------------------------------
+// arguments: number of bytes (default 1000000)
+//
+int main (int argc, char *argv[])
+{
+  sockit_owm_host host = {null_rd, null_wr, NULL};
+  long n = (argc > 1) ? atol (argv[1]) : 1000000;
+
+  sockit_owm_host_init (&host);
+  if (!owAcquire (0, NULL))  return 1;
+
+  if (!strcmp (OWINLINE_BUILD, "call"))
+    printf ("%-8s %-12s %10s %12s %12s\n", "build", "call", "bytes", "ns/byte", "cycles/byte");
+
+  measure ("owTouchByte", loop_byte,  n);
+  measure ("owTouchBit",  loop_bit,   n);
+  measure ("owBlock",     loop_block, n);
+
+  owRelease (0);
+  return 0;
+}
@@ -0,0 +1,426 @@
+//////////////////////////////////////////////////////////////////////////////
+//                                                                          //
+//  Minimalistic 1-wire (onewire) master with Avalon MM bus interface       //
+//                                                                          //
+//  Copyright (C) 2010  Iztok Jeras                                         //
+//                                                                          //
+//////////////////////////////////////////////////////////////////////////////
+//                                                                          //
+//  This program is free software: you can redistribute it and/or modify    //
+//  it under the terms of the GNU Lesser General Public License             //
+//  as published by the Free Software Foundation, either                    //
+//  version 3 of the License, or (at your option) any later version.        //
+//                                                                          //
+//  This program is distributed in the hope that it will be useful,         //
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of          //
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the           //
+//  GNU General Public License for more details.                            //
+//                                                                          //
+//  You should have received a copy of the GNU General Public License       //
+//  along with this program.  If not, see <http://www.gnu.org/licenses/>.   //
+//                                                                          //
+//////////////////////////////////////////////////////////////////////////////
+
+
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "sockit_owm_regs.h"
+#include "sockit_owm_host.h"
+#include "owsim.h"
+
+// lockstep modes
+#define OWSIM_EAGER   0  // every active device is visited
+#define OWSIM_CMD     1  // receiving the ROM command
+#define OWSIM_SEARCH  2  // Search ROM
+#define OWSIM_MATCH   3  // Match ROM
+
+// device sampling point after the slot start [ns]
+#define OWSIM_TS_N  30000
+#define OWSIM_TS_O   3000
+
+// cycle lengths of the RTL timing presets [ns]
+// (reset: T_RSTL+T_RSTH, bit: T_DAT0+T_RCVR, delay: T_IDLE)
+static const struct {
+  const char* btp;
+  uint64_t    rst, bit, dly;
+} owsim_tim_n [] = {
+  {"7.5", 960000, 67500,  960000},
+  {"5.0", 960000, 65000, 1000000},
+  {"6.0", 960000, 66000,  960000},
+}, owsim_tim_o [] = {
+  {"1.0",  96000,  8000,   96000},
+  {"0.5",  96000,  8000,   96000},
+};
+
+int owsim_init (owsim *sim, int own, const char *btp_n, const char *btp_o)
+{
+  int i;
+
+  if ((own < 1) || (own > OWSIM_OWN))  return -1;
+  memset (sim, 0, sizeof (owsim));
+  sim->own = own;
+  for (i=0; i<3; i++) {
+    if (!strcmp (btp_n, owsim_tim_n[i].btp)) {
+      sim->t_rst_n = owsim_tim_n[i].rst;
+      sim->t_bit_n = owsim_tim_n[i].bit;
+      sim->t_dly   = owsim_tim_n[i].dly;
+    }
+  }
+  for (i=0; i<2; i++) {
+    if (!strcmp (btp_o, owsim_tim_o[i].btp)) {
+      sim->t_rst_o = owsim_tim_o[i].rst;
+      sim->t_bit_o = owsim_tim_o[i].bit;
+    }
+  }
+  return (sim->t_rst_n && sim->t_rst_o) ? 0 : -1;
+}
+
+void owsim_free (owsim *sim)
+{
+  int i;
+
+  for (i=0; i<sim->own; i++) {
+    free (sim->line[i].dev);
+    free (sim->line[i].act);
+  }
+  memset (sim->line, 0, sizeof (sim->line));
+}
+
+int owsim_attach (owsim *sim, int port, owslave *s)
+{
+  owsim_line *l = &sim->line[port];
+
+  if (l->num == l->max) {
+    l->max = l->max ? 2*l->max : 64;
+    l->dev = realloc (l->dev, l->max * sizeof (owslave*));
+    l->act = realloc (l->act, l->max * sizeof (owslave*));
+    if (!l->dev || !l->act)  return -1;
+  }
+  l->dev[l->num++] = s;
+  l->sorted = 0;
+  return 0;
+}
+
+owslave* owsim_populate (owsim *sim, int port, int num, int family, int parasite, unsigned seed)
+{
+  owslave *s;
+  uint64_t serial;
+  int i;
+
+  s = calloc (num, sizeof (owslave));
+  if (!s)  return NULL;
+  for (i=0; i<num; i++) {
+    // 48bit linear congruential generator, every serial number is unique
+    seed   = seed * 1103515245u + 12345u;
+    serial = ((uint64_t) seed << 16) ^ i;
+    owslave_init (&s[i], family, serial & 0xffffffffffffull, parasite);
+    if (owsim_attach (sim, port, &s[i])) {
+      free (s);
+      return NULL;
+    }
+  }
+  return s;
+}
+
+void owsim_inject (owsim *sim, int type, unsigned rate, unsigned seed)
+{
+  memset (&sim->flt, 0, sizeof (owsim_fault));
+  sim->flt.type    = type;
+  sim->flt.rate    = rate;
+  sim->flt.seed    = seed;
+  sim->flt.t_short = 5000000;
+}
+
+// clear the virtual time and statistics
+void owsim_clear (owsim *sim)
+{
+  sim->t     = 0;
+  sim->n_rd  = 0;
+  sim->n_wr  = 0;
+  sim->n_ctl_rd = 0;
+  sim->n_ctl_wr = 0;
+  sim->n_rst = 0;
+  sim->n_bit = 0;
+  sim->n_dly = 0;
+  sim->n_irq = 0;
+}
+
+//--------------------------------------------------------------------------
+// cycles
+//
+
+static int owsim_rom_cmp (const void *a, const void *b)
+{
+  return owslave_rom_cmp (*(owslave * const *) a, *(owslave * const *) b);
+}
+
+// reset pulse, returns the line value at the presence sampling point
+static int owsim_reset (owsim *sim, owsim_line *l)
+{
+  int prs = 0, mixed = 0;
+  int i;
+
+  if (!l->sorted) {
+    qsort (l->dev, l->num, sizeof (owslave*), owsim_rom_cmp);
+    l->sorted = 1;
+  }
+  // an overdrive reset only affects devices at overdrive speed
+  l->n_act = 0;
+  for (i=0; i<l->num; i++) {
+    owslave *s = l->dev[i];
+    if (owslave_reset (s, sim->ovd, sim->t))  l->act[l->n_act++] = s, prs = 1;
+    else if (owslave_active (s))              mixed = 1;
+  }
+  if (mixed) {
+    // standard speed devices are still in a transaction
+    l->n_act = 0;
+    for (i=0; i<l->num; i++)
+      if (owslave_active (l->dev[i]))  l->act[l->n_act++] = l->dev[i];
+    l->mode = OWSIM_EAGER;
+  } else {
+    l->mode = OWSIM_CMD;
+    l->ovd  = sim->ovd;
+    l->cmd  = 0;
+    l->cnt  = 0;
+  }
+  sim->t += sim->ovd ? sim->t_rst_o : sim->t_rst_n;
+  sim->n_rst++;
+  return !prs;
+}
+
+// first device in the range with a '1' at ROM bit 'k' (the range shares bits below 'k')
+static int owsim_split (owsim_line *l, int k)
+{
+  int lo = l->lo, hi = l->hi, mid;
+
+  while (lo < hi) {
+    mid = (lo + hi) / 2;
+    if ((l->act[mid]->rom[k >> 3] >> (k & 7)) & 1)  hi = mid;
+    else                                            lo = mid + 1;
+  }
+  return lo;
+}
+
+// keep the devices matching the ROM bit
+static void owsim_narrow (owsim_line *l, int b)
+{
+  int mid = owsim_split (l, l->k);
+  int i;
+
+  if (b) {
+    for (i=l->lo; i<mid; i++)    owslave_deselect (l->act[i]);
+    l->lo = mid;
+  } else {
+    for (i=mid; i<l->hi; i++)    owslave_deselect (l->act[i]);
+    l->hi = mid;
+  }
+
+  // the remaining devices are selected
+  if (++l->k == 64) {
+    for (i=l->lo; i<l->hi; i++) {
+      owslave_select (l->act[i]);
+      l->act[i - l->lo] = l->act[i];
+    }
+    l->n_act = l->hi - l->lo;
+    l->mode  = OWSIM_EAGER;
+  }
+}
+
+// the ROM command was received by all devices
+static void owsim_rom_cmd (owsim *sim, owsim_line *l)
+{
+  int i, j, b;
+
+  l->lo    = 0;
+  l->hi    = l->n_act;
+  l->k     = 0;
+  l->phase = 0;
+  if      (l->cmd == 0xf0)  l->mode = OWSIM_SEARCH;
+  else if (l->cmd == 0x55)  l->mode = OWSIM_MATCH;
+  else {
+    // any other command is replayed to each device, the order of the
+    // active list is kept
+    for (i=0, j=0; i<l->n_act; i++) {
+      owslave *s = l->act[i];
+      for (b=0; b<8; b++)
+        owslave_sample (s, (l->cmd >> b) & 1, sim->t);
+      if (owslave_active (s))  l->act[j++] = s;
+    }
+    l->n_act = j;
+    l->hi    = j;
+    // the remaining devices of an alarm search or overdrive match are
+    // in the same state again (overdrive match continues at overdrive speed)
+    if      (l->cmd == 0xec)  l->mode = OWSIM_SEARCH;
+    else if (l->cmd == 0x69)  l->mode = OWSIM_MATCH, l->ovd = 1;
+    else                      l->mode = OWSIM_EAGER;
+  }
+}
+
+// data bit time slot, returns the wired-AND line value
+static int owsim_bit (owsim *sim, owsim_line *l, int dat)
+{
+  int      line = dat;
+  uint64_t t_smp = sim->t + (sim->ovd ? OWSIM_TS_O : OWSIM_TS_N);
+  int      i, j, mid;
+
+  sim->n_bit++;
+  if ((l->mode != OWSIM_EAGER) && (sim->ovd != l->ovd)) {
+    // devices in lockstep ignore slots at the other speed
+  } else if (l->mode == OWSIM_CMD) {
+    l->cmd |= dat << l->cnt;
+    if (++l->cnt == 8)  owsim_rom_cmd (sim, l);
+  } else if (l->mode == OWSIM_SEARCH) {
+    mid = owsim_split (l, l->k);
+    if      (l->phase == 0)  line = dat && (mid == l->lo);
+    else if (l->phase == 1)  line = dat && (mid == l->hi);
+    else                     owsim_narrow (l, dat);
+    l->phase = (l->phase == 2) ? 0 : l->phase + 1;
+  } else if (l->mode == OWSIM_MATCH) {
+    owsim_narrow (l, dat);
+  } else {
+    // devices at the slot speed drive the line, then all of them sample it,
+    // deselected devices are dropped from the active list
+    for (i=0; i<l->n_act; i++) {
+      owslave *s = l->act[i];
+      if ((s->ovd == sim->ovd) && !owslave_drive (s, sim->t))  line = 0;
+    }
+    for (i=0, j=0; i<l->n_act; i++) {
+      owslave *s = l->act[i];
+      if (s->ovd == sim->ovd)  owslave_sample (s, line, t_smp);
+      if (owslave_active (s))  l->act[j++] = s;
+    }
+    l->n_act = j;
+  }
+  sim->t += sim->ovd ? sim->t_bit_o : sim->t_bit_n;
+  return line;
+}
+
+//--------------------------------------------------------------------------
+// fault injection
+//
+
+// returns 1 if a fault of the given class is injected in this cycle
+static int owsim_roll (owsim *sim, int type)
+{
+  owsim_fault *f = &sim->flt;
+
+  if ((f->type != type) || !f->rate)  return 0;
+  f->seed = f->seed * 1103515245u + 12345u;
+  if (((f->seed >> 16) & 0xffff) >= f->rate)  return 0;
+  f->n++;
+  return 1;
+}
+
+// a shorted line reads '0', devices lose track of the transaction
+static int owsim_short (owsim *sim, owsim_line *l)
+{
+  int i;
+
+  if (sim->t < sim->flt.t_end)  return 1;
+  if (!owsim_roll (sim, OWSIM_FAULT_SHORT))  return 0;
+  sim->flt.t_end = sim->t + sim->flt.t_short;
+  for (i=0; i<l->num; i++)
+    owslave_deselect (l->dev[i]);
+  l->n_act = 0;
+  l->mode  = OWSIM_EAGER;
+  return 1;
+}
+
+static void owsim_power (owsim *sim, owsim_line *l, int pwr)
+{
+  int i;
+
+  if (pwr == l->pwr)  return;
+  for (i=0; i<l->num; i++)
+    owslave_power (l->dev[i], pwr, sim->t);
+  l->pwr = pwr;
+}
+
+//--------------------------------------------------------------------------
+// register backend
+//
+
+alt_u32 owsim_rd (void *ctx, int reg)
+{
+  owsim *sim = ctx;
+  alt_u32 dat = 0;
+  int i;
+
+  sim->n_rd++;
+  if (reg == SOCKIT_OWM_CTL_REG) {
+    sim->n_ctl_rd++;
+    for (i=0; i<sim->own; i++)
+      dat |= sim->line[i].pwr << (SOCKIT_OWM_CTL_POWER_OFST + i);
+    dat |= (sim->sel      << SOCKIT_OWM_CTL_SEL_OFST)
+        |  (sim->ien       ? SOCKIT_OWM_CTL_IEN_MSK : 0)
+        |  (sim->irq_sts   ? SOCKIT_OWM_CTL_IRQ_MSK : 0)
+        |  (sim->line[0].pwr ? SOCKIT_OWM_CTL_PWR_MSK : 0)
+        |  (sim->ovd       ? SOCKIT_OWM_CTL_OVD_MSK : 0)
+        |  (sim->rst       ? SOCKIT_OWM_CTL_RST_MSK : 0)
+        |  (sim->dat       ? SOCKIT_OWM_CTL_DAT_MSK : 0);
+    // reading the status clears the interrupt
+    sim->irq_sts = 0;
+  }
+  return dat;
+}
+
+void owsim_wr (void *ctx, int reg, alt_u32 dat)
+{
+  owsim *sim = ctx;
+  owsim_line *l;
+  int i;
+
+  sim->n_wr++;
+  if (reg != SOCKIT_OWM_CTL_REG)  return;
+  sim->n_ctl_wr++;
+
+  sim->ctl     = dat;
+  sim->irq_sts = 0;
+  sim->ien     = (dat & SOCKIT_OWM_CTL_IEN_MSK) != 0;
+
+  // power (and line select if there are more lines)
+  if (sim->own > 1) {
+    sim->sel = (dat & SOCKIT_OWM_CTL_SEL_MSK) >> SOCKIT_OWM_CTL_SEL_OFST;
+    if (sim->sel >= sim->own)  sim->sel = 0;
+    for (i=0; i<sim->own; i++)
+      owsim_power (sim, &sim->line[i], (dat >> (SOCKIT_OWM_CTL_POWER_OFST + i)) & 1);
+  } else {
+    owsim_power (sim, &sim->line[0], (dat & SOCKIT_OWM_CTL_PWR_MSK) != 0);
+  }
+
+  if (!(dat & SOCKIT_OWM_CTL_CYC_MSK))  return;
+
+  // cycle
+  l = &sim->line[sim->sel];
+  sim->ovd = (dat & SOCKIT_OWM_CTL_OVD_MSK) != 0;
+  sim->rst = (dat & SOCKIT_OWM_CTL_RST_MSK) != 0;
+  sim->dat = (dat & SOCKIT_OWM_CTL_DAT_MSK) != 0;
+  if (sim->rst & sim->dat) {
+    // idle cycle cancels, delay cycle waits
+    if (sim->ovd)  return;
+    sim->t += sim->t_dly;
+    sim->n_dly++;
+  } else if (owsim_short (sim, l)) {
+    // the cycle does not reach the devices
+    if (sim->rst)  sim->t += sim->ovd ? sim->t_rst_o : sim->t_rst_n, sim->n_rst++;
+    else           sim->t += sim->ovd ? sim->t_bit_o : sim->t_bit_n, sim->n_bit++;
+    sim->dat = 0;
+  } else if (sim->rst) {
+    sim->dat = owsim_reset (sim, l);
+    if (!sim->dat && owsim_roll (sim, OWSIM_FAULT_PRESENCE))  sim->dat = 1;
+  } else {
+    int wr = sim->dat;
+    sim->dat = owsim_bit (sim, l, sim->dat);
+    if (owsim_roll (sim, OWSIM_FAULT_NOISE))  sim->dat ^= 1;
+    if (wr && !sim->dat && owsim_roll (sim, OWSIM_FAULT_SLOW))  sim->dat = 1;
+  }
+
+  // cycle end interrupt
+  sim->irq_sts = 1;
+  if (sim->ien) {
+    sim->n_irq++;
+    sockit_owm_host_irq ();
+  }
+}
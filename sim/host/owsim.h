@@ -0,0 +1,129 @@
+//////////////////////////////////////////////////////////////////////////////
+//                                                                          //
+//  Minimalistic 1-wire (onewire) master with Avalon MM bus interface       //
+//                                                                          //
+//  Copyright (C) 2010  Iztok Jeras                                         //
+//                                                                          //
+//////////////////////////////////////////////////////////////////////////////
+//                                                                          //
+//  This program is free software: you can redistribute it and/or modify    //
+//  it under the terms of the GNU Lesser General Public License             //
+//  as published by the Free Software Foundation, either                    //
+//  version 3 of the License, or (at your option) any later version.        //
+//                                                                          //
+//  This program is distributed in the hope that it will be useful,         //
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of          //
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the           //
+//  GNU General Public License for more details.                            //
+//                                                                          //
+//  You should have received a copy of the GNU General Public License       //
+//  along with this program.  If not, see <http://www.gnu.org/licenses/>.   //
+//                                                                          //
+//////////////////////////////////////////////////////////////////////////////
+
+
+
+//////////////////////////////////////////////////////////////////////////////
+//                                                                          //
+// Virtual time 1-wire bus simulator (sockit_owm register backend)          //
+//                                                                          //
+// Replaces the RTL at the register level: a CTL write requesting a cycle   //
+// completes immediately, the wired-AND result is computed from the device  //
+// models and the virtual time advances by the cycle length of the timing   //
+// preset. Only devices taking part in the current transaction are visited  //
+// for each time slot, so large networks are cheap to search.               //
+//                                                                          //
+//////////////////////////////////////////////////////////////////////////////
+
+#ifndef __OWSIM_H__
+#define __OWSIM_H__
+
+#include "alt_types.h"
+#include "owslave.h"
+
+#define OWSIM_OWN  16  // maximum number of 1-wire lines
+
+// fault classes
+#define OWSIM_FAULT_NONE      0
+#define OWSIM_FAULT_NOISE     1  // the master samples an inverted data bit
+#define OWSIM_FAULT_PRESENCE  2  // the presence pulse is missing
+#define OWSIM_FAULT_SHORT     3  // the line is stuck low for a while
+#define OWSIM_FAULT_SLOW      4  // a device pulls low too late, '0' is read as '1'
+#define OWSIM_FAULT_NUM       5
+
+// fault injection (applies to all lines)
+typedef struct owsim_fault_s
+{
+  int              type;            // fault class
+  unsigned         rate;            // probability for each cycle [1/65536]
+  unsigned         seed;            // random generator state
+  uint64_t         t_short;         // short duration [ns]
+  uint64_t         t_end;           // end of the current short
+  uint64_t         n;               // injected faults
+} owsim_fault;
+
+// a single 1-wire line
+typedef struct owsim_line_s
+{
+  owslave**        dev;             // connected devices
+  int              num;
+  owslave**        act;             // devices taking part in the current transaction
+  int              n_act;
+  int              max;             // allocated list size
+  int              pwr;             // strong pull-up
+  // after a reset all devices receive the ROM command in lockstep,
+  // Search ROM and Match ROM then narrow a range of the active
+  // list (sorted in search order) instead of visiting each device
+  int              sorted;          // device list is sorted in search order
+  int              mode;            // lockstep mode
+  int              ovd;             // lockstep speed
+  int              cmd;             // ROM command
+  int              cnt;             // ROM command bit counter
+  int              lo, hi;          // range of devices matching the ROM bits so far
+  int              k;               // ROM bit
+  int              phase;           // search phase (bit, complement, direction)
+} owsim_line;
+
+typedef struct owsim_s
+{
+  int              own;             // number of 1-wire lines
+  owsim_line       line[OWSIM_OWN];
+  // cycle lengths [ns]
+  uint64_t         t_rst_n, t_bit_n, t_dly;
+  uint64_t         t_rst_o, t_bit_o;
+  // registers
+  alt_u32          ctl;             // last CTL write
+  int              sel;             // selected line
+  int              dat;             // cycle result
+  int              ovd;             // overdrive
+  int              rst;             // reset
+  int              irq_sts;         // interrupt status
+  int              ien;             // interrupt enable
+  // virtual time [ns]
+  uint64_t         t;
+  // fault injection
+  owsim_fault      flt;
+  // statistics
+  uint64_t         n_rd, n_wr;      // register accesses
+  uint64_t         n_ctl_rd;        // CTL register accesses
+  uint64_t         n_ctl_wr;
+  uint64_t         n_rst, n_bit;    // reset and data cycles
+  uint64_t         n_dly;           // delay cycles
+  uint64_t         n_irq;           // interrupts
+} owsim;
+
+// btp_n/btp_o are the RTL timing presets ("5.0", "7.5", "6.0" and "1.0", "0.5")
+extern int      owsim_init     (owsim *sim, int own, const char *btp_n, const char *btp_o);
+extern void     owsim_free     (owsim *sim);
+extern int      owsim_attach   (owsim *sim, int port, owslave *s);
+// create 'num' devices with deterministic pseudo random serial numbers
+extern owslave* owsim_populate (owsim *sim, int port, int num, int family, int parasite, unsigned seed);
+extern void     owsim_clear    (owsim *sim);
+// inject faults of the given class with a probability of rate/65536 per cycle
+extern void     owsim_inject   (owsim *sim, int type, unsigned rate, unsigned seed);
+
+// register backend (see sockit_owm_host.h)
+extern alt_u32  owsim_rd       (void *ctx, int reg);
+extern void     owsim_wr       (void *ctx, int reg, alt_u32 dat);
+
+#endif // __OWSIM_H__
@@ -0,0 +1,540 @@
+//////////////////////////////////////////////////////////////////////////////
+//                                                                          //
+//  Minimalistic 1-wire (onewire) master with Avalon MM bus interface       //
+//                                                                          //
+//  Copyright (C) 2010  Iztok Jeras                                         //
+//                                                                          //
+//////////////////////////////////////////////////////////////////////////////
+//                                                                          //
+//  This program is free software: you can redistribute it and/or modify    //
+//  it under the terms of the GNU Lesser General Public License             //
+//  as published by the Free Software Foundation, either                    //
+//  version 3 of the License, or (at your option) any later version.        //
+//                                                                          //
+//  This program is distributed in the hope that it will be useful,         //
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of          //
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the           //
+//  GNU General Public License for more details.                            //
+//                                                                          //
+//  You should have received a copy of the GNU General Public License       //
+//  along with this program.  If not, see <http://www.gnu.org/licenses/>.   //
+//                                                                          //
+//////////////////////////////////////////////////////////////////////////////
+
+
+
+//////////////////////////////////////////////////////////////////////////////
+//                                                                          //
+// HAL driver running against the virtual time bus simulator                //
+//                                                                          //
+// Builds a network of identical devices, then reports the 1-wire bus time  //
+// and the wall time consumed by each API call.                             //
+//                                                                          //
+//////////////////////////////////////////////////////////////////////////////
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "system.h"
+#include "ownet.h"
+#include "findtype.h"
+#include "temp10.h"
+#include "temp28.h"
+#include "temp42.h"
+#include "owenum.h"
+#include "owdev.h"
+#include "owtemp.h"
+
+#include "sys/alt_errno.h"
+#include "sockit_owm.h"
+#include "sockit_owm_async.h"
+#include "sockit_owm_host.h"
+#include "owsim.h"
+
+static owsim sim;
+
+static uint64_t t_bus;
+static clock_t  t_cpu;
+
+static void start (void)
+{
+  t_bus = sim.t;
+  t_cpu = clock ();
+}
+
+static void report (const char *call, int cnt)
+{
+  double bus = (sim.t - t_bus) / 1.0e6;
+  double cpu = (clock () - t_cpu) * 1.0e3 / CLOCKS_PER_SEC;
+  printf ("%-18s %6d %12.3f %12.3f %10.3f\n", call, cnt, bus, cnt ? bus * 1.0e3 / cnt : 0.0, cpu);
+}
+
+// asynchronous scratchpad read completion, counts reads with a valid CRC
+static int async_ok;
+
+static void async_done (sockit_owm_txn *txn)
+{
+  int i;
+
+  if (txn->sts)  return;
+  setcrc8 (txn->portnum, 0);
+  for (i=0; i<txn->rd_n; i++)  docrc8 (txn->portnum, txn->rd[i]);
+  if (docrc8 (txn->portnum, 0) == 0)  async_ok++;
+}
+
+// snapshot storage in a file
+static int store_file (void *ctx, SMALLINT do_write, uchar *buf, int len)
+{
+  return do_write ? fwrite (buf, 1, len, ctx) : fread (buf, 1, len, ctx);
+}
+
+static int read_temp (int portnum, uchar *sn, float *temp)
+{
+  switch (sn[0]) {
+    case OWSLAVE_DS18S20:   return ReadTemperature10 (portnum, sn, temp);
+    case OWSLAVE_DS18B20:   return ReadTemperature28 (portnum, sn, temp);
+    case OWSLAVE_DS28EA00:  return ReadTemperature42 (portnum, sn, temp);
+  }
+  return FALSE;
+}
+
+static int read_temp_int (int portnum, uchar *sn, int *temp)
+{
+  switch (sn[0]) {
+    case OWSLAVE_DS18S20:   return ReadTemperature10Int (portnum, sn, temp);
+    case OWSLAVE_DS18B20:   return ReadTemperature28Int (portnum, sn, temp);
+    case OWSLAVE_DS28EA00:  return ReadTemperature42Int (portnum, sn, temp);
+  }
+  return FALSE;
+}
+
+int main (int argc, char **argv)
+{
+  int num      = (argc > 1) ? atoi (argv[1]) : 1000;
+  int family   = (argc > 2) ? strtol (argv[2], NULL, 0) : OWSLAVE_DS18B20;
+  int parasite = (argc > 3) ? atoi (argv[3]) : 0;
+  sockit_owm_host host = {owsim_rd, owsim_wr, &sim};
+  sockit_owm_wst wst;
+  static const uchar convert = 0x44, read = 0xbe;
+  owSearchContext ctx[2];
+  owEnum en, rst;
+  FamilyBucket bucket[2];
+  owslave *mix[2], *par;
+  uchar (*sn_mix)[8], rom[8];
+  int fam[2];
+  FILE *f;
+  owEnumDelta delta[4];
+  owDevRegistry reg;
+  owDev *rec, *pool;
+  int *hash;
+  uchar (*tbl)[8], (*tbl_rst)[8];
+  int added, removed;
+  int found[2], act;
+  sockit_owm_txn *txn;
+  TempReading *rd, one;
+  int th, tl, bits;
+  uchar (*sn)[8];
+  uchar (*sp)[9];
+  owslave *dev;
+  float temp;
+  int i, j, n, err = 0;
+
+  if (owsim_init (&sim, SOCKIT_OWM_OWN, SOCKIT_OWM_BTP_N, SOCKIT_OWM_BTP_O)) {
+    printf ("ERROR: unsupported timing preset\n");
+    return 1;
+  }
+  dev = owsim_populate (&sim, 0, num, family, parasite, 1);
+  sn  = malloc ((num+1) * sizeof (*sn));
+  if (!dev || !sn) {
+    printf ("ERROR: out of memory\n");
+    return 1;
+  }
+  for (i=0; i<num; i++)
+    dev[i].temp = (i % 1600) - 400;
+  sockit_owm_host_init (&host);
+
+  printf ("%d devices (family 0x%02X, %s power)\n", num, family, parasite ? "parasite" : "external");
+  printf ("%-18s %6s %12s %12s %10s\n", "call", "count", "bus [ms]", "bus/call [us]", "wall [ms]");
+
+  if (!owAcquire (0, NULL)) {
+    printf ("ERROR: acquire failed\n");
+    return 1;
+  }
+
+  // search the whole network
+  start ();
+  n = owFirst (0, TRUE, FALSE) ? 1 : 0;
+  report ("owFirst", 1);
+  start ();
+  for (i=1; owNext (0, TRUE, FALSE); i++)  n++;
+  report ("owNext", i);
+  if (n != num) {
+    printf ("ERROR: owFirst/owNext found %d devices\n", n);
+    err++;
+  }
+
+  // two searches on the same port, interleaved a step at a time
+  start ();
+  for (i=0; i<2; i++) {
+    owSearchInit (&ctx[i], 0, TRUE, FALSE);
+    found[i] = 0;
+  }
+  for (act=3, i=0; act; i^=1) {
+    if (!(act & (1<<i)))  continue;
+    switch (owSearchStep (&ctx[i])) {
+      case OWSEARCH_FOUND:  found[i]++;  break;
+      case OWSEARCH_END:    act &= ~(1<<i);  break;
+    }
+  }
+  report ("owSearchStep", found[0] + found[1]);
+  if ((found[0] != num) || (found[1] != num)) {
+    printf ("ERROR: interleaved searches found %d and %d devices\n", found[0], found[1]);
+    err++;
+  }
+
+  // a pass running on the port makes other searches of the task busy, and
+  // only the owner of the pass can abort it
+  for (i=0; i<2; i++)
+    owSearchInit (&ctx[i], 0, TRUE, FALSE);
+  owSearchStep (&ctx[0]);
+  if ((owSearchStep (&ctx[1]) != OWSEARCH_BUSY) || owNext (0, TRUE, FALSE)) {
+    printf ("ERROR: search did not report a busy port\n");
+    err++;
+  }
+  owSearchAbort (&ctx[1]);
+  if (owSearchStep (&ctx[1]) != OWSEARCH_BUSY) {
+    printf ("ERROR: search pass aborted by another context\n");
+    err++;
+  }
+  owSearchAbort (&ctx[0]);
+
+  // incremental enumeration: fill the table, check it without changes,
+  // then remove and reconnect a device
+  tbl     = malloc (num * sizeof (*tbl));
+  tbl_rst = malloc (num * sizeof (*tbl_rst));
+  if (!tbl || !tbl_rst) {
+    printf ("ERROR: out of memory\n");
+    return 1;
+  }
+  owEnumInit (&en, 0, tbl, num);
+  n = owEnumUpdate (&en, NULL, 0);
+  if ((n != num) || (en.num != num)) {
+    printf ("ERROR: owEnumUpdate found %d devices\n", n);
+    err++;
+  }
+  start ();
+  n = owEnumUpdate (&en, delta, 4);
+  n += owEnumUpdate (&en, delta, 4);
+  report ("owEnumUpdate", 2);
+  j = num / 2;
+  dev[j].present = 0;
+  n += owEnumUpdate (&en, delta, 4);
+  removed = (n == 1) && !delta[0].added && !memcmp (delta[0].rom, dev[j].rom, 8);
+  dev[j].present = 1;
+  n  = owEnumUpdate (&en, delta, 4);
+  if (!n)  n = owEnumUpdate (&en, delta, 4);
+  added = (n == 1) && delta[0].added && !memcmp (delta[0].rom, dev[j].rom, 8);
+  if (!removed || !added || (en.num != num)) {
+    printf ("ERROR: owEnumUpdate missed a change (removed %d, added %d)\n", removed, added);
+    err++;
+  }
+
+  // a pass running on the port makes the update busy, the table and the
+  // pass are left unchanged (the pass needs another device to keep going)
+  if (num > 1) {
+    dev[j].present = 0;
+    owSearchInit (&ctx[0], 0, TRUE, FALSE);
+    owSearchStep (&ctx[0]);
+    n = owEnumUpdate (&en, delta, 4);
+    for (found[0]=0; (act = owSearchStep (&ctx[0])) != OWSEARCH_END; )
+      if (act == OWSEARCH_FOUND)  found[0]++;
+    dev[j].present = 1;
+    if ((n != OWENUM_BUSY) || (en.num != num) || (found[0] != num-1)) {
+      printf ("ERROR: owEnumUpdate broke a running search (%d changes, %d found)\n", n, found[0]);
+      err++;
+    }
+  }
+
+  // save the table and restore it for a startup without a search, the
+  // first update verifies it
+  f = tmpfile ();
+  owEnumInit (&rst, 0, tbl_rst, num);
+  if (!f || !owEnumSave (&en, 1, store_file, f)) {
+    printf ("ERROR: owEnumSave failed\n");
+    err++;
+  } else {
+    rewind (f);
+    start ();
+    if (!owEnumRestore (&rst, 1, store_file, f) || (rst.num != num) || memcmp (tbl, tbl_rst, num * 8)) {
+      printf ("ERROR: owEnumRestore failed\n");
+      err++;
+    }
+    report ("owEnumRestore", 1);
+    start ();
+    n = owEnumUpdate (&rst, delta, 4);
+    report ("owEnumUpdate", 1);
+    if (n) {
+      printf ("ERROR: restored table has %d changes\n", n);
+      err++;
+    }
+  }
+  if (f)  fclose (f);
+  free (tbl);
+  free (tbl_rst);
+
+  // search for a family, the attached registry collects the devices
+  pool = malloc (num * sizeof (*pool));
+  for (j=2; j <= num; j<<=1);
+  hash = malloc (2 * j * sizeof (*hash));
+  if (!pool || !hash || !owDevInit (&reg, pool, num, hash, 2 * j)) {
+    printf ("ERROR: out of memory\n");
+    return 1;
+  }
+  owDevAttach (&reg);
+  start ();
+  n = FindDevices (0, sn, family, num+1);
+  report ("FindDevices", 1);
+  if (n != num) {
+    printf ("ERROR: FindDevices found %d devices\n", n);
+    err++;
+  }
+  owSerialNum (0, rom, TRUE);
+  if (n && memcmp (rom, sn[n-1], 8)) {
+    printf ("ERROR: FindDevices did not leave the last device selected\n");
+    err++;
+  }
+
+  // discovery time power probe, the readers do not query the devices of
+  // an externally powered port
+  start ();
+  if (TempProbePower (0) != (parasite ? OWDEV_POWER_PARASITE : OWDEV_POWER_EXTERNAL)) {
+    printf ("ERROR: TempProbePower failed\n");
+    err++;
+  }
+  report ("TempProbePower", 1);
+
+  // registry: look up every device, select one through its record, then
+  // check the health tracking on an empty bus (a match ROM can not tell a
+  // missing device while others answer the reset) and a removal
+  start ();
+  for (i=0; i<n; i++)
+    if (!(rec = owDevFind (&reg, sn[i])) || !rec->present || (rec->family != family))  break;
+  report ("owDevFind", n);
+  if ((reg.num != num) || (i != n)) {
+    printf ("ERROR: registry has %d devices, lookup %d failed\n", reg.num, i);
+    err++;
+  }
+  rec = owDevFind (&reg, dev[0].rom);
+  start ();
+  if (!rec || !owDevAccess (rec) || (rec->accesses != 1)) {
+    printf ("ERROR: owDevAccess failed\n");
+    err++;
+  }
+  report ("owDevAccess", 1);
+  for (i=0; i<num; i++)  dev[i].present = 0;
+  if (!rec || owDevAccess (rec) || rec->present || (rec->errors != 1)) {
+    printf ("ERROR: owDevAccess missed a disconnected device\n");
+    err++;
+  }
+  for (i=0; i<num; i++)  dev[i].present = 1;
+  if ((TempPowerMode (0, sn[0]) != (parasite ? OWDEV_POWER_PARASITE : OWDEV_POWER_EXTERNAL)) ||
+      !(rec = owDevFind (&reg, sn[0])) || (rec->power != TempPowerMode (0, sn[0]))) {
+    printf ("ERROR: power mode not kept in the registry\n");
+    err++;
+  }
+  if (!owDevRemove (&reg, dev[0].rom) || owDevFind (&reg, dev[0].rom) || (reg.num != num-1)) {
+    printf ("ERROR: owDevRemove failed\n");
+    err++;
+  }
+  for (i=0; i<n; i++)
+    if (memcmp (sn[i], dev[0].rom, 8) && !owDevFind (&reg, sn[i]))  break;
+  if (i != n) {
+    printf ("ERROR: owDevRemove lost device %d\n", i);
+    err++;
+  }
+  owDevAttach (NULL);
+  free (pool);
+  free (hash);
+
+  // read the first device found
+  start ();
+  if (n && read_temp (0, sn[0], &temp)) {
+    report ("ReadTemperature", 1);
+    for (i=0; i<num; i++)
+      if (!memcmp (dev[i].rom, sn[0], 8))  break;
+    if ((i == num) || (temp != dev[i].temp / 16.0)) {
+      printf ("ERROR: temperature %.4f does not match the device\n", temp);
+      err++;
+    }
+  } else {
+    printf ("ERROR: temperature read failed\n");
+    err++;
+  }
+
+  // integer read of the first device populated, below 0 C
+  start ();
+  if (!read_temp_int (0, dev[0].rom, &th) || (th != dev[0].temp)) {
+    printf ("ERROR: integer temperature %d does not match the device (%d)\n", th, dev[0].temp);
+    err++;
+  }
+  report ("ReadTemperatureInt", 1);
+
+  // asynchronous conversion on all devices, followed by a queued
+  // scratchpad read of each device found
+  txn = calloc (n+1, sizeof (*txn));
+  sp  = calloc (n+1, sizeof (*sp));
+  if (!txn || !sp) {
+    printf ("ERROR: out of memory\n");
+    return 1;
+  }
+  start ();
+  txn[0].cmd   = &convert;
+  txn[0].cmd_n = 1;
+  txn[0].dly   = 750;
+  txn[0].pwr   = parasite;
+  for (i=1; i<=n; i++) {
+    txn[i].rom   = sn[i-1];
+    txn[i].cmd   = &read;
+    txn[i].cmd_n = 1;
+    txn[i].rd    = sp[i-1];
+    txn[i].rd_n  = 9;
+    txn[i].cb    = async_done;
+  }
+  for (i=0; i<=n; i++)
+    if (sockit_owm_async_submit (&txn[i]))  break;
+  for (i=0; i<=n; i++)
+    if (sockit_owm_async_wait (&txn[i]))  break;
+  report ("async read", n);
+  if ((i <= n) || (async_ok != n)) {
+    printf ("ERROR: asynchronous read of %d devices, %d valid\n", n, async_ok);
+    err++;
+  }
+  // a transaction submitted by the port lock owner is rejected, a blocking
+  // call waits for the queued transaction to complete
+  owLock (0);
+  if (sockit_owm_async_submit (&txn[1]) != -EDEADLK) {
+    printf ("ERROR: transaction submitted while holding the port lock\n");
+    err++;
+  }
+  owUnlock (0);
+  if (sockit_owm_async_submit (&txn[1]) || !owTouchReset (0) || (txn[1].sts != 0)) {
+    printf ("ERROR: blocking call did not wait for the queue (%d)\n", txn[1].sts);
+    err++;
+  }
+  free (txn);
+  free (sp);
+
+  // batch read, one conversion for all devices
+  rd = calloc (n+1, sizeof (*rd));
+  if (!rd) {
+    printf ("ERROR: out of memory\n");
+    return 1;
+  }
+  for (i=0; i<n; i++) {
+    rd[i].portnum   = 0;
+    rd[i].SerialNum = sn[i];
+  }
+  start ();
+  j = ReadTemperatures (rd, n);
+  report ("ReadTemperatures", n);
+  for (i=0; i<n; i++) {
+    for (act=0; act<num; act++)
+      if (!memcmp (dev[act].rom, sn[i], 8))  break;
+    if (!rd[i].ok || (act == num) || (rd[i].Temp != dev[act].temp))  break;
+  }
+  if ((j != n) || (i != n)) {
+    printf ("ERROR: ReadTemperatures read %d of %d devices, first mismatch %d\n", j, n, i);
+    err++;
+  }
+  free (rd);
+
+  // configuration: write and read back, keep it in EEPROM, overwrite and
+  // recall it, then read the first device at 9 bit resolution
+  for (act=0; act<num; act++)
+    if (n && !memcmp (dev[act].rom, sn[0], 8))  break;
+  if ((act == num) ||
+      !TempWriteConfig (0, sn[0], 50, -10, 9)  || !TempReadConfig (0, sn[0], &th, &tl, &bits) ||
+      (th != 50) || (tl != -10) || (bits != 9) || !TempCopyConfig (0, sn[0]) ||
+      !TempWriteConfig (0, sn[0], 0, 0, 12)    || !TempRecallConfig (0, sn[0]) ||
+      !TempReadConfig (0, sn[0], &th, &tl, &bits) || (th != 50) || (tl != -10) || (bits != 9)) {
+    printf ("ERROR: configuration write/copy/recall failed\n");
+    err++;
+  } else if (family != OWSLAVE_DS18S20) {
+    start ();
+    if (!read_temp_int (0, sn[0], &th) || (th != (dev[act].temp & ~7))) {
+      printf ("ERROR: 9 bit temperature read failed\n");
+      err++;
+    }
+    report ("ReadTemperature 9b", 1);
+    TempWriteConfig (0, sn[0], 0, 0, 12);
+    TempCopyConfig (0, sn[0]);
+  }
+
+  // mixed network: add a few devices of the two other families, search
+  // for the original family and one other in a single search
+  fam[0] = (family == OWSLAVE_DS18S20) ? OWSLAVE_DS18B20 : OWSLAVE_DS18S20;
+  fam[1] = (family == OWSLAVE_DS28EA00) ? OWSLAVE_DS18B20 : OWSLAVE_DS28EA00;
+  mix[0] = owsim_populate (&sim, 0, num/10+1, fam[0], parasite, 2);
+  mix[1] = owsim_populate (&sim, 0, num/10+1, fam[1], parasite, 3);
+  sn_mix = malloc ((num/10+1) * sizeof (*sn_mix));
+  if (!mix[0] || !mix[1] || !sn_mix) {
+    printf ("ERROR: out of memory\n");
+    return 1;
+  }
+  bucket[0].family   = family;
+  bucket[0].FamilySN = sn;
+  bucket[0].max      = num;
+  bucket[1].family   = fam[0];
+  bucket[1].FamilySN = sn_mix;
+  bucket[1].max      = num/10;
+  start ();
+  n = FindFamilies (0, bucket, 2);
+  report ("FindFamilies", 1);
+  if ((n != num + num/10) || (bucket[0].num != num) || (bucket[1].num != num/10) || (bucket[1].overflow != 1)) {
+    printf ("ERROR: FindFamilies found %d devices (%d, %d + %d)\n", n, bucket[0].num, bucket[1].num, bucket[1].overflow);
+    err++;
+  }
+  start ();
+  n  = FindDevices (0, sn, family, num+1);
+  n += FindDevices (0, sn_mix, fam[0], num/10+2);
+  report ("FindDevices x2", 2);
+  free (sn_mix);
+
+  // a parasite powered device connected to an externally powered port
+  // drops the port probe result once a search finds it
+  par = NULL;
+  if (!parasite) {
+    TempProbePower (0);
+    par = owsim_populate (&sim, 0, 1, family, 1, 4);
+    if (!par) {
+      printf ("ERROR: out of memory\n");
+      return 1;
+    }
+    FindDevices (0, sn, family, num+1);
+    one.portnum   = 0;
+    one.SerialNum = par[0].rom;
+    if ((TempPowerMode (0, par[0].rom) != OWDEV_POWER_PARASITE) ||
+        (ReadTemperatures (&one, 1) != 1) || (one.Temp != par[0].temp)) {
+      printf ("ERROR: added parasite powered device read as externally powered\n");
+      err++;
+    }
+  }
+
+  sockit_owm_wait_stats (0, &wst, 0);
+  owRelease (0);
+  printf ("cycles: %llu reset, %llu bit, %llu delay; registers: %llu reads, %llu writes\n",
+          (unsigned long long) sim.n_rst, (unsigned long long) sim.n_bit, (unsigned long long) sim.n_dly,
+          (unsigned long long) sim.n_rd,  (unsigned long long) sim.n_wr);
+  printf ("waits: %lu spin (%lu reads, max %lu), %lu block\n",
+          (unsigned long) wst.spin, (unsigned long) wst.reads, (unsigned long) wst.max, (unsigned long) wst.block);
+
+  owsim_free (&sim);
+  free (mix[0]);
+  free (mix[1]);
+  free (par);
+  free (dev);
+  free (sn);
+  return err ? 1 : 0;
+}
@@ -0,0 +1,389 @@
+//////////////////////////////////////////////////////////////////////////////
+//                                                                          //
+//  Minimalistic 1-wire (onewire) master with Avalon MM bus interface       //
+//                                                                          //
+//  Copyright (C) 2010  Iztok Jeras                                         //
+//                                                                          //
+//////////////////////////////////////////////////////////////////////////////
+//                                                                          //
+//  This program is free software: you can redistribute it and/or modify    //
+//  it under the terms of the GNU Lesser General Public License             //
+//  as published by the Free Software Foundation, either                    //
+//  version 3 of the License, or (at your option) any later version.        //
+//                                                                          //
+//  This program is distributed in the hope that it will be useful,         //
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of          //
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the           //
+//  GNU General Public License for more details.                            //
+//                                                                          //
+//  You should have received a copy of the GNU General Public License       //
+//  along with this program.  If not, see <http://www.gnu.org/licenses/>.   //
+//                                                                          //
+//////////////////////////////////////////////////////////////////////////////
+
+
+
+#include "owslave.h"
+
+// protocol states
+#define OWS_IDLE    0  // deselected, waiting for a reset
+#define OWS_ROM     1  // receiving a ROM command
+#define OWS_SEARCH  2  // ROM search
+#define OWS_MATCH   3  // receiving a ROM number
+#define OWS_FUNC    4  // receiving a function command
+#define OWS_TX      5  // transmitting bytes
+#define OWS_RX      6  // receiving scratchpad bytes
+#define OWS_CONV    7  // temperature conversion status
+#define OWS_PWR     8  // power supply status
+#define OWS_DONE    9  // read slots return '1'
+
+// power-on temperature (85 C)
+#define OWSLAVE_POR  (85 << 4)
+
+//--------------------------------------------------------------------------
+// Dallas CRC8 (x^8 + x^5 + x^4 + 1)
+//
+uint8_t owslave_crc8 (const uint8_t *buf, int len)
+{
+   uint8_t crc = 0;
+   int i, b;
+
+   for (i=0; i<len; i++) {
+      crc ^= buf[i];
+      for (b=0; b<8; b++)
+         crc = (crc & 1) ? (crc >> 1) ^ 0x8c : (crc >> 1);
+   }
+   return crc;
+}
+
+//--------------------------------------------------------------------------
+// temperature conversion time in nanoseconds
+//
+uint64_t owslave_conv_time (const owslave *s)
+{
+   if (s->rom[0] == OWSLAVE_DS18S20)
+      return 750000000ull;
+   // 93.75ms for 9bit resolution, doubled for each additional bit
+   return 93750000ull << ((s->sp[4] >> 5) & 3);
+}
+
+static void owslave_temp_set (owslave *s, int t)
+{
+   int r, i;
+
+   if (s->rom[0] == OWSLAVE_DS18S20) {
+      // extended resolution: T = TEMP_READ - 0.25 + (COUNT_PER_C - COUNT_REMAIN) / COUNT_PER_C
+      i = t >> 4;
+      r = 12 - (t & 0xf);
+      if (r < 0) { i++; r += 16; }
+      t = (i << 1) | ((t >> 3) & 1);
+      s->sp[0] = t;
+      s->sp[1] = (i < 0) ? 0xff : 0x00;
+      s->sp[6] = r;
+      s->sp[7] = 0x10;
+   } else {
+      // clear undefined bits for the configured resolution
+      r = (s->sp[4] >> 5) & 3;
+      t &= ~((1 << (3-r)) - 1);
+      s->sp[0] = t;
+      s->sp[1] = t >> 8;
+   }
+}
+
+static int owslave_temp_int (const owslave *s)
+{
+   if (s->rom[0] == OWSLAVE_DS18S20)
+      return (int16_t) (s->sp[0] | (s->sp[1] << 8)) >> 1;
+   else
+      return (int16_t) (s->sp[0] | (s->sp[1] << 8)) >> 4;
+}
+
+//--------------------------------------------------------------------------
+// finish a pending conversion if its time has passed
+//
+static void owslave_update (owslave *s, uint64_t t)
+{
+   int ti;
+
+   if (!s->conv || (t < s->conv_end))  return;
+   s->conv = 0;
+   if (s->parasite && (s->conv_err || !s->conv_pwr)) {
+      // without the strong pull-up the result is the power-on value
+      owslave_temp_set (s, OWSLAVE_POR);
+   } else {
+      owslave_temp_set (s, s->temp);
+   }
+   ti = owslave_temp_int (s);
+   s->alarm = (ti >= (int8_t) s->sp[2]) || (ti <= (int8_t) s->sp[3]);
+}
+
+//--------------------------------------------------------------------------
+// initialize a device with a given family code and 48bit serial number
+//
+void owslave_init (owslave *s, int family, uint64_t serial, int parasite)
+{
+   int i;
+
+   s->rom[0] = family;
+   for (i=1; i<7; i++) {
+      s->rom[i] = serial;
+      serial >>= 8;
+   }
+   s->rom[7] = owslave_crc8 (s->rom, 7);
+
+   s->parasite = parasite;
+   s->present  = 1;
+   s->temp     = 25 << 4;
+
+   s->ee[0] = 0x4b;
+   s->ee[1] = 0x46;
+   s->ee[2] = 0x7f;
+   s->sp[2] = s->ee[0];
+   s->sp[3] = s->ee[1];
+   s->sp[4] = (family == OWSLAVE_DS18S20) ? 0xff : s->ee[2];
+   s->sp[5] = 0xff;
+   owslave_temp_set (s, OWSLAVE_POR);
+   if (family != OWSLAVE_DS18S20) {
+      s->sp[6] = 0x0c;
+      s->sp[7] = 0x10;
+   }
+   s->sp[8] = owslave_crc8 (s->sp, 8);
+
+   s->state    = OWS_IDLE;
+   s->next     = OWS_IDLE;
+   s->ovd      = 0;
+   s->bit      = 0;
+   s->cnt      = 0;
+   s->len      = 0;
+   s->dat      = 0;
+   s->out      = 0;
+   s->alarm    = 0;
+   s->conv     = 0;
+   s->conv_pwr = 0;
+   s->conv_err = 0;
+   s->conv_end = 0;
+   s->pwr      = 0;
+}
+
+//--------------------------------------------------------------------------
+// reset pulse, a normal reset returns the device to standard speed, an
+// overdrive reset only affects devices already at overdrive speed
+//
+int owslave_reset (owslave *s, int ovd, uint64_t t)
+{
+   if (!s->present)       return 0;
+   if (ovd && !s->ovd)    return 0;
+   owslave_update (s, t);
+   if (!ovd)  s->ovd = 0;
+   s->state = OWS_ROM;
+   s->bit   = 0;
+   s->dat   = 0;
+   return 1;
+}
+
+//--------------------------------------------------------------------------
+// value driven by the device during the current time slot
+//
+int owslave_drive (owslave *s, uint64_t t)
+{
+   int b;
+
+   switch (s->state) {
+      case OWS_SEARCH:
+         b = (s->rom[s->bit >> 3] >> (s->bit & 7)) & 1;
+         if (s->cnt == 0)  return b;
+         if (s->cnt == 1)  return !b;
+         return 1;
+      case OWS_TX:
+         return (s->dat >> s->bit) & 1;
+      case OWS_CONV:
+         owslave_update (s, t);
+         return s->parasite || !s->conv;
+      case OWS_PWR:
+         return !s->parasite;
+      default:
+         return 1;
+   }
+}
+
+// start transmitting a buffer
+static void owslave_tx (owslave *s, const uint8_t *buf, int len, int next)
+{
+   s->state = OWS_TX;
+   s->next  = next;
+   s->out   = buf;
+   s->len   = len;
+   s->cnt   = 0;
+   s->dat   = buf[0];
+}
+
+static void owslave_rom_cmd (owslave *s, uint8_t cmd)
+{
+   int ovd_e = (s->rom[0] == OWSLAVE_DS28EA00);
+
+   s->bit = 0;
+   s->cnt = 0;
+   switch (cmd) {
+      case 0xf0:  s->state = OWS_SEARCH;                      break;  // search ROM
+      case 0xec:  s->state = s->alarm ? OWS_SEARCH : OWS_IDLE; break;  // alarm search
+      case 0x55:  s->state = OWS_MATCH;                       break;  // match ROM
+      case 0xcc:  s->state = OWS_FUNC;                        break;  // skip ROM
+      case 0x33:  owslave_tx (s, s->rom, 8, OWS_FUNC);        break;  // read ROM
+      case 0x69:  // overdrive match ROM, the ROM number is sent at overdrive speed
+         s->ovd   = ovd_e;
+         s->state = ovd_e ? OWS_MATCH : OWS_IDLE;
+         break;
+      case 0x3c:  // overdrive skip ROM
+         s->ovd   = ovd_e;
+         s->state = ovd_e ? OWS_FUNC : OWS_IDLE;
+         break;
+      default:    s->state = OWS_IDLE;                        break;
+   }
+}
+
+static void owslave_func_cmd (owslave *s, uint8_t cmd, uint64_t t)
+{
+   s->bit = 0;
+   s->cnt = 0;
+   switch (cmd) {
+      case 0x44:  // convert T
+         s->conv     = 1;
+         s->conv_pwr = 0;
+         s->conv_err = 0;
+         s->conv_end = t + owslave_conv_time (s);
+         s->state    = OWS_CONV;
+         break;
+      case 0xbe:  // read scratchpad
+         s->sp[8] = owslave_crc8 (s->sp, 8);
+         owslave_tx (s, s->sp, 9, OWS_DONE);
+         break;
+      case 0x4e:  // write scratchpad (TH, TL and configuration)
+         s->state = OWS_RX;
+         s->len   = (s->rom[0] == OWSLAVE_DS18S20) ? 2 : 3;
+         s->dat   = 0;
+         break;
+      case 0x48:  // copy scratchpad
+         s->ee[0] = s->sp[2];
+         s->ee[1] = s->sp[3];
+         s->ee[2] = s->sp[4];
+         s->state = OWS_DONE;
+         break;
+      case 0xb8:  // recall EEPROM
+         s->sp[2] = s->ee[0];
+         s->sp[3] = s->ee[1];
+         if (s->rom[0] != OWSLAVE_DS18S20)  s->sp[4] = s->ee[2];
+         s->state = OWS_DONE;
+         break;
+      case 0xb4:  // read power supply
+         s->state = OWS_PWR;
+         break;
+      default:
+         s->state = OWS_IDLE;
+         break;
+   }
+}
+
+//--------------------------------------------------------------------------
+// wired-AND line value at the device sampling point
+//
+void owslave_sample (owslave *s, int line, uint64_t t)
+{
+   int b;
+
+   // bus activity during a parasite powered conversion drains the device
+   if (s->conv && s->parasite && (t < s->conv_end))  s->conv_err = 1;
+   owslave_update (s, t);
+
+   switch (s->state) {
+      case OWS_ROM:
+      case OWS_FUNC:
+      case OWS_RX:
+         s->dat |= (line & 1) << s->bit;
+         if (++s->bit < 8)  break;
+         b = s->dat;
+         s->dat = 0;
+         if      (s->state == OWS_ROM )  owslave_rom_cmd  (s, b);
+         else if (s->state == OWS_FUNC)  owslave_func_cmd (s, b, t);
+         else {
+            s->sp[2 + s->cnt] = b;
+            s->bit = 0;
+            if (++s->cnt == s->len) {
+               if (s->rom[0] != OWSLAVE_DS18S20)  s->sp[4] = (s->sp[4] & 0x60) | 0x1f;
+               s->state = OWS_DONE;
+            }
+         }
+         break;
+      case OWS_SEARCH:
+         if (s->cnt++ < 2)  break;
+         s->cnt = 0;
+         b = (s->rom[s->bit >> 3] >> (s->bit & 7)) & 1;
+         if (b != line)        s->state = OWS_IDLE;
+         else if (++s->bit == 64)  s->state = OWS_FUNC, s->bit = 0, s->dat = 0;
+         break;
+      case OWS_MATCH:
+         b = (s->rom[s->bit >> 3] >> (s->bit & 7)) & 1;
+         if (b != line)        s->state = OWS_IDLE;
+         else if (++s->bit == 64)  s->state = OWS_FUNC, s->bit = 0, s->dat = 0;
+         break;
+      case OWS_TX:
+         if (++s->bit < 8)  break;
+         s->bit = 0;
+         if (++s->cnt == s->len)  s->state = s->next, s->dat = 0;
+         else                     s->dat = s->out[s->cnt];
+         break;
+      default:
+         break;
+   }
+}
+
+//--------------------------------------------------------------------------
+// strong pull-up status change
+//
+void owslave_power (owslave *s, int pwr, uint64_t t)
+{
+   if (s->conv && (t < s->conv_end)) {
+      if (pwr)  s->conv_pwr = 1;
+      else      s->conv_err = 1;
+   }
+   owslave_update (s, t);
+   s->pwr = pwr;
+}
+
+//--------------------------------------------------------------------------
+// the device takes part in the current transaction
+//
+int owslave_active (const owslave *s)
+{
+   return s->present && (s->state != OWS_IDLE);
+}
+
+//--------------------------------------------------------------------------
+// complete a ROM function (search or match) on behalf of a bus simulator,
+// the device is either selected (waiting for a function command) or not
+//
+void owslave_select (owslave *s)
+{
+   s->state = OWS_FUNC;
+   s->bit   = 0;
+   s->cnt   = 0;
+   s->dat   = 0;
+}
+
+void owslave_deselect (owslave *s)
+{
+   s->state = OWS_IDLE;
+}
+
+//--------------------------------------------------------------------------
+// compare ROM numbers in search order (least significant bit first)
+//
+int owslave_rom_cmp (const owslave *a, const owslave *b)
+{
+   int i, x;
+
+   for (i=0; i<8; i++) {
+      x = a->rom[i] ^ b->rom[i];
+      if (x)  return ((a->rom[i] >> __builtin_ctz (x)) & 1) ? 1 : -1;
+   }
+   return 0;
+}
@@ -0,0 +1,90 @@
+//////////////////////////////////////////////////////////////////////////////
+//                                                                          //
+//  Minimalistic 1-wire (onewire) master with Avalon MM bus interface       //
+//                                                                          //
+//  Copyright (C) 2010  Iztok Jeras                                         //
+//                                                                          //
+//////////////////////////////////////////////////////////////////////////////
+//                                                                          //
+//  This program is free software: you can redistribute it and/or modify    //
+//  it under the terms of the GNU Lesser General Public License             //
+//  as published by the Free Software Foundation, either                    //
+//  version 3 of the License, or (at your option) any later version.        //
+//                                                                          //
+//  This program is distributed in the hope that it will be useful,         //
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of          //
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the           //
+//  GNU General Public License for more details.                            //
+//                                                                          //
+//  You should have received a copy of the GNU General Public License       //
+//  along with this program.  If not, see <http://www.gnu.org/licenses/>.   //
+//                                                                          //
+//////////////////////////////////////////////////////////////////////////////
+
+
+
+//////////////////////////////////////////////////////////////////////////////
+//                                                                          //
+// Behavioural 1-wire slave device models (DS18S20, DS18B20, DS28EA00)      //
+//                                                                          //
+// The model works at the time slot level, bus adapters translate their     //
+// timing into the next calls:                                              //
+// - owslave_reset  at the end of a reset pulse, returns presence           //
+// - owslave_drive  at the start of a time slot, returns the driven bit     //
+// - owslave_sample at the device sampling point, with the wired-AND value  //
+// - owslave_power  when the strong pull-up is switched on or off           //
+// Time 't' is given in nanoseconds.                                        //
+//                                                                          //
+//////////////////////////////////////////////////////////////////////////////
+
+#ifndef __OWSLAVE_H__
+#define __OWSLAVE_H__
+
+#include <stdint.h>
+
+// supported device family codes
+#define OWSLAVE_DS18S20    0x10
+#define OWSLAVE_DS18B20    0x28
+#define OWSLAVE_DS28EA00   0x42
+
+typedef struct owslave_s
+{
+  // configuration
+  uint8_t          rom[8];          // ROM number (family, serial, CRC)
+  int              parasite;        // parasite powered device
+  int              present;         // device is connected to the bus
+  int              temp;            // measured temperature [1/16 C]
+  // memory
+  uint8_t          sp[9];           // scratchpad
+  uint8_t          ee[3];           // EEPROM (TH, TL, configuration)
+  // protocol state
+  int              state;           // protocol state
+  int              next;            // state after a transmit
+  int              ovd;             // overdrive speed
+  int              bit;             // bit counter
+  int              cnt;             // byte counter (search phase)
+  int              len;             // transmit/receive length
+  uint8_t          dat;             // transmit/receive byte
+  const uint8_t*   out;             // transmit buffer
+  int              alarm;           // alarm condition
+  // temperature conversion
+  int              conv;            // conversion in progress
+  int              conv_pwr;        // strong pull-up was applied during conversion
+  int              conv_err;        // conversion corrupted (parasite power loss)
+  uint64_t         conv_end;        // conversion end time
+  int              pwr;             // strong pull-up status
+} owslave;
+
+extern void     owslave_init      (owslave *s, int family, uint64_t serial, int parasite);
+extern int      owslave_reset     (owslave *s, int ovd, uint64_t t);
+extern int      owslave_drive     (owslave *s, uint64_t t);
+extern void     owslave_sample    (owslave *s, int line, uint64_t t);
+extern void     owslave_power     (owslave *s, int pwr, uint64_t t);
+extern int      owslave_active    (const owslave *s);
+extern void     owslave_select    (owslave *s);
+extern void     owslave_deselect  (owslave *s);
+extern int      owslave_rom_cmp   (const owslave *a, const owslave *b);
+extern uint64_t owslave_conv_time (const owslave *s);
+extern uint8_t  owslave_crc8      (const uint8_t *buf, int len);
+
+#endif // __OWSLAVE_H__
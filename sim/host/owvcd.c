@@ -0,0 +1,589 @@
+//////////////////////////////////////////////////////////////////////////////
+//                                                                          //
+//  Minimalistic 1-wire (onewire) master with Avalon MM bus interface       //
+//                                                                          //
+//  Copyright (C) 2010  Iztok Jeras                                         //
+//                                                                          //
+//////////////////////////////////////////////////////////////////////////////
+//                                                                          //
+//  This program is free software: you can redistribute it and/or modify    //
+//  it under the terms of the GNU Lesser General Public License             //
+//  as published by the Free Software Foundation, either                    //
+//  version 3 of the License, or (at your option) any later version.        //
+//                                                                          //
+//  This program is distributed in the hope that it will be useful,         //
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of          //
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the           //
+//  GNU General Public License for more details.                            //
+//                                                                          //
+//  You should have received a copy of the GNU General Public License       //
+//  along with this program.  If not, see <http://www.gnu.org/licenses/>.   //
+//                                                                          //
+//////////////////////////////////////////////////////////////////////////////
+
+
+
+//////////////////////////////////////////////////////////////////////////////
+//                                                                          //
+// 1-wire protocol decoder and timing analyzer for VCD files                //
+//                                                                          //
+// Reads the owr_e (master pull down), owr_i (line) and owr_p (strong       //
+// pull-up) vectors of the testbench top module and for each port:          //
+// - decodes resets, presence pulses, bits, bytes and ROM commands          //
+// - measures the 1-wire timing parameters and compares them against the    //
+//   specification limits (standard and overdrive speed)                    //
+// - computes bus utilization, idle gaps between the end of a time slot     //
+//   (including the minimum recovery time) and the start of the next one    //
+//   are software turnaround (or strong pull-up) time                       //
+//                                                                          //
+// The speed of a slot is inferred from the last reset (a low pulse between //
+// 30us and 240us is an overdrive reset) and from the Overdrive Skip ROM    //
+// and Overdrive Match ROM commands.                                        //
+//                                                                          //
+// usage: owvcd [-s] [-g gap_us] [-m module] file.vcd                       //
+//   -s  summary only (no decoded transactions)                             //
+//   -g  report gaps longer than gap_us (default 10us)                      //
+//   -m  scope of the owr_* signals (default the first top level module)    //
+//                                                                          //
+//////////////////////////////////////////////////////////////////////////////
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+#define OWVCD_OWN   16  // maximum number of ports
+#define OWVCD_GAPS   5  // longest gaps listed for each port
+
+// timing parameters
+enum {
+  OWVCD_RSTL,  // reset low
+  OWVCD_RSTH,  // reset release to the next slot
+  OWVCD_PDH,   // reset release to presence pulse
+  OWVCD_PDL,   // presence pulse low
+  OWVCD_W0L,   // write 0 low
+  OWVCD_W1L,   // write 1 (read) low
+  OWVCD_RD0,   // read 0 low (master and device)
+  OWVCD_SLOT,  // slot start to the next slot start
+  OWVCD_REC,   // recovery (line high to the next slot)
+  OWVCD_NUM
+};
+
+static const char *owvcd_par [OWVCD_NUM] = {
+  "tRSTL", "tRSTH", "tPDH", "tPDL", "tW0L", "tW1L", "tRD0", "tSLOT", "tREC"
+};
+
+// specification limits [us] for standard and overdrive speed (0 - no limit)
+static const double owvcd_spec [2][OWVCD_NUM][2] = {
+  {{480, 640}, {480,   0}, {15, 60}, {60, 240}, {60, 120}, {1, 15}, {15, 60}, {61, 0}, {5, 0}},
+  {{ 48,  80}, { 48,   0}, { 2,  6}, { 8,  24}, { 6,  16}, {1,  2}, { 2,  6}, { 7, 0}, {2, 0}},
+};
+
+// slot types
+#define OWVCD_NONE  0
+#define OWVCD_RST   1
+#define OWVCD_W0    2
+#define OWVCD_W1    3
+
+// decoder phases
+#define OWVCD_ROM     0  // ROM command
+#define OWVCD_SEARCH  1  // search triplets
+#define OWVCD_MATCH   2  // ROM number
+#define OWVCD_DATA    3  // function command and data
+
+typedef struct owvcd_stat_s
+{
+  long             n, viol;
+  double           min, max;
+} owvcd_stat;
+
+typedef struct owvcd_port_s
+{
+  // levels
+  int              e, i, p;
+  // slot
+  int              ovd;             // speed
+  int              kind;            // slot type
+  int              mlow;            // line low started by the master
+  int              prs;             // presence window is open
+  double           t_fall;          // line low start
+  double           t_mrel;          // master release
+  double           t_slot;          // slot start
+  double           t_rise;          // line high after the slot
+  double           t_end;           // slot end including minimum recovery
+  double           t_rel;           // reset release
+  int              first;           // no slot seen yet
+  // decoder
+  int              phase;
+  int              nbit;
+  int              cnt;
+  uint64_t         rom;
+  int              dat;
+  int              nbyte;
+  // statistics
+  owvcd_stat       st[2][OWVCD_NUM];
+  long             n_rst, n_bit, n_prs, n_slave;
+  double           t_beg, t_last;   // first and last slot
+  double           busy, idle, pwr; // busy, idle and powered gap time
+  double           p_acc, p_t;      // strong pull-up time
+  double           p_rise;          // strong pull-up time at the last line rise
+  long             n_gap;
+  double           gap[OWVCD_GAPS], gap_t[OWVCD_GAPS];
+} owvcd_port;
+
+static owvcd_port port [OWVCD_OWN];
+static int        own;
+static int        quiet;
+static double     gap_min = 10.0;
+
+//--------------------------------------------------------------------------
+// statistics
+//
+
+static void stat_add (owvcd_port *p, int par, double v)
+{
+  owvcd_stat       *s   = &p->st[p->ovd][par];
+  const double     *lim = owvcd_spec[p->ovd][par];
+
+  if (!s->n || (v < s->min))  s->min = v;
+  if (!s->n || (v > s->max))  s->max = v;
+  s->n++;
+  if ((v < lim[0]) || (lim[1] && (v > lim[1])))  s->viol++;
+}
+
+static double pwr_at (owvcd_port *p, double t)
+{
+  return p->p_acc + (p->p ? t - p->p_t : 0);
+}
+
+// idle time between the end of the previous slot and this one
+static void gap_add (owvcd_port *p, double t, double pwr)
+{
+  double g = t - p->t_end;
+  int    i, j;
+
+  if (g <= 0)  return;
+  // mostly powered gaps are intentional (strong pull-up, delay cycles)
+  if (pwr > g/2) {
+    p->pwr += g;
+    return;
+  }
+  p->idle += g;
+  if (g < gap_min)  return;
+  p->n_gap++;
+  for (i=0; i<OWVCD_GAPS; i++) {
+    if (g > p->gap[i]) {
+      for (j=OWVCD_GAPS-1; j>i; j--)  p->gap[j] = p->gap[j-1], p->gap_t[j] = p->gap_t[j-1];
+      p->gap[i]   = g;
+      p->gap_t[i] = p->t_end;
+      break;
+    }
+  }
+}
+
+//--------------------------------------------------------------------------
+// protocol decoder
+//
+
+static const char* rom_name (int cmd)
+{
+  switch (cmd) {
+    case 0xF0: return "Search ROM";
+    case 0xEC: return "Alarm Search";
+    case 0x55: return "Match ROM";
+    case 0xCC: return "Skip ROM";
+    case 0x33: return "Read ROM";
+    case 0x3C: return "Overdrive Skip ROM";
+    case 0x69: return "Overdrive Match ROM";
+    case 0xA5: return "Resume";
+    default:   return "unknown";
+  }
+}
+
+static void dec_reset (int n, owvcd_port *p, double t)
+{
+  if (!quiet) {
+    if (p->nbit)  printf ("  (%d bits)", p->nbit);
+    if (p->nbyte || p->nbit || (p->phase != OWVCD_ROM))  printf ("\n");
+    printf ("%12.3fus port %d: %s reset", t, n, p->ovd ? "overdrive" : "standard");
+  }
+  p->phase = OWVCD_ROM;
+  p->nbit  = 0;
+  p->nbyte = 0;
+  p->dat   = 0;
+}
+
+static void dec_bit (owvcd_port *p, int b)
+{
+  switch (p->phase) {
+    case OWVCD_SEARCH:
+      // bit, complement, direction
+      if (++p->cnt == 3) {
+        p->rom |= (uint64_t) b << p->nbit;
+        p->cnt  = 0;
+        if (++p->nbit == 64) {
+          if (!quiet)  printf (" %016llX", (unsigned long long) p->rom);
+          p->phase = OWVCD_DATA;
+          p->nbit  = 0;
+        }
+      }
+      return;
+    case OWVCD_MATCH:
+      p->rom |= (uint64_t) b << p->nbit;
+      if (++p->nbit == 64) {
+        if (!quiet)  printf (" %016llX", (unsigned long long) p->rom);
+        p->phase = OWVCD_DATA;
+        p->nbit  = 0;
+      }
+      return;
+    default:
+      p->dat |= b << p->nbit;
+      if (++p->nbit < 8)  return;
+      p->nbit = 0;
+      if (p->phase == OWVCD_ROM) {
+        if (!quiet)  printf (", %02X %s", p->dat, rom_name (p->dat));
+        p->rom = 0;
+        p->cnt = 0;
+        if      ((p->dat == 0xF0) || (p->dat == 0xEC))  p->phase = OWVCD_SEARCH;
+        else if ((p->dat == 0x55) || (p->dat == 0x69))  p->phase = OWVCD_MATCH;
+        else                                            p->phase = OWVCD_DATA;
+        // the next slots are at overdrive speed
+        if ((p->dat == 0x3C) || (p->dat == 0x69))  p->ovd = 1;
+      } else {
+        if (!quiet)  printf ("%s%02X", p->nbyte++ ? " " : ", data ", p->dat);
+      }
+      p->dat = 0;
+  }
+}
+
+//--------------------------------------------------------------------------
+// line events
+//
+
+// line pulled low
+static void ev_fall (int n, owvcd_port *p, double t)
+{
+  double pwr = pwr_at (p, t) - p->p_rise;
+
+  if (p->e) {
+    // slot start
+    if (!p->first) {
+      gap_add (p, t, pwr);
+      if (p->kind == OWVCD_RST)  stat_add (p, OWVCD_RSTH, t - p->t_rel);
+      else                       stat_add (p, OWVCD_SLOT, t - p->t_slot);
+      stat_add (p, OWVCD_REC, t - p->t_rise);
+    } else {
+      p->t_beg = t;
+    }
+    p->first  = 0;
+    p->mlow   = 1;
+    p->prs    = 0;
+    p->t_fall = t;
+    p->t_slot = t;
+  } else if (p->prs) {
+    // presence pulse
+    p->mlow   = 0;
+    p->t_fall = t;
+  } else {
+    // line pulled low by a device outside of a slot
+    p->mlow   = 0;
+    p->t_fall = t;
+    p->n_slave++;
+    if (!quiet)  printf ("\n%12.3fus port %d: line pulled low by a device", t, n);
+  }
+}
+
+// master releases the line
+static void ev_release (int n, owvcd_port *p, double t)
+{
+  double d = t - p->t_fall;
+
+  p->t_mrel = t;
+  if (!p->mlow)  return;
+  // slot type from the low time, the speed is updated by resets
+  if (d >= 240) {
+    p->ovd  = 0;
+    p->kind = OWVCD_RST;
+  } else if (d >= 30 && (p->ovd || d < 60)) {
+    p->ovd  = 1;
+    p->kind = OWVCD_RST;
+  } else if (d >= (p->ovd ? 3 : 15)) {
+    p->kind = OWVCD_W0;
+  } else {
+    p->kind = OWVCD_W1;
+  }
+  if (p->kind == OWVCD_RST) {
+    stat_add (p, OWVCD_RSTL, d);
+    p->n_rst++;
+    dec_reset (n, p, p->t_fall);
+  } else {
+    stat_add (p, (p->kind == OWVCD_W0) ? OWVCD_W0L : OWVCD_W1L, d);
+    p->n_bit++;
+  }
+}
+
+// line high
+static void ev_rise (int n, owvcd_port *p, double t)
+{
+  int o = p->ovd;
+
+  if (!p->mlow) {
+    // presence pulse end
+    if (p->prs) {
+      stat_add (p, OWVCD_PDH, p->t_fall - p->t_rel);
+      stat_add (p, OWVCD_PDL, t - p->t_fall);
+      p->n_prs++;
+      p->prs = 0;
+      if (!quiet)  printf (", presence");
+    }
+    p->t_rise = t;
+    p->p_rise = pwr_at (p, t);
+    return;
+  }
+  p->mlow   = 0;
+  p->t_rise = t;
+  p->p_rise = pwr_at (p, t);
+  if (p->kind == OWVCD_RST) {
+    p->t_rel = t;
+    p->prs   = 1;
+    p->t_end = t + owvcd_spec[o][OWVCD_RSTH][0];
+  } else {
+    if (p->kind == OWVCD_W1) {
+      // the device held the line after the master released it
+      if (t > p->t_mrel) {
+        stat_add (p, OWVCD_RD0, t - p->t_fall);
+        dec_bit (p, 0);
+      } else {
+        dec_bit (p, 1);
+      }
+    } else {
+      dec_bit (p, 0);
+    }
+    p->t_end = p->t_slot + owvcd_spec[o][OWVCD_SLOT][0];
+    if (p->t_end < t + owvcd_spec[o][OWVCD_REC][0])  p->t_end = t + owvcd_spec[o][OWVCD_REC][0];
+  }
+  p->busy  += p->t_end - p->t_slot;
+  p->t_last = t;
+}
+
+static void ev_power (owvcd_port *p, int v, double t)
+{
+  if (p->p)  p->p_acc += t - p->p_t;
+  p->p   = v;
+  p->p_t = t;
+}
+
+// apply the new levels of a port, events at the same time are ordered
+static void port_update (int n, int e, int i, int pw, double t)
+{
+  owvcd_port *p = &port[n];
+  int e_old = p->e, i_old = p->i;
+
+  if (pw != p->p)          ev_power (p, pw, t);
+  p->e = e;
+  if ( i_old && !i) {  p->i = i;  ev_fall (n, p, t);  }
+  if ( e_old && !e)        ev_release (n, p, t);
+  if (!i_old &&  i) {  p->i = i;  ev_rise (n, p, t);  }
+  p->i = i;
+}
+
+//--------------------------------------------------------------------------
+// VCD parser
+//
+
+typedef struct owvcd_sig_s
+{
+  char             id[16];
+  int              width;
+  int              depth;
+  char             val[OWVCD_OWN];  // bit values (index is the bit number)
+} owvcd_sig;
+
+static owvcd_sig sig[3];  // owr_e, owr_i, owr_p
+
+static int vcd_token (FILE *f, char *buf, int len)
+{
+  int c, n = 0;
+
+  do c = fgetc (f); while ((c == ' ') || (c == '\t') || (c == '\n') || (c == '\r'));
+  if (c == EOF)  return 0;
+  while ((c != EOF) && (c != ' ') && (c != '\t') && (c != '\n') && (c != '\r')) {
+    if (n < len-1)  buf[n++] = c;
+    c = fgetc (f);
+  }
+  buf[n] = '\0';
+  return 1;
+}
+
+static void vcd_skip (FILE *f)
+{
+  char tok[256];
+
+  while (vcd_token (f, tok, sizeof (tok)) && strcmp (tok, "$end"));
+}
+
+static int vcd_sig (const char *id)
+{
+  int s;
+
+  for (s=0; s<3; s++)
+    if (sig[s].width && !strcmp (sig[s].id, id))  return s;
+  return -1;
+}
+
+// store a vector value (right aligned, extended with the leftmost 0/x/z)
+static void vcd_value (owvcd_sig *s, const char *v)
+{
+  int len = strlen (v), b;
+
+  for (b=0; b<s->width && b<OWVCD_OWN; b++)
+    s->val[b] = (b < len) ? v[len-1-b] : ((v[0] == '1') ? '0' : v[0]);
+}
+
+static void vcd_apply (double t)
+{
+  int n;
+
+  for (n=0; n<own; n++) {
+    // undefined master outputs are inactive, the line has a pull-up
+    int e = sig[0].val[n] == '1';
+    int i = sig[1].val[n] != '0';
+    int p = sig[2].width ? sig[2].val[n] == '1' : 0;
+    port_update (n, e, i, p, t);
+  }
+}
+
+int main (int argc, char **argv)
+{
+  static const char *names[3] = {"owr_e", "owr_i", "owr_p"};
+  const char *module = NULL, *file = NULL;
+  char tok[256], id[256], name[256], scope[64][64];
+  double unit = 1.0e-6, t = 0, t_prev = -1;
+  int depth = 0, width, s, n, a, o, par;
+  FILE *f;
+
+  for (a=1; a<argc; a++) {
+    if      (!strcmp (argv[a], "-s"))              quiet = 1;
+    else if (!strcmp (argv[a], "-g") && (a+1 < argc))  gap_min = atof (argv[++a]);
+    else if (!strcmp (argv[a], "-m") && (a+1 < argc))  module = argv[++a];
+    else                                           file = argv[a];
+  }
+  if (!file) {
+    fprintf (stderr, "usage: %s [-s] [-g gap_us] [-m module] file.vcd\n", argv[0]);
+    return 1;
+  }
+  f = fopen (file, "r");
+  if (!f) {
+    perror (file);
+    return 1;
+  }
+
+  // header
+  while (vcd_token (f, tok, sizeof (tok))) {
+    if (!strcmp (tok, "$timescale")) {
+      double num;
+      char   u[16] = "";
+      vcd_token (f, tok, sizeof (tok));
+      num = atof (tok);
+      // the unit may be separated from the number
+      for (n=0; tok[n] && ((tok[n] >= '0') && (tok[n] <= '9')); n++);
+      if (tok[n])  strncpy (u, tok+n, sizeof (u)-1);
+      else         vcd_token (f, u, sizeof (u));
+      // convert to microseconds
+      unit = num * (!strcmp (u, "s")  ? 1.0e6  : !strcmp (u, "ms") ? 1.0e3  :
+                    !strcmp (u, "us") ? 1.0    : !strcmp (u, "ns") ? 1.0e-3 :
+                    !strcmp (u, "ps") ? 1.0e-6 : 1.0e-9);
+      vcd_skip (f);
+    } else if (!strcmp (tok, "$scope")) {
+      vcd_token (f, tok, sizeof (tok));
+      vcd_token (f, tok, sizeof (tok));
+      if (depth < 64)  snprintf (scope[depth], sizeof (scope[depth]), "%.63s", tok);
+      depth++;
+      vcd_skip (f);
+    } else if (!strcmp (tok, "$upscope")) {
+      depth--;
+      vcd_skip (f);
+    } else if (!strcmp (tok, "$var")) {
+      vcd_token (f, tok, sizeof (tok));
+      vcd_token (f, tok, sizeof (tok));  width = atoi (tok);
+      vcd_token (f, id,  sizeof (id));
+      vcd_token (f, name, sizeof (name));
+      vcd_skip (f);
+      for (s=0; s<3; s++) {
+        if (strcmp (name, names[s]))  continue;
+        if (module ? ((depth < 1) || strcmp (scope[depth-1], module)) : (depth != 1))  continue;
+        if (sig[s].width)  continue;
+        snprintf (sig[s].id, sizeof (sig[s].id), "%.15s", id);
+        sig[s].width = width;
+        sig[s].depth = depth;
+        memset (sig[s].val, 'x', sizeof (sig[s].val));
+      }
+    } else if (!strcmp (tok, "$enddefinitions")) {
+      vcd_skip (f);
+      break;
+    } else if (tok[0] == '$') {
+      vcd_skip (f);
+    }
+  }
+  if (!sig[0].width || !sig[1].width) {
+    fprintf (stderr, "ERROR: owr_e and owr_i signals were not found\n");
+    return 1;
+  }
+  own = sig[1].width < OWVCD_OWN ? sig[1].width : OWVCD_OWN;
+  for (n=0; n<own; n++) {
+    port[n].i     = 1;
+    port[n].first = 1;
+  }
+
+  // value changes, events are applied at the end of each time step
+  while (vcd_token (f, tok, sizeof (tok))) {
+    if (tok[0] == '#') {
+      t = atof (tok+1) * unit;
+      if (t != t_prev) {
+        if (t_prev >= 0)  vcd_apply (t_prev);
+        t_prev = t;
+      }
+    } else if ((tok[0] == 'b') || (tok[0] == 'B')) {
+      vcd_token (f, id, sizeof (id));
+      if ((s = vcd_sig (id)) >= 0)  vcd_value (&sig[s], tok+1);
+    } else if ((tok[0] == 'r') || (tok[0] == 'R')) {
+      vcd_token (f, id, sizeof (id));
+    } else if (strchr ("01xXzZ", tok[0])) {
+      if ((s = vcd_sig (tok+1)) >= 0)  vcd_value (&sig[s], (char[2]) {tok[0], '\0'});
+    }
+    // $dumpvars, $end and comments carry no events
+  }
+  if (t_prev >= 0)  vcd_apply (t_prev);
+  fclose (f);
+  if (!quiet)  printf ("\n");
+
+  // timing report
+  for (n=0; n<own; n++) {
+    owvcd_port *p = &port[n];
+    double span = p->t_last - p->t_beg;
+    if (p->first)  continue;
+    printf ("\nport %d: %ld resets, %ld presence pulses, %ld bits, %ld device initiated low pulses\n",
+            n, p->n_rst, p->n_prs, p->n_bit, p->n_slave);
+    printf ("  %-9s %-5s %6s %10s %10s %8s %8s %10s %10s %6s\n",
+            "speed", "par", "count", "min[us]", "max[us]", "spec_min", "spec_max", "margin_lo", "margin_hi", "viol");
+    for (o=0; o<2; o++) {
+      for (par=0; par<OWVCD_NUM; par++) {
+        owvcd_stat   *st  = &p->st[o][par];
+        const double *lim = owvcd_spec[o][par];
+        if (!st->n)  continue;
+        printf ("  %-9s %-5s %6ld %10.3f %10.3f %8.1f ", o ? "overdrive" : "standard", owvcd_par[par],
+                st->n, st->min, st->max, lim[0]);
+        if (lim[1])  printf ("%8.1f %10.3f %10.3f", lim[1], st->min - lim[0], lim[1] - st->max);
+        else         printf ("%8s %10.3f %10s", "-", st->min - lim[0], "-");
+        printf (" %6ld%s\n", st->viol, st->viol ? "  VIOLATION" : "");
+      }
+    }
+    printf ("  utilization: %.3fms span, %.3fms busy (%.1f%%), %.3fms idle, %.3fms powered\n",
+            span / 1.0e3, p->busy / 1.0e3, span > 0 ? 100.0 * p->busy / span : 0.0, p->idle / 1.0e3, p->pwr / 1.0e3);
+    printf ("  %ld idle gaps longer than %.1fus (software turnaround)", p->n_gap, gap_min);
+    for (s=0; s<OWVCD_GAPS && p->gap[s] > 0; s++)
+      printf ("%s%.3fus at %.3fus", s ? ", " : ": ", p->gap[s], p->gap_t[s]);
+    printf ("\n");
+  }
+  return 0;
+}
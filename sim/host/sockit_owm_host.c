@@ -0,0 +1,93 @@
+//////////////////////////////////////////////////////////////////////////////
+//                                                                          //
+//  Minimalistic 1-wire (onewire) master with Avalon MM bus interface       //
+//                                                                          //
+//  Copyright (C) 2010  Iztok Jeras                                         //
+//                                                                          //
+//////////////////////////////////////////////////////////////////////////////
+//                                                                          //
+//  This program is free software: you can redistribute it and/or modify    //
+//  it under the terms of the GNU Lesser General Public License             //
+//  as published by the Free Software Foundation, either                    //
+//  version 3 of the License, or (at your option) any later version.        //
+//                                                                          //
+//  This program is distributed in the hope that it will be useful,         //
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of          //
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the           //
+//  GNU General Public License for more details.                            //
+//                                                                          //
+//  You should have received a copy of the GNU General Public License       //
+//  along with this program.  If not, see <http://www.gnu.org/licenses/>.   //
+//                                                                          //
+//////////////////////////////////////////////////////////////////////////////
+
+
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "system.h"
+#include "io.h"
+#include "sys/alt_irq.h"
+
+#include "sockit_owm.h"
+#include "sockit_owm_host.h"
+
+// driver instance, normally created by the generated alt_sys_init.c
+SOCKIT_OWM_INSTANCE (SOCKIT_OWM, sockit_owm_0);
+
+static sockit_owm_host host;
+
+// interrupt handler registered by the driver
+static alt_isr_func host_isr;
+static void*        host_isr_ctx;
+
+int alt_ic_isr_register (alt_u32 ic_id, alt_u32 irq, alt_isr_func isr, void *isr_context, void *flags)
+{
+  host_isr     = isr;
+  host_isr_ctx = isr_context;
+  return 0;
+}
+
+// a cycle started by the handler ends inside the register write, the nested
+// interrupt is taken after the handler returns, like a level interrupt
+void sockit_owm_host_irq (void)
+{
+  static int active, pending;
+
+  if (!host_isr)  return;
+  if (active) {
+    pending = 1;
+    return;
+  }
+  active = 1;
+  do {
+    pending = 0;
+    host_isr (host_isr_ctx);
+  } while (pending);
+  active = 0;
+}
+
+alt_u32 sockit_owm_host_rd (void *base, int reg)
+{
+  if (!host.rd) {
+    fprintf (stderr, "sockit_owm_host: no backend attached\n");
+    exit (1);
+  }
+  return host.rd (host.ctx, reg);
+}
+
+void sockit_owm_host_wr (void *base, int reg, alt_u32 dat)
+{
+  if (!host.wr) {
+    fprintf (stderr, "sockit_owm_host: no backend attached\n");
+    exit (1);
+  }
+  host.wr (host.ctx, reg, dat);
+}
+
+void sockit_owm_host_init (const sockit_owm_host *h)
+{
+  host = *h;
+  SOCKIT_OWM_INIT (SOCKIT_OWM, sockit_owm_0);
+}
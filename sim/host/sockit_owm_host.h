@@ -0,0 +1,64 @@
+//////////////////////////////////////////////////////////////////////////////
+//                                                                          //
+//  Minimalistic 1-wire (onewire) master with Avalon MM bus interface       //
+//                                                                          //
+//  Copyright (C) 2010  Iztok Jeras                                         //
+//                                                                          //
+//////////////////////////////////////////////////////////////////////////////
+//                                                                          //
+//  This program is free software: you can redistribute it and/or modify    //
+//  it under the terms of the GNU Lesser General Public License             //
+//  as published by the Free Software Foundation, either                    //
+//  version 3 of the License, or (at your option) any later version.        //
+//                                                                          //
+//  This program is distributed in the hope that it will be useful,         //
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of          //
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the           //
+//  GNU General Public License for more details.                            //
+//                                                                          //
+//  You should have received a copy of the GNU General Public License       //
+//  along with this program.  If not, see <http://www.gnu.org/licenses/>.   //
+//                                                                          //
+//////////////////////////////////////////////////////////////////////////////
+
+
+
+//////////////////////////////////////////////////////////////////////////////
+//                                                                          //
+// Host build support for the sockit_owm HAL driver                         //
+//                                                                          //
+// The driver register accesses (IORD/IOWR from the host "io.h") are        //
+// forwarded to a backend, which can be the Verilator RTL model or the      //
+// virtual time bus simulator.                                              //
+//                                                                          //
+//////////////////////////////////////////////////////////////////////////////
+
+#ifndef __SOCKIT_OWM_HOST_H__
+#define __SOCKIT_OWM_HOST_H__
+
+#include "alt_types.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif // __cplusplus
+
+// simulation backend
+typedef struct sockit_owm_host_s
+{
+  alt_u32 (*rd) (void *ctx, int reg);
+  void    (*wr) (void *ctx, int reg, alt_u32 dat);
+  void*     ctx;
+} sockit_owm_host;
+
+// attach a backend, and initialize the driver (same as alt_sys_init)
+extern void sockit_owm_host_init (const sockit_owm_host *host);
+
+// run the registered interrupt handler (called by the backend)
+extern void sockit_owm_host_irq (void);
+
+#ifdef __cplusplus
+}
+#endif // __cplusplus
+
+#endif // __SOCKIT_OWM_HOST_H__
@@ -5,7 +5,7 @@ erase onewire.out
 erase onewire.vcd
 
 :: compile the verilog sources (testbench and RTL)
-iverilog -o onewire.out onewire_tb.v onewire_slave_model.v ..\sockit_owm\sockit_owm.v 
+iverilog -o onewire.out onewire_tb.v onewire_slave_model.v onewire_device_model.v ..\sockit_owm\sockit_owm.v 
 
 :: run the simulation
 vvp onewire.out
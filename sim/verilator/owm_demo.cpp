@@ -0,0 +1,126 @@
+//////////////////////////////////////////////////////////////////////////////
+//                                                                          //
+//  Minimalistic 1-wire (onewire) master with Avalon MM bus interface       //
+//                                                                          //
+//  Copyright (C) 2010  Iztok Jeras                                         //
+//                                                                          //
+//////////////////////////////////////////////////////////////////////////////
+//                                                                          //
+//  This program is free software: you can redistribute it and/or modify    //
+//  it under the terms of the GNU Lesser General Public License             //
+//  as published by the Free Software Foundation, either                    //
+//  version 3 of the License, or (at your option) any later version.        //
+//                                                                          //
+//  This program is distributed in the hope that it will be useful,         //
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of          //
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the           //
+//  GNU General Public License for more details.                            //
+//                                                                          //
+//  You should have received a copy of the GNU General Public License       //
+//  along with this program.  If not, see <http://www.gnu.org/licenses/>.   //
+//                                                                          //
+//////////////////////////////////////////////////////////////////////////////
+
+
+
+//////////////////////////////////////////////////////////////////////////////
+//                                                                          //
+// HAL driver running against the verilated RTL                             //
+//                                                                          //
+// The same flow as the Terasic DE1 demo: find all temperature devices and  //
+// read their temperature, then report simulated time and model speed.     //
+//                                                                          //
+//////////////////////////////////////////////////////////////////////////////
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "verilated.h"
+
+#include "sockit_owm_model.h"
+
+extern "C" {
+#include "ownet.h"
+#include "findtype.h"
+#include "temp10.h"
+#include "temp28.h"
+#include "temp42.h"
+#include "sockit_owm_host.h"
+}
+
+#define MAXDEVICES  20
+
+static alt_u32 model_rd (void *ctx, int reg)
+{
+  return ((sockit_owm_model *) ctx)->read (reg);
+}
+
+static void model_wr (void *ctx, int reg, alt_u32 dat)
+{
+  ((sockit_owm_model *) ctx)->write (reg, dat);
+}
+
+int main (int argc, char **argv)
+{
+  // default network: one device of each supported family
+  static const int family[] = {OWSLAVE_DS18S20, OWSLAVE_DS18B20, OWSLAVE_DS28EA00};
+  int num = (argc > 1) ? atoi (argv[1]) : 3;
+  int parasite = (argc > 2) ? atoi (argv[2]) : 0;
+  uchar sn[MAXDEVICES][8];
+  float temp;
+  int i, n, err = 0;
+  clock_t wall;
+
+  Verilated::commandArgs (argc, argv);
+
+  sockit_owm_model model;
+  std::vector<owslave> dev (num);
+  for (i=0; i<num; i++) {
+    owslave_init (&dev[i], family[i % 3], 0x1000 + i, parasite);
+    dev[i].temp = (20 << 4) + 8*i;
+    model.port (0).attach (&dev[i]);
+  }
+
+  sockit_owm_host host = {model_rd, model_wr, &model};
+  sockit_owm_host_init (&host);
+
+  wall = clock ();
+
+  if (!owAcquire (0, NULL)) {
+    printf ("ERROR: acquire failed\n");
+    return 1;
+  }
+  n  = FindDevices (0, &sn[0], OWSLAVE_DS18S20,  MAXDEVICES);
+  n += FindDevices (0, &sn[n], OWSLAVE_DS18B20,  MAXDEVICES-n);
+  n += FindDevices (0, &sn[n], OWSLAVE_DS28EA00, MAXDEVICES-n);
+  printf ("found %d of %d devices, %.3f ms\n", n, num, model.time () / 1.0e6);
+  if (n != num && n < MAXDEVICES-1)  err++;
+
+  for (i=0; i<n; i++) {
+    int ok = 0;
+    if (sn[i][0] == OWSLAVE_DS18S20 )  ok = ReadTemperature10 (0, sn[i], &temp);
+    if (sn[i][0] == OWSLAVE_DS18B20 )  ok = ReadTemperature28 (0, sn[i], &temp);
+    if (sn[i][0] == OWSLAVE_DS28EA00)  ok = ReadTemperature42 (0, sn[i], &temp);
+    printf ("%02X%02X%02X%02X%02X%02X%02X%02X ",
+            sn[i][7], sn[i][6], sn[i][5], sn[i][4], sn[i][3], sn[i][2], sn[i][1], sn[i][0]);
+    if (!ok) {
+      printf ("ERROR: read failed\n");
+      err++;
+      continue;
+    }
+    printf ("%7.3f Celsius, %.3f ms\n", temp, model.time () / 1.0e6);
+    // compare against the temperature given to the device model
+    if (temp != dev[(sn[i][1] | (sn[i][2] << 8)) - 0x1000].temp / 16.0) {
+      printf ("ERROR: temperature mismatch\n");
+      err++;
+    }
+  }
+  owRelease (0);
+
+  wall = clock () - wall;
+  printf ("simulated %.3f ms in %llu clock cycles, %.0f cycles/s\n",
+          model.time () / 1.0e6, (unsigned long long) model.cycles (),
+          model.cycles () / ((double) (wall ? wall : 1) / CLOCKS_PER_SEC));
+  return err ? 1 : 0;
+}
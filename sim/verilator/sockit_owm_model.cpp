@@ -0,0 +1,212 @@
+//////////////////////////////////////////////////////////////////////////////
+//                                                                          //
+//  Minimalistic 1-wire (onewire) master with Avalon MM bus interface       //
+//                                                                          //
+//  Copyright (C) 2010  Iztok Jeras                                         //
+//                                                                          //
+//////////////////////////////////////////////////////////////////////////////
+//                                                                          //
+//  This program is free software: you can redistribute it and/or modify    //
+//  it under the terms of the GNU Lesser General Public License             //
+//  as published by the Free Software Foundation, either                    //
+//  version 3 of the License, or (at your option) any later version.        //
+//                                                                          //
+//  This program is distributed in the hope that it will be useful,         //
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of          //
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the           //
+//  GNU General Public License for more details.                            //
+//                                                                          //
+//  You should have received a copy of the GNU General Public License       //
+//  along with this program.  If not, see <http://www.gnu.org/licenses/>.   //
+//                                                                          //
+//////////////////////////////////////////////////////////////////////////////
+
+
+
+#include "Vsockit_owm.h"
+#include "verilated.h"
+
+#include "sockit_owm_model.h"
+
+// device timing [ns] (standard and overdrive speed)
+#define OWBUS_TS_N    30000  // sampling point after the falling edge
+#define OWBUS_TS_O     3000
+#define OWBUS_TD_N    45000  // end of a device '0' pull-down
+#define OWBUS_TD_O     5000
+#define OWBUS_RST_N  240000  // minimum reset pulse
+#define OWBUS_RST_O   30000
+#define OWBUS_PDH_N   30000  // presence pulse start after the reset pulse
+#define OWBUS_PDH_O    3000
+#define OWBUS_PDL_N  120000  // presence pulse length
+#define OWBUS_PDL_O   12000
+
+//////////////////////////////////////////////////////////////////////////////
+// behavioural 1-wire bus
+//////////////////////////////////////////////////////////////////////////////
+
+owbus::owbus () :
+  mst (0), pwr (0), t_fall (0), slot_o (0), t_smp_n (0), t_smp_o (0), t_pul (0), t_prs (0), t_prs_end (0)
+{
+}
+
+void owbus::attach (owslave *s)
+{
+  slaves.push_back (s);
+}
+
+// falling edge of a time slot, devices decide what to drive
+void owbus::slot (uint64_t t)
+{
+  int n = 0, o = 0;
+
+  t_fall = t;
+  for (size_t i=0; i<slaves.size (); i++) {
+    owslave *s = slaves[i];
+    if (!s->present)  continue;
+    if (s->ovd)  o = 1;
+    else         n = 1;
+    if (!owslave_drive (s, t)) {
+      uint64_t t_end = t + (s->ovd ? OWBUS_TD_O : OWBUS_TD_N);
+      if (t_pul < t_end)  t_pul = t_end;
+    }
+  }
+  slot_o  = o;
+  t_smp_n = n ? t + OWBUS_TS_N : 0;
+  t_smp_o = o ? t + OWBUS_TS_O : 0;
+}
+
+// devices sample the line
+void owbus::sample (uint64_t t, int ovd, int line)
+{
+  for (size_t i=0; i<slaves.size (); i++) {
+    owslave *s = slaves[i];
+    if (s->present && (s->ovd == ovd))  owslave_sample (s, line, t);
+  }
+}
+
+// end of a reset pulse, devices respond with a presence pulse
+void owbus::reset (uint64_t t, int ovd)
+{
+  int prs = 0;
+
+  for (size_t i=0; i<slaves.size (); i++)
+    prs |= owslave_reset (slaves[i], ovd, t);
+  if (prs) {
+    t_prs     = t     + (ovd ? OWBUS_PDH_O : OWBUS_PDH_N);
+    t_prs_end = t_prs + (ovd ? OWBUS_PDL_O : OWBUS_PDL_N);
+  }
+}
+
+int owbus::update (uint64_t t, int e, int p)
+{
+  int line;
+
+  // strong pull-up changes are reported to all devices
+  if (p != pwr) {
+    for (size_t i=0; i<slaves.size (); i++)
+      owslave_power (slaves[i], p, t);
+    pwr = p;
+  }
+
+  // master starts a time slot or a reset pulse
+  if (e && !mst)  slot (t);
+
+  // sampling points
+  line = !(e || (t < t_pul));
+  if (t_smp_o && (t >= t_smp_o)) {
+    sample (t, 1, line);
+    t_smp_o = 0;
+  }
+  if (t_smp_n && (t >= t_smp_n)) {
+    sample (t, 0, line);
+    t_smp_n = 0;
+  }
+
+  // master releases the line, long pulses are reset pulses (devices
+  // switching to overdrive during this slot do not see an overdrive reset)
+  if (!e && mst) {
+    if      (t - t_fall >= OWBUS_RST_N)            reset (t, 0);
+    else if (t - t_fall >= OWBUS_RST_O && slot_o)  reset (t, 1);
+  }
+  mst = e;
+
+  if (e)  return 0;
+  if (p)  return 1;
+  return !((t < t_pul) || ((t >= t_prs) && (t < t_prs_end)));
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// RTL model
+//////////////////////////////////////////////////////////////////////////////
+
+sockit_owm_model::sockit_owm_model (unsigned own, double f_clk) :
+  bus (own), t_clk (1.0e9 / f_clk), cyc (0)
+{
+  top = new Vsockit_owm;
+  top->clk     = 0;
+  top->bus_ren = 0;
+  top->bus_wen = 0;
+  top->bus_adr = 0;
+  top->bus_wdt = 0;
+  top->owr_i   = (1 << own) - 1;
+  // synchronous reset
+  top->rst     = 1;
+  clock (2);
+  top->rst     = 0;
+  cyc = 0;
+}
+
+sockit_owm_model::~sockit_owm_model ()
+{
+  top->final ();
+  delete top;
+}
+
+// a single clock period, the 1-wire lines are updated after the rising edge
+void sockit_owm_model::tick ()
+{
+  uint32_t owr_i = 0;
+  uint64_t t;
+
+  top->clk = 1;
+  top->eval ();
+  cyc++;
+  t = time ();
+  for (size_t n=0; n<bus.size (); n++)
+    owr_i |= bus[n].update (t, (top->owr_e >> n) & 1, (top->owr_p >> n) & 1) << n;
+  top->owr_i = owr_i;
+  top->clk = 0;
+  top->eval ();
+}
+
+void sockit_owm_model::clock (uint64_t n)
+{
+  while (n--)  tick ();
+}
+
+uint32_t sockit_owm_model::read (unsigned adr)
+{
+  uint32_t dat;
+
+  top->bus_ren = 1;
+  top->bus_adr = adr;
+  top->eval ();
+  dat = top->bus_rdt;
+  tick ();
+  top->bus_ren = 0;
+  return dat;
+}
+
+void sockit_owm_model::write (unsigned adr, uint32_t dat)
+{
+  top->bus_wen = 1;
+  top->bus_adr = adr;
+  top->bus_wdt = dat;
+  tick ();
+  top->bus_wen = 0;
+}
+
+int sockit_owm_model::irq ()
+{
+  return top->bus_irq;
+}
@@ -0,0 +1,118 @@
+//////////////////////////////////////////////////////////////////////////////
+//                                                                          //
+//  Minimalistic 1-wire (onewire) master with Avalon MM bus interface       //
+//                                                                          //
+//  Copyright (C) 2010  Iztok Jeras                                         //
+//                                                                          //
+//////////////////////////////////////////////////////////////////////////////
+//                                                                          //
+//  This program is free software: you can redistribute it and/or modify    //
+//  it under the terms of the GNU Lesser General Public License             //
+//  as published by the Free Software Foundation, either                    //
+//  version 3 of the License, or (at your option) any later version.        //
+//                                                                          //
+//  This program is distributed in the hope that it will be useful,         //
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of          //
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the           //
+//  GNU General Public License for more details.                            //
+//                                                                          //
+//  You should have received a copy of the GNU General Public License       //
+//  along with this program.  If not, see <http://www.gnu.org/licenses/>.   //
+//                                                                          //
+//////////////////////////////////////////////////////////////////////////////
+
+
+
+//////////////////////////////////////////////////////////////////////////////
+//                                                                          //
+// Cycle accurate C++ model of sockit_owm (Verilator)                       //
+//                                                                          //
+// sockit_owm_model wraps the verilated RTL, every Avalon MM transfer       //
+// takes a single clock period. Each 1-wire port is connected to an owbus,  //
+// a behavioural wired-AND bus with any number of slave devices (owslave). //
+// The bus only does work on line edges and scheduled sampling points, so   //
+// a clock period costs little more than the RTL evaluation.                //
+//                                                                          //
+//////////////////////////////////////////////////////////////////////////////
+
+#ifndef __SOCKIT_OWM_MODEL_H__
+#define __SOCKIT_OWM_MODEL_H__
+
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+extern "C" {
+#include "owslave.h"
+}
+
+class Vsockit_owm;
+
+//////////////////////////////////////////////////////////////////////////////
+// behavioural 1-wire bus
+//////////////////////////////////////////////////////////////////////////////
+
+class owbus
+{
+ public:
+  owbus ();
+
+  // connect a device
+  void     attach (owslave *s);
+  // line level for the given time and master outputs (pull-down, power)
+  int      update (uint64_t t, int e, int p);
+  // connected devices
+  std::vector<owslave*> slaves;
+
+ private:
+  int      mst;         // master pull-down in the previous update
+  int      pwr;         // strong pull-up in the previous update
+  uint64_t t_fall;      // start of the current master pull-down
+  int      slot_o;      // overdrive speed devices were present at the slot start
+  uint64_t t_smp_n;     // pending sampling point for standard speed devices
+  uint64_t t_smp_o;     // pending sampling point for overdrive speed devices
+  uint64_t t_pul;       // end of a device pull-down
+  uint64_t t_prs;       // start of a presence pulse
+  uint64_t t_prs_end;   // end of a presence pulse
+
+  void     slot   (uint64_t t);
+  void     sample (uint64_t t, int ovd, int line);
+  void     reset  (uint64_t t, int ovd);
+};
+
+//////////////////////////////////////////////////////////////////////////////
+// RTL model
+//////////////////////////////////////////////////////////////////////////////
+
+class sockit_owm_model
+{
+ public:
+  // clock frequency must match the RTL CDR_N/CDR_O parameters
+  sockit_owm_model (unsigned own = 1, double f_clk = 1.0e6);
+  ~sockit_owm_model ();
+
+  // single Avalon MM transfers (one clock period each)
+  uint32_t read  (unsigned adr);
+  void     write (unsigned adr, uint32_t dat);
+  // interrupt request line
+  int      irq   ();
+  // advance time by the given number of clock periods
+  void     clock (uint64_t n = 1);
+
+  // elapsed clock periods and simulated time in nanoseconds
+  uint64_t cycles () const { return cyc; }
+  uint64_t time   () const { return (uint64_t) (cyc * t_clk); }
+
+  // 1-wire bus connected to the given port
+  owbus&   port (unsigned n) { return bus[n]; }
+
+ private:
+  Vsockit_owm*       top;
+  std::vector<owbus> bus;
+  double             t_clk;  // clock period [ns]
+  uint64_t           cyc;    // clock counter
+
+  void     tick ();
+};
+
+#endif // __SOCKIT_OWM_MODEL_H__
@@ -26,7 +26,7 @@ package require -exact sopc 10.0
 
 # module sockit_owm
 set_module_property NAME         sockit_owm
-set_module_property VERSION      1.3
+set_module_property VERSION      1.4
 set_module_property GROUP        "Interface Protocols/Serial"
 set_module_property DISPLAY_NAME "1-wire (onewire) master"
 set_module_property DESCRIPTION  "1-wire (onewire) master"
@@ -64,6 +64,21 @@ set_parameter_property CDR_E UNITS None
 set_parameter_property CDR_E AFFECTS_GENERATION false
 set_parameter_property CDR_E HDL_PARAMETER true
 
+add_parameter PRG_E BOOLEAN
+set_parameter_property PRG_E DESCRIPTION "Implementation of the program engine, which executes short 1-wire programs stored in a small on-chip memory."
+set_parameter_property PRG_E DEFAULT_VALUE 0
+set_parameter_property PRG_E UNITS None
+set_parameter_property PRG_E AFFECTS_GENERATION false
+set_parameter_property PRG_E HDL_PARAMETER true
+
+add_parameter PAW INTEGER
+set_parameter_property PAW DESCRIPTION "Program engine memory address width (memory size is 2**PAW bytes)"
+set_parameter_property PAW DEFAULT_VALUE 6
+set_parameter_property PAW ALLOWED_RANGES {4 5 6 7 8}
+set_parameter_property PAW UNITS bits
+set_parameter_property PAW AFFECTS_GENERATION false
+set_parameter_property PAW HDL_PARAMETER true
+
 add_parameter BDW INTEGER
 set_parameter_property BDW DESCRIPTION "CPU interface data bus width"
 set_parameter_property BDW VISIBLE false
@@ -78,6 +93,7 @@ add_parameter BAW INTEGER
 set_parameter_property BAW DESCRIPTION "CPU interface address bus width"
 set_parameter_property BAW VISIBLE false
 set_parameter_property BAW DEFAULT_VALUE 1
+set_parameter_property BAW DERIVED true
 set_parameter_property BAW ALLOWED_RANGES {1 2}
 set_parameter_property BAW UNITS bits
 set_parameter_property BAW ENABLED false
@@ -204,6 +220,10 @@ proc validation_callback {} {
   set btp_o [get_parameter_value BTP_O]
   # enable/disable editing of overdrive divider
   set_parameter_property BTP_O ENABLED [expr {$ovd_e ? "true" : "false"}]
+  # program engine registers extend the address space
+  set prg_e [get_parameter_value PRG_E]
+  set_parameter_property PAW ENABLED [expr {$prg_e ? "true" : "false"}]
+  set_parameter_value BAW [expr {$prg_e ? 2 : 1}]
   # compute normal mode divider
   if {$btp_n=="5.0"} {
     set d_n [expr {$f/200000}]
@@ -256,6 +276,8 @@ proc elaboration_callback {} {
   set_module_assignment embeddedsw.CMacro.OWN          [get_parameter_value OWN  ]
   set_module_assignment embeddedsw.CMacro.CDR_E [expr {[get_parameter_value CDR_E]?1:0}]
   set_module_assignment embeddedsw.CMacro.OVD_E [expr {[get_parameter_value OVD_E]?1:0}]
+  set_module_assignment embeddedsw.CMacro.PRG_E [expr {[get_parameter_value PRG_E]?1:0}]
+  set_module_assignment embeddedsw.CMacro.PAW          [get_parameter_value PAW  ]
   set_module_assignment embeddedsw.CMacro.BTP_N      \"[get_parameter_value BTP_N]\"
   set_module_assignment embeddedsw.CMacro.BTP_O      \"[get_parameter_value BTP_O]\"
   set_module_assignment embeddedsw.CMacro.CDR_N        [get_parameter_value CDR_N]
@@ -28,10 +28,10 @@ create_driver sockit_owm_driver
 set_sw_property hw_class_name sockit_owm
 
 # Driver version
-set_sw_property version 1.3
+set_sw_property version 1.4
 
-# This driver is compatible with version 1.3 and above
-set_sw_property min_compatible_hw_version 1.3
+# This driver is compatible with version 1.4 and above
+set_sw_property min_compatible_hw_version 1.4
 
 # Interrupt properties
 set_sw_property isr_preemption_supported true
@@ -49,19 +49,30 @@ add_sw_property       c_source HAL/src/ownet.c
 add_sw_property       c_source HAL/src/owtran.c
 add_sw_property       c_source HAL/src/owlnk.c
 add_sw_property       c_source HAL/src/owses.c
+add_sw_property       c_source HAL/src/sockit_owm_prg.c
+add_sw_property       c_source HAL/src/sockit_owm_async.c
 
 # Include files
 add_sw_property include_source inc/sockit_owm_regs.h
 add_sw_property include_source HAL/inc/sockit_owm.h
 add_sw_property include_source HAL/inc/ownet.h
+add_sw_property include_source HAL/inc/sockit_owm_prg.h
+add_sw_property include_source HAL/inc/sockit_owm_lnk.h
+add_sw_property include_source HAL/inc/sockit_owm_async.h
 
 # Common files
 add_sw_property       c_source HAL/src/owerr.c
 add_sw_property       c_source HAL/src/crcutil.c
 add_sw_property include_source HAL/inc/findtype.h
 add_sw_property       c_source HAL/src/findtype.c
+add_sw_property include_source HAL/inc/owenum.h
+add_sw_property       c_source HAL/src/owenum.c
+add_sw_property include_source HAL/inc/owdev.h
+add_sw_property       c_source HAL/src/owdev.c
 
 # device files (thermometer)
+add_sw_property include_source HAL/inc/owtemp.h
+add_sw_property       c_source HAL/src/owtemp.c
 add_sw_property include_source HAL/inc/temp10.h
 add_sw_property       c_source HAL/src/temp10.c
 add_sw_property include_source HAL/inc/temp28.h
@@ -76,6 +87,10 @@ add_sw_property supported_bsp_type UCOSII
 # Driver configuration options
 add_sw_setting boolean_define_only public_mk_define polling_driver_enable  SOCKIT_OWM_POLLING    true "Small-footprint (polled mode) driver"
 add_sw_setting boolean_define_only public_mk_define hardware_delay_enable  SOCKIT_OWM_HW_DLY     true "Mili second delay implemented in hardware"
+add_sw_setting boolean_define_only public_mk_define single_port_enable     SOCKIT_OWM_SINGLE     false "Single instance with a single 1-wire port (port map resolved at compile time)"
+add_sw_setting boolean_define_only public_mk_define inline_link_enable     SOCKIT_OWM_INLINE     false "Inline link layer primitives into the network and device layers"
+add_sw_setting decimal_number     public_mk_define spin_threshold         SOCKIT_OWM_SPIN       100  "Cycles shorter than this (in us) are polled by the interrupt driven driver"
+add_sw_setting decimal_number     public_mk_define temp_poll_interval     SOCKIT_OWM_TEMP_POLL  10   "Temperature conversion complete poll interval (in ms)"
 add_sw_setting boolean_define_only public_mk_define error_detection_enable SOCKIT_OWM_ERR_ENABLE true "Implement error detection support"
 add_sw_setting boolean_define_only public_mk_define error_detection_small  SOCKIT_OWM_ERR_SMALL  true "Reduced memory consumption for error detection"
 